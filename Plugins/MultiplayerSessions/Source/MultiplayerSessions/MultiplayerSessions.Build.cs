@@ -28,6 +28,7 @@ public class MultiplayerSessions : ModuleRules
 				"Core",
 				"OnlineSubsystem",
 				"OnlineSubsystemSteam",
+				"OnlineSubsystemUtils",
 				"UMG",
 				"Slate",
 				"SlateCore"
@@ -43,6 +44,9 @@ public class MultiplayerSessions : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
+				"Sockets",
+				"Networking",
+				"Projects",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -4,10 +4,11 @@
 #include "Menu.h"
 #include "Components/Button.h"
 #include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerMatchmaker.h"
 #include "OnlineSessionSettings.h"
 #include "OnlineSubsystem.h"
 
-void UMenu::MenuSetup(int32 NumberOfPublicConnections, FString TypeOfMatch, FString LobbyPath)
+void UMenu::MenuSetup(int32 NumberOfPublicConnections, FString TypeOfMatch, FString LobbyPath, bool bSpeculativeHost)
 {
 	m_NumPublicConnections = NumberOfPublicConnections;
 	m_Matchtype = TypeOfMatch;
@@ -42,13 +43,21 @@ void UMenu::MenuSetup(int32 NumberOfPublicConnections, FString TypeOfMatch, FStr
 		m_MultiplayerSessionsSubsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
 	}
 
-	if (m_MultiplayerSessionsSubsystem)
+	if (m_MultiplayerSessionsSubsystem.IsValid())
 	{
+		// MenuSetup이 여러번 호출되어도 콜백이 중복으로 바인딩되지 않도록 먼저 해제
+		UnbindSubsystemDelegates();
+
 		m_MultiplayerSessionsSubsystem->MultiplayerOnCreateSessionComplete.AddDynamic(this, &ThisClass::OnCreateSession);
-		m_MultiplayerSessionsSubsystem->MultiplayerOnFindSessionComplete.AddUObject(this, &ThisClass::OnFindSession);
 		m_MultiplayerSessionsSubsystem->MultiplayerOnJoinSessionComplete.AddUObject(this, &ThisClass::OnJoinSession);
 		m_MultiplayerSessionsSubsystem->MultiplayerOnDestroySessionComplete.AddDynamic(this, &ThisClass::OnDestroySession);
 		m_MultiplayerSessionsSubsystem->MultiplayerOnStartSessionComplete.AddDynamic(this, &ThisClass::OnStartSession);
+		m_MultiplayerSessionsSubsystem->GetMatchmaker()->MultiplayerOnMatchmakingComplete.AddDynamic(this, &ThisClass::OnMatchmakingComplete);
+
+		if (bSpeculativeHost)
+		{
+			m_MultiplayerSessionsSubsystem->PrepareSpeculativeSession(m_NumPublicConnections, m_Matchtype);
+		}
 	}
 }
 
@@ -113,55 +122,19 @@ void UMenu::OnCreateSession(bool bWasSuccessful)
 	}
 }
 
-void UMenu::OnFindSession(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful)
-{
-	if (m_MultiplayerSessionsSubsystem == nullptr)
-		return;
-
-	for (auto Result : SessionResults)
-	{
-		FString SettingsValue;
-
-		// 위에서 저장한 MatchType의 키값으로 저장된 Value값을 MatchType이란 FString변수에 저장
-		Result.Session.SessionSettings.Get(FName("MatchType"), SettingsValue);
-		if (SettingsValue == m_Matchtype)
-		{
-			// 가입하고 싶은 세션을 찾았다는것
-			// 유효한 검색 결과를 찾았다면 계속 반복할 필요가 없다.
-			m_MultiplayerSessionsSubsystem->JoinSession(Result);
-			return;
-		}
-	}
-
-	if (!bWasSuccessful || SessionResults.Num() == 0)
-	{
-		JoinButton->SetIsEnabled(true);
-	}
-}
-
 void UMenu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
 {
-	IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
-
-	if (Subsystem)
+	if (Result != EOnJoinSessionCompleteResult::Success)
 	{
-		IOnlineSessionPtr SessionInterface = Subsystem->GetSessionInterface();
-		if (SessionInterface.IsValid())
-		{
-			FString Address;
-			SessionInterface->GetResolvedConnectString(NAME_GameSession, Address);
-
-			APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController();
-			if (PlayerController)
-			{
-				PlayerController->ClientTravel(Address, ETravelType::TRAVEL_Absolute);
-			}
-		}
+		JoinButton->SetIsEnabled(true);
+		return;
 	}
 
-	if (Result != EOnJoinSessionCompleteResult::Success)
+	// 서브시스템이 참가할때 저장해둔 접속 주소로 이동
+	FString Address;
+	if (m_MultiplayerSessionsSubsystem.IsValid() && m_MultiplayerSessionsSubsystem->GetLastConnectString(Address))
 	{
-		JoinButton->SetIsEnabled(true);
+		m_MultiplayerSessionsSubsystem->TravelToSession(Address);
 	}
 }
 
@@ -199,11 +172,19 @@ void UMenu::OnStartSession(bool bWasSuccessful)
 	}
 }
 
+void UMenu::OnMatchmakingComplete(bool bWasSuccessful)
+{
+	if (!bWasSuccessful)
+	{
+		JoinButton->SetIsEnabled(true);
+	}
+}
+
 void UMenu::HostButtonCliked()
 {
 	HostButton->SetIsEnabled(false);
 
-	if (m_MultiplayerSessionsSubsystem)
+	if (m_MultiplayerSessionsSubsystem.IsValid())
 	{
 		m_MultiplayerSessionsSubsystem->CreateSession(m_NumPublicConnections, m_Matchtype);
 	}
@@ -213,14 +194,27 @@ void UMenu::JoinButtonCliked()
 {
 	JoinButton->SetIsEnabled(false);
 
-	if (m_MultiplayerSessionsSubsystem)
+	if (m_MultiplayerSessionsSubsystem.IsValid())
 	{
-		m_MultiplayerSessionsSubsystem->FindSession(10000);
+		// 첫번째로 찾은 세션이 아니라 조건이 가장 잘 맞는 세션에 참가
+		FMultiplayerMatchmakingParams Params;
+		Params.MatchType = m_Matchtype;
+		m_MultiplayerSessionsSubsystem->GetMatchmaker()->StartMatchmaking(Params);
 	}
 }
 
 void UMenu::MenuTearDown()
 {
+	UnbindSubsystemDelegates();
+
+	// 메뉴가 닫히면 검색 결과를 더 볼 일이 없다.
+	// 호스트 버튼을 누르지 않고 닫혔다면 미리 만든 세션도 필요 없다. 광고를 켠 세션은 이미 미리 만든 세션이 아니다.
+	if (m_MultiplayerSessionsSubsystem.IsValid())
+	{
+		m_MultiplayerSessionsSubsystem->ReleaseSearchResults();
+		m_MultiplayerSessionsSubsystem->CancelSpeculativeSession();
+	}
+
 	RemoveFromParent();
 	UWorld* World = GetWorld();
 	if (World)
@@ -235,3 +229,18 @@ void UMenu::MenuTearDown()
 		}
 	}
 }
+
+void UMenu::UnbindSubsystemDelegates()
+{
+	if (!m_MultiplayerSessionsSubsystem.IsValid())
+		return;
+
+	m_MultiplayerSessionsSubsystem->MultiplayerOnCreateSessionComplete.RemoveAll(this);
+	m_MultiplayerSessionsSubsystem->MultiplayerOnJoinSessionComplete.RemoveAll(this);
+	m_MultiplayerSessionsSubsystem->MultiplayerOnDestroySessionComplete.RemoveAll(this);
+	m_MultiplayerSessionsSubsystem->MultiplayerOnStartSessionComplete.RemoveAll(this);
+	m_MultiplayerSessionsSubsystem->GetMatchmaker()->MultiplayerOnMatchmakingComplete.RemoveAll(this);
+
+	// 미리 만든 세션은 여기서 지우지 않는다. MenuSetup을 다시 호출할때도 불리기 때문에 지우면 호스트가 바로 되지 않는다.
+	// 메뉴가 닫힐때 MenuTearDown에서 취소한다.
+}
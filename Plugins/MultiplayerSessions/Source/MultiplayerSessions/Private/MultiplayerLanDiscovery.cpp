@@ -0,0 +1,309 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerLanDiscovery.h"
+#include "MultiplayerSessions.h"
+#include "Common/UdpSocketBuilder.h"
+#include "Engine/EngineBaseTypes.h"
+#include "IPAddress.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace MultiplayerLanBeacon
+{
+	// 다른 프로그램의 UDP 패킷과 구분하기 위한 값 ("MPSL")
+	constexpr uint32 Magic = 0x4D50534C;
+	constexpr uint8 Version = 1;
+	constexpr int32 MaxPacketSize = 512;
+	// 닉네임, 매치 타입 문자열의 최대 길이
+	constexpr int32 MaxStringLength = 64;
+
+	const TCHAR* ConfigSection = TEXT("MultiplayerSessions.LanDiscovery");
+}
+
+FMultiplayerLanDiscovery::FMultiplayerLanDiscovery()
+{
+	if (GConfig)
+	{
+		GConfig->GetInt(MultiplayerLanBeacon::ConfigSection, TEXT("Port"), m_Port, GGameIni);
+		GConfig->GetFloat(MultiplayerLanBeacon::ConfigSection, TEXT("BeaconInterval"), m_BeaconInterval, GGameIni);
+		GConfig->GetFloat(MultiplayerLanBeacon::ConfigSection, TEXT("SessionTimeout"), m_SessionTimeout, GGameIni);
+		GConfig->GetBool(MultiplayerLanBeacon::ConfigSection, TEXT("bBroadcastToLoopback"), m_bBroadcastToLoopback, GGameIni);
+	}
+
+	SetBeaconInterval(m_BeaconInterval);
+	m_InstanceId = FPlatformTime::Cycles() ^ FPlatformProcess::GetCurrentProcessId();
+}
+
+FMultiplayerLanDiscovery::~FMultiplayerLanDiscovery()
+{
+	StopBroadcasting();
+	StopListening();
+}
+
+bool FMultiplayerLanDiscovery::StartBroadcasting(const FMultiplayerLanSession& Session, int32 SessionInfo, int32 GamePort)
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (SocketSubsystem == nullptr)
+		return false;
+
+	if (m_BroadcastSocket == nullptr)
+	{
+		m_BroadcastSocket = FUdpSocketBuilder(TEXT("MultiplayerLanBeacon"))
+			.AsNonBlocking()
+			.AsReusable()
+			.WithBroadcast()
+			.Build();
+
+		if (m_BroadcastSocket == nullptr)
+		{
+			UE_LOG(LogMultiplayerSessions, Warning, TEXT("Failed to create LAN beacon socket"));
+			return false;
+		}
+
+		m_BroadcastAddr = SocketSubsystem->CreateInternetAddr();
+		m_BroadcastAddr->SetBroadcastAddress();
+		m_BroadcastAddr->SetPort(m_Port);
+
+		// 같은 PC에서 테스트할때를 위해 루프백으로도 보낸다.
+		m_LoopbackAddr = SocketSubsystem->CreateInternetAddr();
+		m_LoopbackAddr->SetLoopbackAddress();
+		m_LoopbackAddr->SetPort(m_Port);
+	}
+
+	m_BroadcastSession = Session;
+	m_BroadcastSessionInfo = SessionInfo;
+	m_BroadcastGamePort = GamePort;
+	BuildBeaconPacket();
+
+	// 다음 틱에 바로 첫 비콘을 보낸다.
+	m_LastBeaconTime = 0.0;
+	UpdateTicker();
+
+	return true;
+}
+
+void FMultiplayerLanDiscovery::UpdateBroadcast(int32 OpenSlots, int32 SessionInfo)
+{
+	if (m_BroadcastSession.OpenSlots == OpenSlots && m_BroadcastSessionInfo == SessionInfo)
+		return;
+
+	m_BroadcastSession.OpenSlots = OpenSlots;
+	m_BroadcastSessionInfo = SessionInfo;
+	BuildBeaconPacket();
+}
+
+void FMultiplayerLanDiscovery::StopBroadcasting()
+{
+	if (m_BroadcastSocket)
+	{
+		m_BroadcastSocket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(m_BroadcastSocket);
+		m_BroadcastSocket = nullptr;
+	}
+
+	UpdateTicker();
+}
+
+bool FMultiplayerLanDiscovery::StartListening()
+{
+	if (m_ListenSocket)
+		return true;
+
+	m_ListenSocket = FUdpSocketBuilder(TEXT("MultiplayerLanListener"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToPort(m_Port)
+		.WithReceiveBufferSize(64 * 1024)
+		.Build();
+
+	if (m_ListenSocket == nullptr)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Failed to bind LAN listener to port %d"), m_Port);
+		return false;
+	}
+
+	m_ReceiveBuffer.SetNumUninitialized(MultiplayerLanBeacon::MaxPacketSize);
+	UpdateTicker();
+
+	return true;
+}
+
+void FMultiplayerLanDiscovery::StopListening()
+{
+	if (m_ListenSocket)
+	{
+		m_ListenSocket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(m_ListenSocket);
+		m_ListenSocket = nullptr;
+	}
+
+	if (m_Sessions.Num() > 0)
+	{
+		m_Sessions.Reset();
+		OnLanSessionsChanged.Broadcast();
+	}
+
+	UpdateTicker();
+}
+
+bool FMultiplayerLanDiscovery::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	if (m_BroadcastSocket && Now - m_LastBeaconTime >= m_BeaconInterval)
+	{
+		SendBeacon();
+		m_LastBeaconTime = Now;
+	}
+
+	if (m_ListenSocket)
+	{
+		bool bChanged = ReceiveBeacons(Now);
+		bChanged |= ExpireSessions(Now);
+
+		if (bChanged)
+		{
+			OnLanSessionsChanged.Broadcast();
+		}
+	}
+
+	return true;
+}
+
+void FMultiplayerLanDiscovery::UpdateTicker()
+{
+	const bool bNeedsTick = m_BroadcastSocket != nullptr || m_ListenSocket != nullptr;
+
+	if (bNeedsTick && !m_TickerHandle.IsValid())
+	{
+		m_TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FMultiplayerLanDiscovery::Tick));
+	}
+	else if (!bNeedsTick && m_TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(m_TickerHandle);
+		m_TickerHandle.Reset();
+	}
+}
+
+void FMultiplayerLanDiscovery::BuildBeaconPacket()
+{
+	uint32 Magic = MultiplayerLanBeacon::Magic;
+	uint8 Version = MultiplayerLanBeacon::Version;
+	int32 GamePort = m_BroadcastGamePort;
+
+	// Custom 매치 타입일때만 문자열을 보낸다.
+	FString CustomMatchType;
+	if (FMultiplayerSessionInfo::Unpack(m_BroadcastSessionInfo).MatchType == EMultiplayerMatchType::Custom)
+	{
+		CustomMatchType = m_BroadcastSession.MatchType.Left(MultiplayerLanBeacon::MaxStringLength);
+	}
+	// 받는 쪽에서 긴 문자열은 버리기 때문에 미리 자른다.
+	FString OwnerName = m_BroadcastSession.OwnerName.Left(MultiplayerLanBeacon::MaxStringLength);
+
+	m_BeaconPacket.Reset();
+	FMemoryWriter Writer(m_BeaconPacket);
+	Writer << Magic;
+	Writer << Version;
+	Writer << m_InstanceId;
+	Writer << GamePort;
+	Writer << m_BroadcastSessionInfo;
+	Writer << m_BroadcastSession.OpenSlots;
+	Writer << m_BroadcastSession.NumPublicConnections;
+	Writer << OwnerName;
+	Writer << CustomMatchType;
+}
+
+void FMultiplayerLanDiscovery::SendBeacon()
+{
+	int32 BytesSent = 0;
+	m_BroadcastSocket->SendTo(m_BeaconPacket.GetData(), m_BeaconPacket.Num(), BytesSent, *m_BroadcastAddr);
+
+	if (m_bBroadcastToLoopback)
+	{
+		m_BroadcastSocket->SendTo(m_BeaconPacket.GetData(), m_BeaconPacket.Num(), BytesSent, *m_LoopbackAddr);
+	}
+}
+
+bool FMultiplayerLanDiscovery::ReceiveBeacons(double Now)
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	TSharedRef<FInternetAddr> Sender = SocketSubsystem->CreateInternetAddr();
+
+	bool bChanged = false;
+	uint32 PendingSize = 0;
+
+	while (m_ListenSocket->HasPendingData(PendingSize))
+	{
+		int32 BytesRead = 0;
+		if (!m_ListenSocket->RecvFrom(m_ReceiveBuffer.GetData(), m_ReceiveBuffer.Num(), BytesRead, *Sender))
+			break;
+
+		// 문자열 길이는 보낸 쪽이 마음대로 적을 수 있으므로 패킷 크기 이상은 읽지 않는다.
+		FMemoryReaderView Reader(MakeArrayView(m_ReceiveBuffer.GetData(), BytesRead));
+		Reader.ArMaxSerializeSize = MultiplayerLanBeacon::MaxPacketSize;
+
+		uint32 Magic = 0;
+		uint8 Version = 0;
+		uint32 InstanceId = 0;
+		Reader << Magic;
+		Reader << Version;
+		Reader << InstanceId;
+
+		// 다른 버전이나 자기 자신이 보낸 비콘은 무시
+		if (Reader.IsError() || Magic != MultiplayerLanBeacon::Magic || Version != MultiplayerLanBeacon::Version || InstanceId == m_InstanceId)
+			continue;
+
+		int32 GamePort = 0;
+		int32 SessionInfo = 0;
+		FMultiplayerLanSession Session;
+		FString CustomMatchType;
+		Reader << GamePort;
+		Reader << SessionInfo;
+		Reader << Session.OpenSlots;
+		Reader << Session.NumPublicConnections;
+		Reader << Session.OwnerName;
+		Reader << CustomMatchType;
+
+		if (Reader.IsError())
+			continue;
+
+		if (Session.OwnerName.Len() > MultiplayerLanBeacon::MaxStringLength || CustomMatchType.Len() > MultiplayerLanBeacon::MaxStringLength)
+			continue;
+
+		const EMultiplayerMatchType MatchType = FMultiplayerSessionInfo::Unpack(SessionInfo).MatchType;
+		Session.MatchType = MatchType == EMultiplayerMatchType::Custom ? CustomMatchType : FMultiplayerSessionInfo::MatchTypeToString(MatchType);
+		Session.ConnectAddress = FString::Printf(TEXT("%s:%d"), *Sender->ToString(false), GamePort);
+		Session.LastSeenTime = Now;
+
+		const FMultiplayerLanSession* Existing = m_Sessions.Find(Session.ConnectAddress);
+		if (Existing == nullptr || Existing->OpenSlots != Session.OpenSlots || Existing->MatchType != Session.MatchType)
+		{
+			bChanged = true;
+		}
+
+		m_Sessions.Add(Session.ConnectAddress, Session);
+	}
+
+	return bChanged;
+}
+
+bool FMultiplayerLanDiscovery::ExpireSessions(double Now)
+{
+	bool bChanged = false;
+
+	// 일정 시간 비콘이 오지 않으면 호스트가 사라진 것으로 본다.
+	for (auto It = m_Sessions.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value().LastSeenTime > m_SessionTimeout)
+		{
+			It.RemoveCurrent();
+			bChanged = true;
+		}
+	}
+
+	return bChanged;
+}
@@ -0,0 +1,443 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerMatchmaker.h"
+#include "MultiplayerSessions.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSearchResultProcessor.h"
+#include "OnlineSessionSettings.h"
+#include "Engine/GameInstance.h"
+#include "TimerManager.h"
+#include "UObject/UObjectGlobals.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+namespace
+{
+	FAutoConsoleCommand MatchmakingBenchmarkCommand(
+		TEXT("MultiplayerSessions.MatchmakingBenchmark"),
+		TEXT("Matches simulated players against a synthetic session list and reports time-to-match and match quality. Usage: MultiplayerSessions.MatchmakingBenchmark [Players] [Sessions] [Seed]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 NumPlayers = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+			const int32 NumSessions = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 2000;
+			const int32 Seed = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 1;
+
+			UMultiplayerMatchmaker::RunBenchmark(NumPlayers, NumSessions, Seed);
+		}));
+
+	// 정렬된 값에서 백분위수
+	template<typename ValueType>
+	ValueType SortedPercentile(const TArray<ValueType>& SortedValues, float Percent)
+	{
+		if (SortedValues.Num() == 0)
+			return ValueType();
+
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Percent / 100.f * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+		return SortedValues[Index];
+	}
+}
+
+void UMultiplayerMatchmaker::Initialize(UMultiplayerSessionsSubsystem* Subsystem)
+{
+	m_Subsystem = Subsystem;
+
+	if (m_Subsystem.IsValid())
+	{
+		m_JoinSessionCompleteDelegateHandle = m_Subsystem->MultiplayerOnJoinSessionComplete.AddUObject(this, &ThisClass::OnJoinSessionComplete);
+		m_JoinRejectedDelegateHandle = m_Subsystem->MultiplayerOnJoinRejected.AddUObject(this, &ThisClass::OnJoinRejected);
+	}
+	m_PostLoadMapDelegateHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMap);
+}
+
+void UMultiplayerMatchmaker::BeginDestroy()
+{
+	if (m_Subsystem.IsValid())
+	{
+		m_Subsystem->MultiplayerOnJoinSessionComplete.Remove(m_JoinSessionCompleteDelegateHandle);
+		m_Subsystem->MultiplayerOnJoinRejected.Remove(m_JoinRejectedDelegateHandle);
+	}
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(m_PostLoadMapDelegateHandle);
+
+	Super::BeginDestroy();
+}
+
+void UMultiplayerMatchmaker::StartMatchmaking(const FMultiplayerMatchmakingParams& Params)
+{
+	if (!m_Subsystem.IsValid())
+	{
+		MultiplayerOnMatchmakingComplete.Broadcast(false);
+		return;
+	}
+
+	// 이전 매치메이킹에서 남은 후보도 버린다.
+	CancelMatchmaking();
+
+	m_Params = Params;
+	++m_SearchSerial;
+	m_StartTime = FPlatformTime::Seconds();
+	m_bMatchmaking = true;
+
+	// 호스트가 되었을때도 같은 조건으로 광고되도록 프로필을 맞춰둔다.
+	m_Subsystem->SetMatchmakingProfile(m_Params.Skill, m_Params.Region);
+
+	m_FindSessionCompleteDelegateHandle = m_Subsystem->MultiplayerOnFindSessionComplete.AddUObject(this, &ThisClass::OnFindSessionComplete);
+
+	// 예산은 검색 결과를 받을때도 확인하지만 응답이 사라지면 그 확인이 돌지 않는다.
+	if (UGameInstance* GameInstance = m_Subsystem->GetGameInstance())
+	{
+		GameInstance->GetTimerManager().SetTimer(m_TimeBudgetTimerHandle, this, &ThisClass::OnTimeBudgetExpired, FMath::Max(m_Params.TimeBudget, 0.01f), false);
+	}
+
+	RunSearch();
+}
+
+void UMultiplayerMatchmaker::CancelMatchmaking()
+{
+	// 이미 요청한 참가는 서브시스템이 끝낸다. 그 결과로 다음 후보를 시도하지 않도록 후보를 버린다.
+	m_bAwaitingJoin = false;
+	m_bAwaitingAdmission = false;
+	m_FallbackResults.Empty();
+
+	StopSearch();
+}
+
+void UMultiplayerMatchmaker::StopSearch()
+{
+	if (!m_bMatchmaking)
+		return;
+
+	if (m_Subsystem.IsValid())
+	{
+		m_Subsystem->MultiplayerOnFindSessionComplete.Remove(m_FindSessionCompleteDelegateHandle);
+
+		UGameInstance* GameInstance = m_Subsystem->GetGameInstance();
+		if (GameInstance)
+		{
+			GameInstance->GetTimerManager().ClearTimer(m_SearchTimerHandle);
+			GameInstance->GetTimerManager().ClearTimer(m_TimeBudgetTimerHandle);
+		}
+	}
+
+	m_bMatchmaking = false;
+	++m_SearchSerial;
+}
+
+void UMultiplayerMatchmaker::RunSearch()
+{
+	if (!m_bMatchmaking || !m_Subsystem.IsValid())
+		return;
+
+	m_Subsystem->FindSession(m_Params.MaxSearchResults);
+}
+
+void UMultiplayerMatchmaker::OnFindSessionComplete(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful)
+{
+	if (!m_bMatchmaking || !m_Subsystem.IsValid())
+		return;
+
+	const double Elapsed = FPlatformTime::Seconds() - m_StartTime;
+	int32 SkillTolerance = 0;
+	FMultiplayerSearchResultProcessor::FFilterAndScore FilterAndScore = MakeFilterAndScore(m_Params, Elapsed, SkillTolerance);
+
+	TSharedPtr<const FOnlineSessionSearch> Search = m_Subsystem->GetLastSessionSearch();
+	if (!Search.IsValid())
+	{
+		Search = MakeShared<FOnlineSessionSearch>();
+	}
+
+	TWeakObjectPtr<UMultiplayerMatchmaker> WeakThis(this);
+	const uint32 SearchSerial = m_SearchSerial;
+
+	FMultiplayerSearchResultProcessor::ProcessAsync(Search.ToSharedRef(), MoveTemp(FilterAndScore),
+		[WeakThis, SearchSerial, SkillTolerance](TSharedRef<const FOnlineSessionSearch> ProcessedSearch, TArray<FMultiplayerDecodedResult>&& SortedResults)
+		{
+			if (WeakThis.IsValid())
+			{
+				WeakThis->OnSearchResultsProcessed(ProcessedSearch, MoveTemp(SortedResults), SearchSerial, SkillTolerance);
+			}
+		});
+}
+
+void UMultiplayerMatchmaker::OnSearchResultsProcessed(TSharedRef<const FOnlineSessionSearch> Search, TArray<FMultiplayerDecodedResult>&& SortedResults, uint32 SearchSerial, int32 SkillTolerance)
+{
+	// 처리하는 동안 취소되었거나 새로 시작했다면 버린다.
+	if (!m_bMatchmaking || SearchSerial != m_SearchSerial || !m_Subsystem.IsValid())
+		return;
+
+	const double Elapsed = FPlatformTime::Seconds() - m_StartTime;
+
+	if (SortedResults.Num() > 0 && Search->SearchResults.IsValidIndex(SortedResults[0].ResultIndex))
+	{
+		const FMultiplayerDecodedResult& Best = SortedResults[0];
+
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Matchmaking found a session in %.2fs (quality %.2f, skill delta %d, ping %dms, tolerance %d)"),
+			Elapsed, Best.Score, FMath::Abs(Best.Skill - m_Params.Skill), Best.PingInMs, SkillTolerance);
+
+		const FOnlineSessionSearchResult BestResult = Search->SearchResults[Best.ResultIndex];
+
+		// 검색 결과는 참가가 끝나면 해제되기 때문에 다음 후보 몇개만 복사해둔다.
+		m_FallbackResults.Reset();
+		for (int32 Index = 1; Index < SortedResults.Num() && m_FallbackResults.Num() < MaxFallbackCandidates; ++Index)
+		{
+			if (Search->SearchResults.IsValidIndex(SortedResults[Index].ResultIndex))
+			{
+				m_FallbackResults.Add(Search->SearchResults[SortedResults[Index].ResultIndex]);
+			}
+		}
+
+		// 성공은 참가가 끝났을때 알린다.
+		StopSearch();
+		m_bAwaitingJoin = true;
+		m_bAwaitingAdmission = true;
+		m_Subsystem->JoinSession(BestResult);
+		return;
+	}
+
+	if (Elapsed >= m_Params.TimeBudget)
+	{
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Matchmaking gave up after %.2fs"), Elapsed);
+
+		FinishMatchmaking(false);
+		return;
+	}
+
+	// 아직 시간이 남았다면 조금 기다렸다가 넓어진 조건으로 다시 검색
+	if (m_Subsystem->GetGameInstance())
+	{
+		m_Subsystem->GetGameInstance()->GetTimerManager().SetTimer(m_SearchTimerHandle, this, &ThisClass::RunSearch, m_Params.SearchInterval, false);
+	}
+}
+
+void UMultiplayerMatchmaker::FinishMatchmaking(bool bWasSuccessful)
+{
+	StopSearch();
+
+	MultiplayerOnMatchmakingComplete.Broadcast(bWasSuccessful);
+}
+
+void UMultiplayerMatchmaker::OnTimeBudgetExpired()
+{
+	if (!m_bMatchmaking)
+		return;
+
+	// 처리 중인 검색 결과는 번호가 바뀌어서 버려진다.
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Matchmaking gave up after %.2fs, no usable search response within the budget"), FPlatformTime::Seconds() - m_StartTime);
+
+	FinishMatchmaking(false);
+}
+
+void UMultiplayerMatchmaker::OnJoinSessionComplete(EOnJoinSessionCompleteResult::Type Result)
+{
+	if (!m_bAwaitingJoin || !m_Subsystem.IsValid())
+		return;
+
+	m_bAwaitingJoin = false;
+
+	if (Result == EOnJoinSessionCompleteResult::Success)
+	{
+		// 로비로 이동하는 동안에도 PreLogin에서 거절당할 수 있어서 맵을 불러올때까지 후보는 남겨둔다.
+		MultiplayerOnMatchmakingComplete.Broadcast(true);
+		return;
+	}
+
+	JoinNextCandidate();
+}
+
+void UMultiplayerMatchmaker::OnJoinRejected(EMultiplayerAdmissionResult Reason)
+{
+	if (!m_bAwaitingAdmission || !m_Subsystem.IsValid())
+		return;
+
+	m_bAwaitingJoin = false;
+	JoinNextCandidate();
+}
+
+void UMultiplayerMatchmaker::JoinNextCandidate()
+{
+	if (m_FallbackResults.Num() == 0)
+	{
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Matchmaking ran out of candidates"));
+
+		m_bAwaitingJoin = false;
+		m_bAwaitingAdmission = false;
+		MultiplayerOnMatchmakingComplete.Broadcast(false);
+		return;
+	}
+
+	const FOnlineSessionSearchResult NextResult = m_FallbackResults[0];
+	m_FallbackResults.RemoveAt(0);
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Matchmaking trying the next candidate (%d left)"), m_FallbackResults.Num());
+
+	// 요청이 바로 실패하면 이 안에서 OnJoinSessionComplete가 다시 불려서 다음 후보로 넘어간다.
+	m_bAwaitingJoin = true;
+	m_Subsystem->JoinSession(NextResult);
+}
+
+void UMultiplayerMatchmaker::OnPostLoadMap(UWorld* World)
+{
+	m_bAwaitingJoin = false;
+	m_bAwaitingAdmission = false;
+	m_FallbackResults.Empty();
+}
+
+FMultiplayerSearchResultProcessor::FFilterAndScore UMultiplayerMatchmaker::MakeFilterAndScore(const FMultiplayerMatchmakingParams& Params, double Elapsed, int32& OutSkillTolerance)
+{
+	const int32 SkillTolerance = GetSkillTolerance(Params, Elapsed);
+	OutSkillTolerance = SkillTolerance;
+	const bool bAnyRegion = Params.Region == EMultiplayerRegion::Any || Elapsed >= Params.RegionWidenTime;
+
+	const EMultiplayerMatchType RequestedMatchType = FMultiplayerSessionInfo::MatchTypeFromString(Params.MatchType);
+
+	// 허용 실력 차이 안에 들어오는 버킷만 후보로 삼는다.
+	TArray<EMultiplayerRegion> Regions;
+	if (bAnyRegion)
+	{
+		for (uint8 Region = 0; Region <= static_cast<uint8>(EMultiplayerRegion::Oceania); ++Region)
+		{
+			Regions.Add(static_cast<EMultiplayerRegion>(Region));
+		}
+	}
+	else
+	{
+		// 지역을 광고하지 않은 세션은 어느 지역에서나 후보가 된다.
+		Regions.Add(Params.Region);
+		Regions.Add(EMultiplayerRegion::Any);
+	}
+
+	const int32 MinBucket = (Params.Skill - SkillTolerance) / SkillBucketSize;
+	const int32 MaxBucket = (Params.Skill + SkillTolerance) / SkillBucketSize;
+
+	TSet<uint32> AllowedBuckets;
+	for (EMultiplayerRegion Region : Regions)
+	{
+		for (int32 SkillBucket = MinBucket; SkillBucket <= MaxBucket; ++SkillBucket)
+		{
+			AllowedBuckets.Add(MakeBucketKey(Region, RequestedMatchType, SkillBucket));
+		}
+	}
+
+	// 지역 + 매치 타입 + 실력 구간 버킷으로 거르고 점수를 매기는 작업은 워커 스레드에서 처리
+	// 멤버를 건드리지 않도록 필요한 값은 전부 복사해서 넘긴다.
+	return [AllowedBuckets = MoveTemp(AllowedBuckets), RequestedMatchType, CustomMatchType = Params.MatchType, LocalSkill = Params.Skill, PreferredRegion = Params.Region, SkillTolerance]
+		(const FOnlineSessionSearchResult& SearchResult, FMultiplayerDecodedResult& Decoded)
+		{
+			if (Decoded.OpenSlots <= 0)
+				return false;
+
+			if (!AllowedBuckets.Contains(MakeBucketKey(Decoded.SessionInfo.Region, Decoded.SessionInfo.MatchType, Decoded.Skill / SkillBucketSize)))
+				return false;
+
+			// 목록에 없는 매치 타입만 문자열로 비교
+			if (Decoded.SessionInfo.MatchType == EMultiplayerMatchType::Custom && FMultiplayerSessionInfo::ReadMatchType(SearchResult.Session.SessionSettings) != CustomMatchType)
+				return false;
+
+			const int32 SkillDelta = FMath::Abs(Decoded.Skill - LocalSkill);
+			if (SkillDelta > SkillTolerance)
+				return false;
+
+			Decoded.Score = ScoreCandidate(SkillDelta, Decoded.PingInMs, SkillTolerance);
+
+			// 원하는 지역이 아닌 세션은 조금 낮게 평가
+			if (PreferredRegion != EMultiplayerRegion::Any && Decoded.SessionInfo.Region != PreferredRegion)
+			{
+				Decoded.Score *= 0.8f;
+			}
+
+			return true;
+		};
+}
+
+void UMultiplayerMatchmaker::RunBenchmark(int32 NumPlayers, int32 NumSessions, int32 Seed)
+{
+	if (NumPlayers <= 0 || NumSessions <= 0)
+		return;
+
+	FRandomStream Random(Seed);
+	TArray<FOnlineSessionSearchResult> Sessions = FMultiplayerSearchResultProcessor::MakeBenchmarkResults(NumSessions, Random);
+
+	TArray<float> TimesToMatch;
+	TArray<float> Qualities;
+	TArray<int32> SkillDeltas;
+	TArray<int32> Pings;
+	int32 NumSearches = 0;
+	double ProcessTime = 0.0;
+
+	const EMultiplayerMatchType MatchTypes[] = { EMultiplayerMatchType::FreeForAll, EMultiplayerMatchType::TeamDeathmatch, EMultiplayerMatchType::CaptureTheFlag };
+
+	// 플레이어가 한명씩 들어와서 세션 자리를 채운다. 뒤에 온 플레이어일수록 남은 자리가 적다.
+	// 백엔드 응답 시간은 빼고 검색 간격만으로 시간을 흘려서 매칭 로직 자체를 본다.
+	for (int32 PlayerIndex = 0; PlayerIndex < NumPlayers; ++PlayerIndex)
+	{
+		FMultiplayerMatchmakingParams Params;
+		Params.MatchType = FMultiplayerSessionInfo::MatchTypeToString(MatchTypes[Random.RandHelper(UE_ARRAY_COUNT(MatchTypes))]);
+		Params.Region = static_cast<EMultiplayerRegion>(Random.RandRange(static_cast<int32>(EMultiplayerRegion::Asia), static_cast<int32>(EMultiplayerRegion::Oceania)));
+		Params.Skill = FMultiplayerSearchResultProcessor::MakeBenchmarkSkill(Random);
+
+		for (double Elapsed = 0.0; Elapsed < Params.TimeBudget; Elapsed += Params.SearchInterval)
+		{
+			int32 SkillTolerance = 0;
+			const FMultiplayerSearchResultProcessor::FFilterAndScore FilterAndScore = MakeFilterAndScore(Params, Elapsed, SkillTolerance);
+
+			const double StartTime = FPlatformTime::Seconds();
+			const TArray<FMultiplayerDecodedResult> SortedResults = FMultiplayerSearchResultProcessor::Process(Sessions, FilterAndScore);
+			ProcessTime += FPlatformTime::Seconds() - StartTime;
+			++NumSearches;
+
+			if (SortedResults.Num() == 0)
+				continue;
+
+			const FMultiplayerDecodedResult& Best = SortedResults[0];
+			TimesToMatch.Add(Elapsed);
+			Qualities.Add(Best.Score);
+			SkillDeltas.Add(FMath::Abs(Best.Skill - Params.Skill));
+			Pings.Add(Best.PingInMs);
+
+			FOnlineSessionSettings& Settings = Sessions[Best.ResultIndex].Session.SessionSettings;
+			FMultiplayerSessionKeys::OpenSlots.Set(Settings, Best.OpenSlots - 1);
+			break;
+		}
+	}
+
+	TimesToMatch.Sort();
+	Qualities.Sort();
+	SkillDeltas.Sort();
+	Pings.Sort();
+
+	const int32 NumMatched = TimesToMatch.Num();
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Matchmaking benchmark: %d players, %d sessions, seed %d, matched %d (%.1f%%), %d searches, %.3fms per search"),
+		NumPlayers, NumSessions, Seed, NumMatched, 100.f * NumMatched / NumPlayers, NumSearches, NumSearches > 0 ? ProcessTime / NumSearches * 1000.0 : 0.0);
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("  time to match  p50 %.1fs  p90 %.1fs  p99 %.1fs  max %.1fs"),
+		SortedPercentile(TimesToMatch, 50.f), SortedPercentile(TimesToMatch, 90.f), SortedPercentile(TimesToMatch, 99.f), SortedPercentile(TimesToMatch, 100.f));
+	// 품질은 나쁜 쪽 꼬리가 중요해서 낮은 백분위수를 본다.
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("  quality        p10 %.2f  p50 %.2f  p90 %.2f"),
+		SortedPercentile(Qualities, 10.f), SortedPercentile(Qualities, 50.f), SortedPercentile(Qualities, 90.f));
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("  skill delta    p50 %d  p90 %d  max %d"),
+		SortedPercentile(SkillDeltas, 50.f), SortedPercentile(SkillDeltas, 90.f), SortedPercentile(SkillDeltas, 100.f));
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("  ping           p50 %dms  p90 %dms"),
+		SortedPercentile(Pings, 50.f), SortedPercentile(Pings, 90.f));
+}
+
+uint32 UMultiplayerMatchmaker::MakeBucketKey(EMultiplayerRegion Region, EMultiplayerMatchType MatchType, int32 SkillBucket)
+{
+	return HashCombine(HashCombine(GetTypeHash(static_cast<uint8>(Region)), GetTypeHash(static_cast<uint8>(MatchType))), GetTypeHash(SkillBucket));
+}
+
+int32 UMultiplayerMatchmaker::GetSkillTolerance(const FMultiplayerMatchmakingParams& Params, double Elapsed)
+{
+	if (Params.WidenInterval <= 0.f)
+		return Params.SkillTolerance;
+
+	const int32 NumSteps = FMath::FloorToInt(Elapsed / Params.WidenInterval);
+	return Params.SkillTolerance + NumSteps * Params.SkillToleranceStep;
+}
+
+float UMultiplayerMatchmaker::ScoreCandidate(int32 SkillDelta, int32 PingInMs, int32 SkillTolerance)
+{
+	const float SkillScore = 1.f - static_cast<float>(SkillDelta) / static_cast<float>(SkillTolerance + 1);
+	const float PingScore = 1.f - FMath::Clamp(PingInMs / 300.f, 0.f, 1.f);
+
+	return SkillScore * 0.7f + PingScore * 0.3f;
+}
@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerNetHealthComponent.h"
+#include "MultiplayerSessions.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "Async/Async.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "TimerManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Sample Net Health"), STAT_MultiplayerSampleNetHealth, STATGROUP_MultiplayerSessions);
+
+TRACE_DECLARE_INT_COUNTER(MultiplayerNetHealthConnections, TEXT("MultiplayerSessions/NetHealth/Connections"));
+TRACE_DECLARE_FLOAT_COUNTER(MultiplayerNetHealthRttP95, TEXT("MultiplayerSessions/NetHealth/RttP95Ms"));
+TRACE_DECLARE_FLOAT_COUNTER(MultiplayerNetHealthOutLossP95, TEXT("MultiplayerSessions/NetHealth/OutLossP95"));
+TRACE_DECLARE_INT_COUNTER(MultiplayerNetHealthSaturated, TEXT("MultiplayerSessions/NetHealth/SaturatedConnections"));
+
+namespace
+{
+	// 내보내기 작업은 백그라운드 스레드 아무데서나 돌기 때문에 앞의 쓰기가 끝나기 전에 다음 쓰기가 시작될 수 있다.
+	// 헤더 확인부터 추가 쓰기까지 묶어서 헤더가 두번 들어가거나 줄이 섞이지 않게 한다. 컴포넌트가 여러개여도 파일은 하나다.
+	FCriticalSection NetHealthCsvLock;
+}
+
+UMultiplayerNetHealthComponent::UMultiplayerNetHealthComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UMultiplayerNetHealthComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// 클라이언트 연결은 서버에만 있다.
+	if (GetNetMode() == NM_Standalone || GetNetMode() == NM_Client)
+		return;
+
+	// 내보내기 사이의 샘플이 덮어써지지 않도록 버퍼는 최소한 내보내기 간격만큼 잡는다.
+	const float Interval = FMath::Max(SampleInterval, 0.1f);
+	m_Capacity = FMath::Max(RingBufferSize, 1);
+	if (ExportInterval > 0.f)
+	{
+		m_Capacity = FMath::Max(m_Capacity, FMath::CeilToInt(ExportInterval / Interval));
+	}
+
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	TimerManager.SetTimer(m_SampleTimerHandle, this, &ThisClass::Sample, Interval, true);
+
+	if (ExportInterval > 0.f)
+	{
+		TimerManager.SetTimer(m_ExportTimerHandle, this, &ThisClass::Export, ExportInterval, true);
+	}
+}
+
+void UMultiplayerNetHealthComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(m_SampleTimerHandle);
+		World->GetTimerManager().ClearTimer(m_ExportTimerHandle);
+	}
+
+	// 로비가 닫히기 전까지 모은 샘플도 남긴다.
+	Export();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UMultiplayerNetHealthComponent::FConnectionHealth::Add(const FMultiplayerNetHealthSample& InSample, int32 Capacity)
+{
+	NumNewSamples = FMath::Min(NumNewSamples + 1, Capacity);
+
+	if (Samples.Num() < Capacity)
+	{
+		Samples.Add(InSample);
+		return;
+	}
+
+	Samples[Head] = InSample;
+	Head = (Head + 1) % Samples.Num();
+}
+
+void UMultiplayerNetHealthComponent::Sample()
+{
+	SCOPE_CYCLE_COUNTER(STAT_MultiplayerSampleNetHealth);
+
+	const UNetDriver* NetDriver = GetWorld() ? GetWorld()->GetNetDriver() : nullptr;
+	if (NetDriver == nullptr)
+		return;
+
+	for (TPair<TWeakObjectPtr<UNetConnection>, FConnectionHealth>& Pair : m_Connections)
+	{
+		Pair.Value.bConnected = false;
+	}
+
+	const int32 Capacity = m_Capacity;
+	TArray<float> RttValues;
+	TArray<float> OutLossValues;
+	int32 NumSaturated = 0;
+
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (Connection == nullptr || Connection->GetConnectionState() != USOCK_Open)
+			continue;
+
+		FConnectionHealth* Health = m_Connections.Find(Connection);
+		if (Health == nullptr)
+		{
+			Health = &m_Connections.Add(Connection);
+			Health->PlayerId = Connection->PlayerId.IsValid() ? Connection->PlayerId.ToString() : FString();
+			Health->Address = Connection->LowLevelGetRemoteAddress(true);
+			Health->Samples.Reserve(Capacity);
+		}
+		else if (Health->PlayerId.IsEmpty() && Connection->PlayerId.IsValid())
+		{
+			// 로그인이 끝나기 전에는 아이디가 비어있다.
+			Health->PlayerId = Connection->PlayerId.ToString();
+		}
+
+		FMultiplayerNetHealthSample NewSample;
+		NewSample.RttMs = Connection->AvgLag * 1000.f;
+		NewSample.InLoss = Connection->GetInLossPercentage().GetAvgLossPercentage();
+		NewSample.OutLoss = Connection->GetOutLossPercentage().GetAvgLossPercentage();
+		NewSample.Saturation = Connection->CurrentNetSpeed > 0 ? static_cast<float>(Connection->OutBytesPerSecond) / Connection->CurrentNetSpeed : 0.f;
+		NewSample.bSaturated = !Connection->IsNetReady(false);
+
+		Health->Add(NewSample, Capacity);
+		Health->bConnected = true;
+
+		RttValues.Add(NewSample.RttMs);
+		OutLossValues.Add(NewSample.OutLoss);
+		NumSaturated += NewSample.bSaturated ? 1 : 0;
+	}
+
+	TRACE_COUNTER_SET(MultiplayerNetHealthConnections, RttValues.Num());
+	TRACE_COUNTER_SET(MultiplayerNetHealthRttP95, Percentile(RttValues, 0.95f));
+	TRACE_COUNTER_SET(MultiplayerNetHealthOutLossP95, Percentile(OutLossValues, 0.95f));
+	TRACE_COUNTER_SET(MultiplayerNetHealthSaturated, NumSaturated);
+}
+
+void UMultiplayerNetHealthComponent::Export()
+{
+	if (m_Connections.Num() == 0)
+		return;
+
+	FString Csv;
+	const FString Time = FDateTime::UtcNow().ToIso8601();
+	TArray<float> Rtt;
+	TArray<float> OutLoss;
+	TArray<float> Saturation;
+
+	for (auto It = m_Connections.CreateIterator(); It; ++It)
+	{
+		FConnectionHealth& Health = It.Value();
+		const int32 NumSamples = FMath::Min(Health.NumNewSamples, Health.Samples.Num());
+
+		if (NumSamples > 0)
+		{
+			Rtt.Reset(NumSamples);
+			OutLoss.Reset(NumSamples);
+			Saturation.Reset(NumSamples);
+			float InLossSum = 0.f;
+			float OutLossSum = 0.f;
+			int32 NumSaturated = 0;
+
+			// 지난 요약에 들어간 샘플은 빼고 가장 최근 NumSamples개만. 버퍼가 차기 전에는 Head가 0이라 끝에서부터 센다.
+			for (int32 Offset = NumSamples; Offset > 0; --Offset)
+			{
+				const int32 Index = (Health.Head - Offset + Health.Samples.Num()) % Health.Samples.Num();
+				const FMultiplayerNetHealthSample& HealthSample = Health.Samples[Index];
+
+				Rtt.Add(HealthSample.RttMs);
+				OutLoss.Add(HealthSample.OutLoss);
+				Saturation.Add(HealthSample.Saturation);
+				InLossSum += HealthSample.InLoss;
+				OutLossSum += HealthSample.OutLoss;
+				NumSaturated += HealthSample.bSaturated ? 1 : 0;
+			}
+
+			Csv += FString::Printf(TEXT("%s,%s,%s,%d,%.1f,%.1f,%.1f,%.4f,%.4f,%.4f,%.3f,%d,%d\n"),
+				*Time, *Health.PlayerId, *Health.Address, NumSamples,
+				Percentile(Rtt, 0.5f), Percentile(Rtt, 0.95f), Percentile(Rtt, 0.99f),
+				InLossSum / NumSamples, OutLossSum / NumSamples, Percentile(OutLoss, 0.95f),
+				Percentile(Saturation, 0.95f), NumSaturated, Health.bConnected ? 1 : 0);
+
+			Health.NumNewSamples = 0;
+		}
+
+		// 끊긴 연결은 마지막 요약을 남긴 뒤에 지운다.
+		if (!Health.bConnected || !It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (Csv.IsEmpty())
+		return;
+
+	// 문자열은 게임 스레드에서 만들고 파일 확인과 쓰기는 백그라운드에서. 로비 틱이 디스크를 기다리지 않는다.
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [FilePath = GetCsvFilePath(), Csv = MoveTemp(Csv)]() mutable
+		{
+			FScopeLock Lock(&NetHealthCsvLock);
+
+			IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+			if (!PlatformFile.FileExists(*FilePath))
+			{
+				PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath));
+				Csv = TEXT("Time,PlayerId,Address,Samples,RttP50Ms,RttP95Ms,RttP99Ms,InLossAvg,OutLossAvg,OutLossP95,SaturationP95,SaturatedSamples,Connected\n") + Csv;
+			}
+
+			if (!FFileHelper::SaveStringToFile(Csv, *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+			{
+				UE_LOG(LogMultiplayerSessions, Warning, TEXT("Failed to write net health to %s"), *FilePath);
+			}
+		});
+}
+
+float UMultiplayerNetHealthComponent::Percentile(TArray<float>& Values, float Percent)
+{
+	if (Values.Num() == 0)
+		return 0.f;
+
+	Values.Sort();
+
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percent * Values.Num()) - 1, 0, Values.Num() - 1);
+	return Values[Index];
+}
+
+FString UMultiplayerNetHealthComponent::GetCsvFilePath() const
+{
+	return CsvFilePath.IsEmpty() ? FPaths::ProfilingDir() / TEXT("NetHealth.csv") : CsvFilePath;
+}
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerNetProfile.h"
+#include "MultiplayerSessions.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/Player.h"
+#include "Misc/ConfigCacheIni.h"
+
+namespace MultiplayerNetProfile
+{
+	static const TCHAR* ProfilesSection = TEXT("MultiplayerSessions.NetProfiles");
+	static const TCHAR* ProfileSectionPrefix = TEXT("MultiplayerSessions.NetProfile.");
+
+	static void ReadOptionalInt(const FString& Section, const TCHAR* Key, TOptional<int32>& OutValue)
+	{
+		int32 Value = 0;
+		if (GConfig->GetInt(*Section, Key, Value, GGameIni))
+		{
+			OutValue = Value;
+		}
+	}
+}
+
+bool FMultiplayerNetProfile::Load(const FString& ProfileName, FMultiplayerNetProfile& OutProfile)
+{
+	if (GConfig == nullptr || ProfileName.IsEmpty())
+		return false;
+
+	const FString Section = MultiplayerNetProfile::ProfileSectionPrefix + ProfileName;
+	if (!GConfig->DoesSectionExist(*Section, GGameIni))
+		return false;
+
+	OutProfile = FMultiplayerNetProfile();
+	OutProfile.Name = ProfileName;
+
+	MultiplayerNetProfile::ReadOptionalInt(Section, TEXT("NetServerMaxTickRate"), OutProfile.NetServerMaxTickRate);
+	MultiplayerNetProfile::ReadOptionalInt(Section, TEXT("MaxNetTickRate"), OutProfile.MaxNetTickRate);
+	MultiplayerNetProfile::ReadOptionalInt(Section, TEXT("MaxClientRate"), OutProfile.MaxClientRate);
+	MultiplayerNetProfile::ReadOptionalInt(Section, TEXT("MaxInternetClientRate"), OutProfile.MaxInternetClientRate);
+	MultiplayerNetProfile::ReadOptionalInt(Section, TEXT("ConfiguredInternetSpeed"), OutProfile.ConfiguredInternetSpeed);
+	MultiplayerNetProfile::ReadOptionalInt(Section, TEXT("ConfiguredLanSpeed"), OutProfile.ConfiguredLanSpeed);
+
+	return true;
+}
+
+FString FMultiplayerNetProfile::GetConfiguredProfileName()
+{
+	FString ProfileName;
+	if (GConfig)
+	{
+		GConfig->GetString(MultiplayerNetProfile::ProfilesSection, TEXT("ActiveProfile"), ProfileName, GGameIni);
+	}
+
+	return ProfileName;
+}
+
+void FMultiplayerNetProfile::Apply(UNetDriver& NetDriver) const
+{
+	if (NetServerMaxTickRate.IsSet())
+	{
+		NetDriver.NetServerMaxTickRate = NetServerMaxTickRate.GetValue();
+	}
+	if (MaxNetTickRate.IsSet())
+	{
+		NetDriver.MaxNetTickRate = MaxNetTickRate.GetValue();
+	}
+	if (MaxClientRate.IsSet())
+	{
+		NetDriver.MaxClientRate = MaxClientRate.GetValue();
+	}
+	if (MaxInternetClientRate.IsSet())
+	{
+		NetDriver.MaxInternetClientRate = MaxInternetClientRate.GetValue();
+	}
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Applied net profile %s to %s (tick %d, client rate %d/%d)"),
+		*Name, *NetDriver.NetDriverName.ToString(), NetDriver.NetServerMaxTickRate, NetDriver.MaxClientRate, NetDriver.MaxInternetClientRate);
+}
+
+void FMultiplayerNetProfile::Apply(UPlayer& Player) const
+{
+	if (ConfiguredInternetSpeed.IsSet())
+	{
+		Player.ConfiguredInternetSpeed = ConfiguredInternetSpeed.GetValue();
+	}
+	if (ConfiguredLanSpeed.IsSet())
+	{
+		Player.ConfiguredLanSpeed = ConfiguredLanSpeed.GetValue();
+	}
+}
+
+void FMultiplayerNetProfile::LogNetDriverStats(const UNetDriver& NetDriver)
+{
+	// InPackets, OutPackets 등은 넷 드라이버가 1초마다 갱신하는 값
+	const int32 NumConnections = NetDriver.ServerConnection ? 1 : NetDriver.ClientConnections.Num();
+
+	float AverageLag = 0.f;
+	if (NetDriver.ServerConnection)
+	{
+		AverageLag = NetDriver.ServerConnection->AvgLag;
+	}
+	else if (NumConnections > 0)
+	{
+		for (const UNetConnection* Connection : NetDriver.ClientConnections)
+		{
+			AverageLag += Connection ? Connection->AvgLag : 0.f;
+		}
+		AverageLag /= NumConnections;
+	}
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("%s: %d connections, in %u pkt/s %u B/s, out %u pkt/s %u B/s, avg lag %.1fms"),
+		*NetDriver.NetDriverName.ToString(), NumConnections,
+		NetDriver.InPackets, NetDriver.InBytes, NetDriver.OutPackets, NetDriver.OutBytes, AverageLag * 1000.f);
+}
@@ -0,0 +1,429 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerNetSweep.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessions.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "TimerManager.h"
+
+namespace
+{
+	// 측정할 값. 단계 수가 곱으로 늘어나기 때문에 프로필 후보 근처만 넣는다.
+	const int32 SweepTickRates[] = { 30, 60, 120 };
+	const int32 SweepClientRates[] = { 15000, 50000, 100000 };
+	// 엔진 기본값은 1/60초
+	const float SweepClientSendMoveDeltaTimes[] = { 0.0166f, 0.0333f };
+
+	FAutoConsoleCommandWithWorldAndArgs NetSweepCommand(
+		TEXT("MultiplayerSessions.NetSweep"),
+		TEXT("Launches local clients against this listen server and sweeps tick rate, client rate and move coalescing, writing CPU per connection, packets/s and latency to Saved/Profiling/NetSweep. Usage: MultiplayerSessions.NetSweep [Clients] [SecondsPerStep]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+			UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+			if (Subsystem == nullptr)
+				return;
+
+			const int32 NumClients = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 8;
+			const float SecondsPerStep = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 10.f;
+			Subsystem->StartNetSweep(NumClients, SecondsPerStep);
+		}));
+
+	// 스윕이 띄운 클라이언트가 실행하는 명령. 가만히 있으면 이동 RPC가 나가지 않아서 측정이 안된다.
+	FTSTicker::FDelegateHandle BotTickerHandle;
+
+	FAutoConsoleCommand NetSweepBotCommand(
+		TEXT("MultiplayerSessions.NetSweepBot"),
+		TEXT("Keeps the local pawn walking in a circle so it sends movement every frame. Used by the clients MultiplayerSessions.NetSweep launches."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			if (BotTickerHandle.IsValid())
+				return;
+
+			// 접속하면서 월드가 바뀌기 때문에 매 틱 현재 월드의 폰을 찾는다.
+			BotTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([](float DeltaTime)
+				{
+					if (GEngine == nullptr)
+						return true;
+
+					for (const FWorldContext& Context : GEngine->GetWorldContexts())
+					{
+						UWorld* World = Context.World();
+						if (World == nullptr || !World->IsGameWorld())
+							continue;
+
+						APlayerController* PlayerController = GEngine->GetFirstLocalPlayerController(World);
+						APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+						if (Pawn == nullptr)
+							continue;
+
+						const float Angle = World->GetTimeSeconds();
+						Pawn->AddMovementInput(FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f));
+					}
+					return true;
+				}));
+		}));
+}
+
+bool UMultiplayerNetSweep::Start(UMultiplayerSessionsSubsystem* Subsystem, int32 NumClients, float SecondsPerStep)
+{
+	if (m_bRunning || Subsystem == nullptr || NumClients <= 0 || SecondsPerStep <= 0.f)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Net sweep not started, needs at least one client, a positive step length and no sweep running"));
+		return false;
+	}
+
+	m_Subsystem = Subsystem;
+
+	UWorld* World = Subsystem->GetWorld();
+	UNetDriver* NetDriver = GetNetDriver();
+	if (World == nullptr || NetDriver == nullptr || World->GetNetMode() != NM_ListenServer)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Net sweep not started, open a map with ?listen first"));
+		return false;
+	}
+
+	m_bRunning = true;
+	m_NumClients = NumClients;
+	m_SecondsPerStep = SecondsPerStep;
+	m_StepIndex = 0;
+	m_Results.Reset();
+	m_LaunchedSendMoveDeltaTime = -1.f;
+
+	m_OriginalProfile = FMultiplayerNetProfile();
+	m_OriginalProfile.Name = TEXT("Original");
+	m_OriginalProfile.NetServerMaxTickRate = NetDriver->NetServerMaxTickRate;
+	m_OriginalProfile.MaxClientRate = NetDriver->MaxClientRate;
+	m_OriginalProfile.MaxInternetClientRate = NetDriver->MaxInternetClientRate;
+
+	// 클라이언트를 다시 띄우는 횟수가 적도록 클라이언트 값이 가장 바깥 루프
+	m_Steps.Reset();
+	for (const float ClientSendMoveDeltaTime : SweepClientSendMoveDeltaTimes)
+	{
+		for (const int32 TickRate : SweepTickRates)
+		{
+			for (const int32 ClientRate : SweepClientRates)
+			{
+				FSweepStep& Step = m_Steps.AddDefaulted_GetRef();
+				Step.TickRate = TickRate;
+				Step.ClientRate = ClientRate;
+				Step.ClientSendMoveDeltaTime = ClientSendMoveDeltaTime;
+			}
+		}
+	}
+
+	m_CsvFilePath = FPaths::ProfilingDir() / TEXT("NetSweep") / FString::Printf(TEXT("NetSweep-%s.csv"), *FDateTime::Now().ToString());
+	FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*FPaths::GetPath(m_CsvFilePath));
+	FFileHelper::SaveStringToFile(TEXT("Clients,ClientSendMoveDeltaTime,TickRate,ClientRate,Connections,CpuPercent,CpuPercentPerConnection,InPacketsPerSec,OutPacketsPerSec,InBytesPerSec,OutBytesPerSec,AvgLagMs\n"),
+		*m_CsvFilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Net sweep started, %d clients, %d steps of %.0fs, writing %s"), NumClients, m_Steps.Num(), SecondsPerStep, *m_CsvFilePath);
+
+	BeginStep();
+	return true;
+}
+
+void UMultiplayerNetSweep::Stop()
+{
+	if (!m_bRunning)
+		return;
+
+	m_bRunning = false;
+
+	if (FTimerManager* TimerManager = GetTimerManager())
+	{
+		TimerManager->ClearTimer(m_StepTimerHandle);
+	}
+
+	KillClients();
+
+	if (UNetDriver* NetDriver = GetNetDriver())
+	{
+		m_OriginalProfile.Apply(*NetDriver);
+	}
+}
+
+void UMultiplayerNetSweep::BeginStep()
+{
+	if (!m_Steps.IsValidIndex(m_StepIndex))
+	{
+		Finish();
+		return;
+	}
+
+	const FSweepStep& Step = m_Steps[m_StepIndex];
+	if (Step.ClientSendMoveDeltaTime != m_LaunchedSendMoveDeltaTime)
+	{
+		KillClients();
+		LaunchClients(Step.ClientSendMoveDeltaTime);
+		WaitForClients();
+		return;
+	}
+
+	UNetDriver* NetDriver = GetNetDriver();
+	FTimerManager* TimerManager = GetTimerManager();
+	if (NetDriver == nullptr || TimerManager == nullptr)
+	{
+		Stop();
+		return;
+	}
+
+	FMultiplayerNetProfile Profile;
+	Profile.Name = FString::Printf(TEXT("NetSweep %d/%d"), m_StepIndex + 1, m_Steps.Num());
+	Profile.NetServerMaxTickRate = Step.TickRate;
+	Profile.MaxClientRate = Step.ClientRate;
+	Profile.MaxInternetClientRate = Step.ClientRate;
+	Profile.Apply(*NetDriver);
+
+	TimerManager->SetTimer(m_StepTimerHandle, this, &ThisClass::BeginSampling, WarmupSeconds, false);
+}
+
+void UMultiplayerNetSweep::LaunchClients(float ClientSendMoveDeltaTime)
+{
+	UWorld* World = m_Subsystem.IsValid() ? m_Subsystem->GetWorld() : nullptr;
+	if (World == nullptr)
+		return;
+
+	const FString ExecutablePath = FPlatformProcess::ExecutablePath();
+	const FString ProjectPath = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+	const FString URL = FString::Printf(TEXT("127.0.0.1:%d?%s=%d"), World->URL.Port, FMultiplayerAdmission::BuildOption, UMultiplayerSessionsSubsystem::GetBuildUniqueId());
+
+	for (int32 Index = 0; Index < m_NumClients; ++Index)
+	{
+		// 렌더링과 사운드 없이 NULL 서브시스템으로 바로 접속. 이동 RPC 간격은 클라이언트의 GameNetworkManager 값을 덮어쓴다.
+		const FString Params = FString::Printf(TEXT("\"%s\" %s -game -nullrhi -nosound -unattended -nosteam -log=NetSweepClient%d.log ")
+			TEXT("-ini:Game:[/Script/Engine.GameNetworkManager]:ClientNetSendMoveDeltaTime=%.4f -ExecCmds=\"MultiplayerSessions.NetSweepBot\""),
+			*ProjectPath, *URL, Index, ClientSendMoveDeltaTime);
+
+		FProcHandle Handle = FPlatformProcess::CreateProc(*ExecutablePath, *Params, true, true, true, nullptr, 0, nullptr, nullptr);
+		if (Handle.IsValid())
+		{
+			m_ClientProcesses.Add(Handle);
+		}
+		else
+		{
+			UE_LOG(LogMultiplayerSessions, Warning, TEXT("Net sweep failed to launch client %d"), Index);
+		}
+	}
+
+	m_LaunchedSendMoveDeltaTime = ClientSendMoveDeltaTime;
+	m_LaunchTime = FPlatformTime::Seconds();
+}
+
+void UMultiplayerNetSweep::KillClients()
+{
+	// 연결을 먼저 닫아야 다시 띄운 클라이언트 수를 셀때 타임아웃을 기다리는 연결이 섞이지 않는다.
+	if (UNetDriver* NetDriver = GetNetDriver())
+	{
+		const TArray<UNetConnection*> Connections = NetDriver->ClientConnections;
+		for (UNetConnection* Connection : Connections)
+		{
+			if (Connection)
+			{
+				Connection->Close();
+			}
+		}
+	}
+
+	for (FProcHandle& Handle : m_ClientProcesses)
+	{
+		FPlatformProcess::TerminateProc(Handle, true);
+		FPlatformProcess::CloseProc(Handle);
+	}
+
+	m_ClientProcesses.Reset();
+	m_LaunchedSendMoveDeltaTime = -1.f;
+}
+
+void UMultiplayerNetSweep::WaitForClients()
+{
+	UNetDriver* NetDriver = GetNetDriver();
+	FTimerManager* TimerManager = GetTimerManager();
+	if (!m_bRunning || NetDriver == nullptr || TimerManager == nullptr)
+	{
+		Stop();
+		return;
+	}
+
+	if (NetDriver->ClientConnections.Num() == m_ClientProcesses.Num() && m_ClientProcesses.Num() > 0)
+	{
+		BeginStep();
+		return;
+	}
+
+	if (FPlatformTime::Seconds() - m_LaunchTime > ClientConnectTimeout)
+	{
+		UE_LOG(LogMultiplayerSessions, Error, TEXT("Net sweep stopped, %d of %d clients connected, check Saved/Logs/NetSweepClient*.log"),
+			NetDriver->ClientConnections.Num(), m_ClientProcesses.Num());
+		Stop();
+		return;
+	}
+
+	TimerManager->SetTimer(m_StepTimerHandle, this, &ThisClass::WaitForClients, 1.f, false);
+}
+
+void UMultiplayerNetSweep::BeginSampling()
+{
+	FTimerManager* TimerManager = GetTimerManager();
+	if (TimerManager == nullptr)
+	{
+		Stop();
+		return;
+	}
+
+	m_NumSamples = 0;
+	m_TotalCpuPercent = 0.0;
+	m_TotalConnections = 0.0;
+	m_TotalInPackets = 0.0;
+	m_TotalOutPackets = 0.0;
+	m_TotalInBytes = 0.0;
+	m_TotalOutBytes = 0.0;
+	m_TotalLagMs = 0.0;
+
+	TimerManager->SetTimer(m_StepTimerHandle, this, &ThisClass::Sample, 1.f, true);
+}
+
+void UMultiplayerNetSweep::Sample()
+{
+	UNetDriver* NetDriver = GetNetDriver();
+	if (NetDriver == nullptr)
+	{
+		Stop();
+		return;
+	}
+
+	m_TotalCpuPercent += FPlatformTime::GetCPUTime().CPUTimePct;
+	m_TotalConnections += NetDriver->ClientConnections.Num();
+	m_TotalInPackets += NetDriver->InPackets;
+	m_TotalOutPackets += NetDriver->OutPackets;
+	m_TotalInBytes += NetDriver->InBytes;
+	m_TotalOutBytes += NetDriver->OutBytes;
+
+	if (NetDriver->ClientConnections.Num() > 0)
+	{
+		double LagMs = 0.0;
+		for (const UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			LagMs += Connection ? Connection->AvgLag * 1000.0 : 0.0;
+		}
+		m_TotalLagMs += LagMs / NetDriver->ClientConnections.Num();
+	}
+
+	if (++m_NumSamples >= FMath::CeilToInt(m_SecondsPerStep))
+	{
+		EndStep();
+	}
+}
+
+void UMultiplayerNetSweep::EndStep()
+{
+	if (FTimerManager* TimerManager = GetTimerManager())
+	{
+		TimerManager->ClearTimer(m_StepTimerHandle);
+	}
+
+	const FSweepStep& Step = m_Steps[m_StepIndex];
+	const double Samples = FMath::Max(m_NumSamples, 1);
+	const double Connections = m_TotalConnections / Samples;
+	const double CpuPercent = m_TotalCpuPercent / Samples;
+	const double CpuPercentPerConnection = Connections > 0.0 ? CpuPercent / Connections : 0.0;
+
+	const FString Row = FString::Printf(TEXT("%d,%.4f,%d,%d,%.1f,%.2f,%.3f,%.0f,%.0f,%.0f,%.0f,%.1f\n"),
+		m_NumClients, Step.ClientSendMoveDeltaTime, Step.TickRate, Step.ClientRate, Connections, CpuPercent, CpuPercentPerConnection,
+		m_TotalInPackets / Samples, m_TotalOutPackets / Samples, m_TotalInBytes / Samples, m_TotalOutBytes / Samples, m_TotalLagMs / Samples);
+	FFileHelper::SaveStringToFile(Row, *m_CsvFilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append);
+
+	FSweepResult& Result = m_Results.AddDefaulted_GetRef();
+	Result.Step = Step;
+	Result.CpuPercentPerConnection = CpuPercentPerConnection;
+	Result.InPackets = m_TotalInPackets / Samples;
+	Result.OutPackets = m_TotalOutPackets / Samples;
+	Result.LagMs = m_TotalLagMs / Samples;
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Net sweep %d/%d: move delta %.4f, tick %d, client rate %d -> cpu %.3f%%/conn, in %.0f pkt/s, out %.0f pkt/s, lag %.1fms"),
+		m_StepIndex + 1, m_Steps.Num(), Step.ClientSendMoveDeltaTime, Step.TickRate, Step.ClientRate,
+		CpuPercentPerConnection, m_TotalInPackets / Samples, m_TotalOutPackets / Samples, m_TotalLagMs / Samples);
+
+	++m_StepIndex;
+	BeginStep();
+}
+
+void UMultiplayerNetSweep::Finish()
+{
+	Stop();
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Net sweep finished, results in %s"), *m_CsvFilePath);
+
+	WriteBestProfile();
+}
+
+void UMultiplayerNetSweep::WriteBestProfile() const
+{
+	if (m_Results.Num() == 0)
+		return;
+
+	double MinLagMs = TNumericLimits<double>::Max();
+	for (const FSweepResult& Result : m_Results)
+	{
+		MinLagMs = FMath::Min(MinLagMs, Result.LagMs);
+	}
+
+	const FSweepResult* Best = nullptr;
+	for (const FSweepResult& Result : m_Results)
+	{
+		if (Result.LagMs > MinLagMs + LagToleranceMs)
+			continue;
+
+		if (Best == nullptr || Result.CpuPercentPerConnection < Best->CpuPercentPerConnection)
+		{
+			Best = &Result;
+		}
+	}
+
+	// DefaultGame.ini에 그대로 붙여넣을 수 있는 형태. 측정값은 주석으로 함께 남긴다.
+	// 이동 RPC 간격은 클라이언트 설정이라 프로필에 넣을 수 없어서 엔진 섹션으로 따로 적는다.
+	const FString IniFilePath = FPaths::ChangeExtension(m_CsvFilePath, TEXT("ini"));
+	const FString Ini = FString::Printf(
+		TEXT("; NetSweep %d clients, %.0fs per step, %s\n")
+		TEXT("; cpu %.3f%%/conn, in %.0f pkt/s, out %.0f pkt/s, lag %.1fms\n")
+		TEXT("[MultiplayerSessions.NetProfile.Measured]\n")
+		TEXT("NetServerMaxTickRate=%d\n")
+		TEXT("MaxClientRate=%d\n")
+		TEXT("MaxInternetClientRate=%d\n")
+		TEXT("\n")
+		TEXT("[/Script/Engine.GameNetworkManager]\n")
+		TEXT("ClientNetSendMoveDeltaTime=%.4f\n"),
+		m_NumClients, m_SecondsPerStep, *FPaths::GetCleanFilename(m_CsvFilePath),
+		Best->CpuPercentPerConnection, Best->InPackets, Best->OutPackets, Best->LagMs,
+		Best->Step.TickRate, Best->Step.ClientRate, Best->Step.ClientRate,
+		Best->Step.ClientSendMoveDeltaTime);
+	FFileHelper::SaveStringToFile(Ini, *IniFilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Net sweep best: tick %d, client rate %d, move delta %.4f (cpu %.3f%%/conn, lag %.1fms), profile written to %s"),
+		Best->Step.TickRate, Best->Step.ClientRate, Best->Step.ClientSendMoveDeltaTime, Best->CpuPercentPerConnection, Best->LagMs, *IniFilePath);
+}
+
+UNetDriver* UMultiplayerNetSweep::GetNetDriver() const
+{
+	UWorld* World = m_Subsystem.IsValid() ? m_Subsystem->GetWorld() : nullptr;
+	return World ? World->GetNetDriver() : nullptr;
+}
+
+FTimerManager* UMultiplayerNetSweep::GetTimerManager() const
+{
+	UGameInstance* GameInstance = m_Subsystem.IsValid() ? m_Subsystem->GetGameInstance() : nullptr;
+	return GameInstance ? &GameInstance->GetTimerManager() : nullptr;
+}
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerReservationBeacon.h"
+#include "MultiplayerSessions.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/NetConnection.h"
+#include "TimerManager.h"
+
+bool AMultiplayerReservationBeaconClient::RequestReservation(const FString& ConnectAddress, const TArray<FString>& PlayerIds, float Timeout)
+{
+	m_PlayerIds = PlayerIds;
+	m_bCompleted = false;
+
+	FURL URL(nullptr, *ConnectAddress, TRAVEL_Absolute);
+	if (!URL.Valid || !InitClient(URL))
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Failed to open a reservation beacon to %s"), *ConnectAddress);
+		return false;
+	}
+
+	// 비콘 연결 자체의 타임아웃보다 짧게 잡아서 응답이 늦으면 다른 세션을 시도하게 한다.
+	GetWorldTimerManager().SetTimer(m_TimeoutTimerHandle, this, &ThisClass::OnReservationTimeout, Timeout, false);
+	return true;
+}
+
+void AMultiplayerReservationBeaconClient::OnConnected()
+{
+	Super::OnConnected();
+
+	ServerRequestReservation(m_PlayerIds, UMultiplayerSessionsSubsystem::GetBuildUniqueId());
+}
+
+void AMultiplayerReservationBeaconClient::OnFailure()
+{
+	CompleteReservation(EMultiplayerAdmissionResult::ReservationFailed);
+
+	Super::OnFailure();
+}
+
+void AMultiplayerReservationBeaconClient::ServerRequestReservation_Implementation(const TArray<FString>& PlayerIds, int32 BuildUniqueId)
+{
+	const UNetConnection* Connection = GetNetConnection();
+	const FString RequesterId = Connection && Connection->PlayerId.IsValid() ? Connection->PlayerId.ToString() : FString();
+
+	// 요청을 연달아 보내서 로비의 예약 목록을 채우지 못하도록 연결당 요청 간격을 제한
+	const double Now = FPlatformTime::Seconds();
+	if (m_LastServerRequestTime >= 0.0 && Now - m_LastServerRequestTime < MinServerRequestInterval)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Reservation request from '%s' dropped: too frequent"), *RequesterId);
+		ClientReservationResponse(EMultiplayerAdmissionResult::ReservationFailed);
+		return;
+	}
+	m_LastServerRequestTime = Now;
+
+	// 비콘에 접속한 플레이어 자신이 목록에 있어야 한다. 남의 아이디만으로 자리를 잡을 수 없다.
+	const bool bValidRequest = !RequesterId.IsEmpty() && PlayerIds.Contains(RequesterId) && PlayerIds.Num() <= MaxReservationPlayers;
+
+	AMultiplayerReservationBeaconHostObject* HostObject = Cast<AMultiplayerReservationBeaconHostObject>(GetBeaconOwner());
+
+	if (!bValidRequest)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Reservation request from '%s' rejected: %d player(s), requester not in the list or too many"),
+			*RequesterId, PlayerIds.Num());
+	}
+
+	const EMultiplayerAdmissionResult Result = HostObject && bValidRequest
+		? HostObject->ProcessReservationRequest(PlayerIds, BuildUniqueId)
+		: EMultiplayerAdmissionResult::ReservationFailed;
+
+	// 연결은 응답을 받은 클라이언트가 닫는다.
+	ClientReservationResponse(Result);
+}
+
+void AMultiplayerReservationBeaconClient::ClientReservationResponse_Implementation(EMultiplayerAdmissionResult Result)
+{
+	CompleteReservation(Result);
+}
+
+void AMultiplayerReservationBeaconClient::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(m_TimeoutTimerHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AMultiplayerReservationBeaconClient::OnReservationTimeout()
+{
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Reservation beacon timed out"));
+
+	CompleteReservation(EMultiplayerAdmissionResult::ReservationFailed);
+}
+
+void AMultiplayerReservationBeaconClient::CompleteReservation(EMultiplayerAdmissionResult Result)
+{
+	if (m_bCompleted)
+		return;
+
+	m_bCompleted = true;
+	GetWorldTimerManager().ClearTimer(m_TimeoutTimerHandle);
+
+	OnReservationComplete.Broadcast(Result);
+
+	// 결과를 받은 쪽이 콜백 안에서 정리하지 않아도 되도록 다음 틱에 연결을 닫는다.
+	GetWorldTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &ThisClass::DestroyBeacon));
+}
+
+AMultiplayerReservationBeaconHostObject::AMultiplayerReservationBeaconHostObject()
+{
+	ClientBeaconActorClass = AMultiplayerReservationBeaconClient::StaticClass();
+	BeaconTypeName = ClientBeaconActorClass->GetName();
+}
+
+EMultiplayerAdmissionResult AMultiplayerReservationBeaconHostObject::ProcessReservationRequest(const TArray<FString>& PlayerIds, int32 BuildUniqueId)
+{
+	if (PlayerIds.Num() == 0 || !OnReservationRequest.IsBound())
+		return EMultiplayerAdmissionResult::ReservationFailed;
+
+	const EMultiplayerAdmissionResult Result = OnReservationRequest.Execute(PlayerIds, BuildUniqueId);
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Reservation for %d player(s): %s"), PlayerIds.Num(),
+		*StaticEnum<EMultiplayerAdmissionResult>()->GetNameStringByValue(static_cast<int64>(Result)));
+
+	return Result;
+}
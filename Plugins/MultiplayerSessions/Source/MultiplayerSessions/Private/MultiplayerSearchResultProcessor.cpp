@@ -0,0 +1,274 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSearchResultProcessor.h"
+#include "MultiplayerSessions.h"
+#include "OnlineSessionSettings.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+DECLARE_CYCLE_STAT(TEXT("Process Search Results"), STAT_MultiplayerProcessSearchResults, STATGROUP_MultiplayerSessions);
+DECLARE_CYCLE_STAT(TEXT("Process Search Results (Game Thread)"), STAT_MultiplayerProcessSearchResultsGameThread, STATGROUP_MultiplayerSessions);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Processed Search Results"), STAT_MultiplayerProcessedSearchResults, STATGROUP_MultiplayerSessions);
+
+namespace
+{
+	FAutoConsoleCommand ProcessBenchmarkCommand(
+		TEXT("MultiplayerSessions.ProcessBenchmark"),
+		TEXT("Measures game thread time spent on 100 to 10000 synthetic search results, processed on the game thread vs on workers. Usage: MultiplayerSessions.ProcessBenchmark [Iterations]"),
+		FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+		{
+			const int32 Iterations = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10;
+
+			FMultiplayerSearchResultProcessor::RunBenchmark(Iterations);
+		}));
+
+	struct FProcessBenchmark
+	{
+		TArray<int32> ResultCounts{ 100, 500, 1000, 5000, 10000 };
+		int32 Iterations{ 0 };
+		int32 CountIndex{ 0 };
+		int32 Iteration{ 0 };
+		FRandomStream Random{ 1 };
+		TSharedPtr<FOnlineSessionSearch> Search;
+
+		// 결과 수 하나에 대한 누적 시간 (초)
+		double SerialTime{ 0.0 };
+		double ParallelTime{ 0.0 };
+		double AsyncGameThreadTime{ 0.0 };
+		double AsyncLatency{ 0.0 };
+
+		double AsyncStartTime{ 0.0 };
+		bool bDispatching{ false };
+	};
+
+	// 벤치마크용 필터. 빈 자리가 있는 세션만 남기고 핑이 낮을수록 앞으로
+	bool BenchmarkFilterAndScore(const FOnlineSessionSearchResult& SearchResult, FMultiplayerDecodedResult& Decoded)
+	{
+		Decoded.Score = -static_cast<float>(Decoded.PingInMs);
+		return Decoded.OpenSlots > 0;
+	}
+
+	void RunProcessBenchmarkStep(TSharedRef<FProcessBenchmark> Benchmark)
+	{
+		if (!Benchmark->ResultCounts.IsValidIndex(Benchmark->CountIndex))
+		{
+			UE_LOG(LogMultiplayerSessions, Log, TEXT("Search result processing benchmark finished"));
+			return;
+		}
+
+		const int32 NumResults = Benchmark->ResultCounts[Benchmark->CountIndex];
+
+		// 결과 수가 바뀔때 동기 처리를 먼저 재고 비동기 처리는 한번씩 이어서 잰다.
+		if (Benchmark->Iteration == 0)
+		{
+			Benchmark->Search = MakeShareable(new FOnlineSessionSearch());
+			Benchmark->Search->SearchResults = FMultiplayerSearchResultProcessor::MakeBenchmarkResults(NumResults, Benchmark->Random);
+			Benchmark->SerialTime = 0.0;
+			Benchmark->ParallelTime = 0.0;
+			Benchmark->AsyncGameThreadTime = 0.0;
+			Benchmark->AsyncLatency = 0.0;
+
+			for (int32 Iteration = 0; Iteration < Benchmark->Iterations; ++Iteration)
+			{
+				double StartTime = FPlatformTime::Seconds();
+				FMultiplayerSearchResultProcessor::Process(Benchmark->Search->SearchResults, &BenchmarkFilterAndScore, true);
+				Benchmark->SerialTime += FPlatformTime::Seconds() - StartTime;
+
+				StartTime = FPlatformTime::Seconds();
+				FMultiplayerSearchResultProcessor::Process(Benchmark->Search->SearchResults, &BenchmarkFilterAndScore);
+				Benchmark->ParallelTime += FPlatformTime::Seconds() - StartTime;
+			}
+		}
+
+		Benchmark->AsyncStartTime = FPlatformTime::Seconds();
+		Benchmark->bDispatching = true;
+
+		FMultiplayerSearchResultProcessor::ProcessAsync(Benchmark->Search.ToSharedRef(), &BenchmarkFilterAndScore,
+			[Benchmark](TSharedRef<const FOnlineSessionSearch> Search, TArray<FMultiplayerDecodedResult>&& SortedResults)
+			{
+				// 결과가 적으면 ProcessAsync 안에서 바로 호출되고, 이때는 호출 시간에 이미 들어가 있다.
+				if (!Benchmark->bDispatching)
+				{
+					const double CallbackStartTime = FPlatformTime::Seconds();
+					TArray<FMultiplayerDecodedResult> Results = MoveTemp(SortedResults);
+					Benchmark->AsyncGameThreadTime += FPlatformTime::Seconds() - CallbackStartTime;
+				}
+				Benchmark->AsyncLatency += FPlatformTime::Seconds() - Benchmark->AsyncStartTime;
+
+				// 다음 단계는 다음 틱에 실행해서 측정이 겹치지 않도록
+				AsyncTask(ENamedThreads::GameThread, [Benchmark]()
+					{
+						if (++Benchmark->Iteration >= Benchmark->Iterations)
+						{
+							const double Scale = 1000.0 / Benchmark->Iterations;
+							UE_LOG(LogMultiplayerSessions, Log, TEXT("%6d results: game thread serial %.3fms, game thread parallel %.3fms, async game thread %.3fms (latency %.3fms)"),
+								Benchmark->ResultCounts[Benchmark->CountIndex], Benchmark->SerialTime * Scale, Benchmark->ParallelTime * Scale,
+								Benchmark->AsyncGameThreadTime * Scale, Benchmark->AsyncLatency * Scale);
+
+							++Benchmark->CountIndex;
+							Benchmark->Iteration = 0;
+						}
+
+						RunProcessBenchmarkStep(Benchmark);
+					});
+			});
+
+		Benchmark->AsyncGameThreadTime += FPlatformTime::Seconds() - Benchmark->AsyncStartTime;
+		Benchmark->bDispatching = false;
+	}
+}
+
+void FMultiplayerSearchResultProcessor::ProcessAsync(TSharedRef<const FOnlineSessionSearch> Search, FFilterAndScore FilterAndScore, FOnProcessed OnProcessed)
+{
+	if (Search->SearchResults.Num() < AsyncThreshold)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_MultiplayerProcessSearchResultsGameThread);
+
+		TArray<FMultiplayerDecodedResult> SortedResults = Process(Search->SearchResults, FilterAndScore);
+		OnProcessed(Search, MoveTemp(SortedResults));
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// 검색 객체는 참조를 옮기기만 해서 참조 카운트가 워커 스레드에서 바뀌지 않도록 한다.
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask,
+		[Search = MoveTemp(Search), FilterAndScore = MoveTemp(FilterAndScore), OnProcessed = MoveTemp(OnProcessed), StartTime]() mutable
+		{
+			TArray<FMultiplayerDecodedResult> SortedResults = Process(Search->SearchResults, FilterAndScore);
+			const double WorkerTime = FPlatformTime::Seconds() - StartTime;
+
+			AsyncTask(ENamedThreads::GameThread,
+				[Search = MoveTemp(Search), OnProcessed = MoveTemp(OnProcessed), SortedResults = MoveTemp(SortedResults), WorkerTime]() mutable
+				{
+					SCOPE_CYCLE_COUNTER(STAT_MultiplayerProcessSearchResultsGameThread);
+
+					const double GameThreadStartTime = FPlatformTime::Seconds();
+					const int32 NumResults = Search->SearchResults.Num();
+					const int32 NumKept = SortedResults.Num();
+
+					OnProcessed(Search, MoveTemp(SortedResults));
+
+					UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Processed %d search results (%d kept) in %.2fms on workers, %.2fms on game thread"),
+						NumResults, NumKept, WorkerTime * 1000.0, (FPlatformTime::Seconds() - GameThreadStartTime) * 1000.0);
+				});
+		});
+}
+
+TArray<FMultiplayerDecodedResult> FMultiplayerSearchResultProcessor::Process(const TArray<FOnlineSessionSearchResult>& SearchResults, const FFilterAndScore& FilterAndScore, bool bSingleThreaded)
+{
+	LLM_SCOPE_BYTAG(MultiplayerSessionsSearch);
+	SCOPE_CYCLE_COUNTER(STAT_MultiplayerProcessSearchResults);
+	INC_DWORD_STAT_BY(STAT_MultiplayerProcessedSearchResults, SearchResults.Num());
+
+	const int32 NumChunks = FMath::DivideAndRoundUp(SearchResults.Num(), ChunkSize);
+
+	// 청크마다 따로 모아서 합치기 때문에 잠금이 필요 없다.
+	TArray<TArray<FMultiplayerDecodedResult>> ChunkResults;
+	ChunkResults.SetNum(NumChunks);
+
+	ParallelFor(NumChunks, [&SearchResults, &FilterAndScore, &ChunkResults](int32 ChunkIndex)
+		{
+			const int32 Begin = ChunkIndex * ChunkSize;
+			const int32 End = FMath::Min(Begin + ChunkSize, SearchResults.Num());
+
+			TArray<FMultiplayerDecodedResult>& Chunk = ChunkResults[ChunkIndex];
+			Chunk.Reserve(End - Begin);
+
+			for (int32 Index = Begin; Index < End; ++Index)
+			{
+				FMultiplayerDecodedResult Decoded;
+				Decode(SearchResults[Index], Index, Decoded);
+
+				if (!FilterAndScore || FilterAndScore(SearchResults[Index], Decoded))
+				{
+					Chunk.Add(Decoded);
+				}
+			}
+		}, bSingleThreaded || NumChunks <= 1);
+
+	int32 NumKept = 0;
+	for (const TArray<FMultiplayerDecodedResult>& Chunk : ChunkResults)
+	{
+		NumKept += Chunk.Num();
+	}
+
+	TArray<FMultiplayerDecodedResult> SortedResults;
+	SortedResults.Reserve(NumKept);
+	for (TArray<FMultiplayerDecodedResult>& Chunk : ChunkResults)
+	{
+		SortedResults.Append(MoveTemp(Chunk));
+	}
+
+	// 점수가 같다면 백엔드가 돌려준 순서를 유지
+	SortedResults.Sort([](const FMultiplayerDecodedResult& A, const FMultiplayerDecodedResult& B)
+		{
+			return A.Score != B.Score ? A.Score > B.Score : A.ResultIndex < B.ResultIndex;
+		});
+
+	return SortedResults;
+}
+
+void FMultiplayerSearchResultProcessor::Decode(const FOnlineSessionSearchResult& SearchResult, int32 ResultIndex, FMultiplayerDecodedResult& OutDecoded)
+{
+	const FOnlineSessionSettings& Settings = SearchResult.Session.SessionSettings;
+
+	OutDecoded.ResultIndex = ResultIndex;
+	OutDecoded.SessionInfo = FMultiplayerSessionInfo::Read(Settings);
+	OutDecoded.PingInMs = SearchResult.PingInMs;
+
+	// 남은 자리를 광고하지 않는 세션은 들어갈 수 있다고 본다.
+	OutDecoded.OpenSlots = FMultiplayerSessionKeys::OpenSlots.GetOr(Settings, 1);
+
+	// 실력 정보가 없는 세션은 기본값으로 취급
+	OutDecoded.Skill = FMultiplayerSessionKeys::Skill.GetOr(Settings, FMultiplayerMatchmakingParams().Skill);
+}
+
+TArray<FOnlineSessionSearchResult> FMultiplayerSearchResultProcessor::MakeBenchmarkResults(int32 NumResults, FRandomStream& Random)
+{
+	const EMultiplayerMatchType MatchTypes[] = { EMultiplayerMatchType::FreeForAll, EMultiplayerMatchType::TeamDeathmatch, EMultiplayerMatchType::CaptureTheFlag };
+
+	TArray<FOnlineSessionSearchResult> SearchResults;
+	SearchResults.SetNum(NumResults);
+
+	for (int32 Index = 0; Index < NumResults; ++Index)
+	{
+		FOnlineSessionSearchResult& SearchResult = SearchResults[Index];
+		SearchResult.PingInMs = Random.RandRange(10, 250);
+
+		FOnlineSession& Session = SearchResult.Session;
+		Session.OwningUserName = FString::Printf(TEXT("Benchmark%d"), Index);
+		Session.SessionSettings.NumPublicConnections = Random.RandRange(2, 16);
+		Session.NumOpenPublicConnections = Random.RandRange(0, Session.SessionSettings.NumPublicConnections);
+
+		FMultiplayerSessionInfo Info;
+		Info.MatchType = MatchTypes[Random.RandHelper(UE_ARRAY_COUNT(MatchTypes))];
+		Info.Region = static_cast<EMultiplayerRegion>(Random.RandRange(static_cast<int32>(EMultiplayerRegion::Asia), static_cast<int32>(EMultiplayerRegion::Oceania)));
+		Info.Write(Session.SessionSettings, FMultiplayerSessionInfo::MatchTypeToString(Info.MatchType));
+
+		FMultiplayerSessionKeys::OpenSlots.Set(Session.SessionSettings, Session.NumOpenPublicConnections);
+		FMultiplayerSessionKeys::Skill.Set(Session.SessionSettings, MakeBenchmarkSkill(Random));
+	}
+
+	return SearchResults;
+}
+
+int32 FMultiplayerSearchResultProcessor::MakeBenchmarkSkill(FRandomStream& Random)
+{
+	// 균등 분포 세개를 더하면 종 모양에 가까워진다. 대략 400 ~ 1600
+	const float Spread = Random.FRand() + Random.FRand() + Random.FRand() - 1.5f;
+	return FMath::Max(0, 1000 + FMath::RoundToInt(Spread * 400.f));
+}
+
+void FMultiplayerSearchResultProcessor::RunBenchmark(int32 Iterations)
+{
+	TSharedRef<FProcessBenchmark> Benchmark = MakeShared<FProcessBenchmark>();
+	Benchmark->Iterations = FMath::Max(Iterations, 1);
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Search result processing benchmark: %d iterations per result count, async threshold %d"), Benchmark->Iterations, AsyncThreshold);
+
+	RunProcessBenchmarkStep(Benchmark);
+}
@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionAsyncActions.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessions.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+namespace
+{
+	UMultiplayerSessionsSubsystem* GetSessionsSubsystem(UObject* WorldContextObject)
+	{
+		UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull) : nullptr;
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+
+		return GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+	}
+}
+
+UCreateMultiplayerSessionAsyncAction* UCreateMultiplayerSessionAsyncAction::CreateMultiplayerSession(UObject* WorldContextObject, int32 NumPublicConnections, FString MatchType)
+{
+	UCreateMultiplayerSessionAsyncAction* Action = NewObject<UCreateMultiplayerSessionAsyncAction>();
+	Action->m_Subsystem = GetSessionsSubsystem(WorldContextObject);
+	Action->m_NumPublicConnections = NumPublicConnections;
+	Action->m_MatchType = MatchType;
+	// SetReadyToDestroy가 호출될때까지 게임 인스턴스가 액션을 살려둔다.
+	Action->RegisterWithGameInstance(WorldContextObject);
+
+	return Action;
+}
+
+void UCreateMultiplayerSessionAsyncAction::Activate()
+{
+	if (!m_Subsystem.IsValid())
+	{
+		OnFailure.Broadcast();
+		SetReadyToDestroy();
+		return;
+	}
+
+	m_Subsystem->MultiplayerOnCreateSessionComplete.AddDynamic(this, &ThisClass::OnCreateSessionComplete);
+
+	// 이미 생성 중이라면 같은 결과를 기다린다.
+	if (!m_Subsystem->IsCreateSessionInProgress())
+	{
+		m_Subsystem->CreateSession(m_NumPublicConnections, m_MatchType);
+	}
+}
+
+void UCreateMultiplayerSessionAsyncAction::Cancel()
+{
+	if (m_Subsystem.IsValid())
+	{
+		m_Subsystem->MultiplayerOnCreateSessionComplete.RemoveDynamic(this, &ThisClass::OnCreateSessionComplete);
+	}
+
+	SetReadyToDestroy();
+}
+
+void UCreateMultiplayerSessionAsyncAction::OnCreateSessionComplete(bool bWasSuccessful)
+{
+	Cancel();
+
+	if (bWasSuccessful)
+	{
+		OnSuccess.Broadcast();
+	}
+	else
+	{
+		OnFailure.Broadcast();
+	}
+}
+
+UFindMultiplayerSessionsAsyncAction* UFindMultiplayerSessionsAsyncAction::FindMultiplayerSessions(UObject* WorldContextObject, int32 MaxSearchResults)
+{
+	UFindMultiplayerSessionsAsyncAction* Action = NewObject<UFindMultiplayerSessionsAsyncAction>();
+	Action->m_Subsystem = GetSessionsSubsystem(WorldContextObject);
+	Action->m_MaxSearchResults = MaxSearchResults;
+	Action->RegisterWithGameInstance(WorldContextObject);
+
+	return Action;
+}
+
+void UFindMultiplayerSessionsAsyncAction::Activate()
+{
+	if (!m_Subsystem.IsValid())
+	{
+		OnFailure.Broadcast(TArray<FMultiplayerSessionResult>());
+		SetReadyToDestroy();
+		return;
+	}
+
+	m_FindSessionCompleteDelegateHandle = m_Subsystem->MultiplayerOnFindSessionComplete.AddUObject(this, &ThisClass::OnFindSessionComplete);
+
+	if (!m_Subsystem->IsFindSessionInProgress())
+	{
+		m_bStartedSearch = true;
+		m_Subsystem->FindSession(m_MaxSearchResults);
+	}
+}
+
+void UFindMultiplayerSessionsAsyncAction::Cancel()
+{
+	if (m_Subsystem.IsValid())
+	{
+		m_Subsystem->MultiplayerOnFindSessionComplete.Remove(m_FindSessionCompleteDelegateHandle);
+
+		// 끝나기 전에 취소했다면 백엔드 검색도 멈춘다. 끝난 뒤라면 취소할 검색이 없다.
+		if (m_bStartedSearch)
+		{
+			m_bStartedSearch = false;
+			m_Subsystem->CancelFindSession();
+		}
+	}
+
+	SetReadyToDestroy();
+}
+
+void UFindMultiplayerSessionsAsyncAction::OnFindSessionComplete(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful)
+{
+	m_bStartedSearch = false;
+	Cancel();
+
+	TArray<FMultiplayerSessionResult> Results;
+	Results.Reserve(SessionResults.Num());
+
+	for (const FOnlineSessionSearchResult& SessionResult : SessionResults)
+	{
+		Results.Emplace(SessionResult);
+	}
+
+	if (bWasSuccessful)
+	{
+		OnSuccess.Broadcast(Results);
+	}
+	else
+	{
+		OnFailure.Broadcast(Results);
+	}
+}
+
+UJoinMultiplayerSessionAsyncAction* UJoinMultiplayerSessionAsyncAction::JoinMultiplayerSession(UObject* WorldContextObject, const FMultiplayerSessionResult& SessionResult, bool bTravelOnSuccess)
+{
+	UJoinMultiplayerSessionAsyncAction* Action = NewObject<UJoinMultiplayerSessionAsyncAction>();
+	Action->m_Subsystem = GetSessionsSubsystem(WorldContextObject);
+	Action->m_SessionResult = SessionResult;
+	Action->m_bTravelOnSuccess = bTravelOnSuccess;
+	Action->RegisterWithGameInstance(WorldContextObject);
+
+	return Action;
+}
+
+void UJoinMultiplayerSessionAsyncAction::Activate()
+{
+	if (!m_Subsystem.IsValid())
+	{
+		OnFailure.Broadcast(FString());
+		SetReadyToDestroy();
+		return;
+	}
+
+	const bool bJoinInProgress = m_Subsystem->IsJoinSessionInProgress();
+
+	// 다른 세션의 참가 결과를 이 노드의 결과로 알리면 안된다.
+	if (bJoinInProgress && !m_Subsystem->IsJoiningSession(m_SessionResult.OnlineResult))
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Join node failed, a join to a different session is already in progress"));
+
+		OnFailure.Broadcast(FString());
+		SetReadyToDestroy();
+		return;
+	}
+
+	m_JoinSessionCompleteDelegateHandle = m_Subsystem->MultiplayerOnJoinSessionComplete.AddUObject(this, &ThisClass::OnJoinSessionComplete);
+
+	// 같은 세션에 참가하는 중이라면 그 결과를 같이 받는다.
+	if (!bJoinInProgress)
+	{
+		m_Subsystem->JoinSession(m_SessionResult.OnlineResult);
+	}
+}
+
+void UJoinMultiplayerSessionAsyncAction::Cancel()
+{
+	if (m_Subsystem.IsValid())
+	{
+		m_Subsystem->MultiplayerOnJoinSessionComplete.Remove(m_JoinSessionCompleteDelegateHandle);
+	}
+
+	SetReadyToDestroy();
+}
+
+void UJoinMultiplayerSessionAsyncAction::OnJoinSessionComplete(EOnJoinSessionCompleteResult::Type Result)
+{
+	Cancel();
+
+	FString Address;
+	if (Result != EOnJoinSessionCompleteResult::Success || !m_Subsystem.IsValid() || !m_Subsystem->GetLastConnectString(Address))
+	{
+		OnFailure.Broadcast(Address);
+		return;
+	}
+
+	if (m_bTravelOnSuccess)
+	{
+		m_Subsystem->TravelToSession(Address);
+	}
+
+	OnSuccess.Broadcast(Address);
+}
@@ -0,0 +1,406 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionBrowser.h"
+#include "MultiplayerSessionEntry.h"
+#include "MultiplayerSessions.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSearchResultProcessor.h"
+#include "OnlineSessionSettings.h"
+#include "Components/Button.h"
+#include "Components/ListView.h"
+
+void UMultiplayerSessionBrowser::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	if (RefreshButton)
+	{
+		RefreshButton->OnClicked.AddDynamic(this, &ThisClass::RefreshButtonClicked);
+	}
+	if (JoinButton)
+	{
+		JoinButton->OnClicked.AddDynamic(this, &ThisClass::JoinButtonClicked);
+	}
+	if (SessionList)
+	{
+		SessionList->OnItemDoubleClicked().AddUObject(this, &ThisClass::OnItemDoubleClicked);
+	}
+
+	UGameInstance* GameInstance = GetGameInstance();
+	if (GameInstance)
+	{
+		m_MultiplayerSessionsSubsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
+	}
+
+	if (m_MultiplayerSessionsSubsystem.IsValid())
+	{
+		m_FindSessionCompleteDelegateHandle = m_MultiplayerSessionsSubsystem->MultiplayerOnFindSessionComplete.AddUObject(this, &ThisClass::OnFindSessionComplete);
+		m_JoinSessionCompleteDelegateHandle = m_MultiplayerSessionsSubsystem->MultiplayerOnJoinSessionComplete.AddUObject(this, &ThisClass::OnJoinSessionComplete);
+		m_JoinRejectedDelegateHandle = m_MultiplayerSessionsSubsystem->MultiplayerOnJoinRejected.AddUObject(this, &ThisClass::OnJoinRejected);
+
+		m_bLanDiscovery = m_MultiplayerSessionsSubsystem->StartLanDiscovery();
+		if (m_bLanDiscovery)
+		{
+			m_LanSessionsUpdatedDelegateHandle = m_MultiplayerSessionsSubsystem->MultiplayerOnLanSessionsUpdated.AddUObject(this, &ThisClass::OnLanSessionsUpdated);
+		}
+	}
+
+	if (m_bLanDiscovery)
+	{
+		PopulateFromLan();
+		return;
+	}
+
+	// 검색이 끝나기 전까지는 디스크에 남아있는 최근 세션을 보여준다.
+	PopulateFromCache();
+}
+
+void UMultiplayerSessionBrowser::NativeDestruct()
+{
+	if (m_MultiplayerSessionsSubsystem.IsValid())
+	{
+		m_MultiplayerSessionsSubsystem->MultiplayerOnFindSessionComplete.Remove(m_FindSessionCompleteDelegateHandle);
+		m_MultiplayerSessionsSubsystem->MultiplayerOnJoinSessionComplete.Remove(m_JoinSessionCompleteDelegateHandle);
+		m_MultiplayerSessionsSubsystem->MultiplayerOnJoinRejected.Remove(m_JoinRejectedDelegateHandle);
+
+		if (m_bLanDiscovery)
+		{
+			m_MultiplayerSessionsSubsystem->MultiplayerOnLanSessionsUpdated.Remove(m_LanSessionsUpdatedDelegateHandle);
+			m_MultiplayerSessionsSubsystem->StopLanDiscovery();
+		}
+	}
+	m_bLanDiscovery = false;
+
+	if (SessionList)
+	{
+		SessionList->OnItemDoubleClicked().RemoveAll(this);
+	}
+
+	// 처리중인 검색 결과가 돌아와도 무시하도록
+	++m_RefreshSerial;
+
+	// 아이템과 검색 결과 참조를 놓아서 메모리를 돌려준다.
+	ReleaseItems();
+
+	Super::NativeDestruct();
+}
+
+void UMultiplayerSessionBrowser::Refresh()
+{
+	if (!m_MultiplayerSessionsSubsystem.IsValid())
+		return;
+
+	// 비콘 리스너가 목록을 계속 갱신하고 있다.
+	if (m_bLanDiscovery)
+	{
+		PopulateFromLan();
+		return;
+	}
+
+	// 이미 검색 중이라면 그 결과를 같이 받는다.
+	if (m_MultiplayerSessionsSubsystem->IsFindSessionInProgress())
+		return;
+
+	m_MultiplayerSessionsSubsystem->FindSession(MaxSearchResults);
+}
+
+void UMultiplayerSessionBrowser::SetSortMode(EMultiplayerSessionSortMode SortMode, bool bDescending)
+{
+	m_SortMode = SortMode;
+	m_bSortDescending = bDescending;
+
+	ApplyView();
+}
+
+void UMultiplayerSessionBrowser::SetFilter(const FMultiplayerSessionBrowserFilter& Filter)
+{
+	m_Filter = Filter;
+
+	ApplyView();
+}
+
+void UMultiplayerSessionBrowser::JoinSelected()
+{
+	if (SessionList)
+	{
+		JoinItem(SessionList->GetSelectedItem<UMultiplayerSessionListItem>());
+	}
+}
+
+void UMultiplayerSessionBrowser::RefreshButtonClicked()
+{
+	Refresh();
+}
+
+void UMultiplayerSessionBrowser::JoinButtonClicked()
+{
+	JoinSelected();
+}
+
+void UMultiplayerSessionBrowser::OnItemDoubleClicked(UObject* Item)
+{
+	JoinItem(Cast<UMultiplayerSessionListItem>(Item));
+}
+
+void UMultiplayerSessionBrowser::JoinItem(const UMultiplayerSessionListItem* Item)
+{
+	if (Item == nullptr || !m_MultiplayerSessionsSubsystem.IsValid())
+		return;
+
+	// 캐시, LAN 세션은 검색 결과가 없어서 주소로 바로 이동
+	if (Item->bFromCache || Item->bFromLan)
+	{
+		m_MultiplayerSessionsSubsystem->TravelToSession(Item->ConnectAddress);
+		return;
+	}
+
+	if (!m_Search.IsValid() || !m_Search->SearchResults.IsValidIndex(Item->ResultIndex))
+		return;
+
+	if (JoinButton)
+	{
+		JoinButton->SetIsEnabled(false);
+	}
+
+	m_bJoinRequested = true;
+	m_MultiplayerSessionsSubsystem->JoinSession(m_Search->SearchResults[Item->ResultIndex]);
+}
+
+void UMultiplayerSessionBrowser::OnFindSessionComplete(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful)
+{
+	// LAN에서는 다른 곳에서 요청한 검색 결과가 비콘 목록을 덮어쓰지 않도록 무시
+	if (!m_MultiplayerSessionsSubsystem.IsValid() || m_bLanDiscovery)
+		return;
+
+	TSharedPtr<const FOnlineSessionSearch> Search = m_MultiplayerSessionsSubsystem->GetLastSessionSearch();
+	if (!Search.IsValid())
+		return;
+
+	// 디코딩은 워커 스레드에서 하고 아이템 갱신만 게임 스레드에서 한다.
+	TWeakObjectPtr<UMultiplayerSessionBrowser> WeakThis(this);
+	const uint32 RefreshSerial = ++m_RefreshSerial;
+
+	FMultiplayerSearchResultProcessor::ProcessAsync(Search.ToSharedRef(), nullptr,
+		[WeakThis, RefreshSerial](TSharedRef<const FOnlineSessionSearch> ProcessedSearch, TArray<FMultiplayerDecodedResult>&& Results)
+		{
+			if (WeakThis.IsValid() && WeakThis->m_RefreshSerial == RefreshSerial)
+			{
+				WeakThis->UpdateItems(ProcessedSearch, MoveTemp(Results));
+			}
+		});
+}
+
+void UMultiplayerSessionBrowser::OnJoinSessionComplete(EOnJoinSessionCompleteResult::Type Result)
+{
+	if (!m_bJoinRequested)
+		return;
+
+	m_bJoinRequested = false;
+
+	FString Address;
+	if (Result == EOnJoinSessionCompleteResult::Success && m_MultiplayerSessionsSubsystem.IsValid() && m_MultiplayerSessionsSubsystem->GetLastConnectString(Address))
+	{
+		ReleaseItems();
+		m_MultiplayerSessionsSubsystem->TravelToSession(Address);
+		return;
+	}
+
+	if (JoinButton)
+	{
+		JoinButton->SetIsEnabled(true);
+	}
+}
+
+void UMultiplayerSessionBrowser::OnJoinRejected(EMultiplayerAdmissionResult Reason)
+{
+	// 로비가 거절했다면 목록에서 다른 세션을 고를 수 있도록
+	if (JoinButton)
+	{
+		JoinButton->SetIsEnabled(true);
+	}
+}
+
+void UMultiplayerSessionBrowser::OnLanSessionsUpdated()
+{
+	PopulateFromLan();
+}
+
+void UMultiplayerSessionBrowser::UpdateItems(TSharedRef<const FOnlineSessionSearch> Search, TArray<FMultiplayerDecodedResult>&& Results)
+{
+	LLM_SCOPE_BYTAG(MultiplayerSessionsSearch);
+
+	m_Search = Search;
+	m_NumItems = Results.Num();
+
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		const FMultiplayerDecodedResult& Decoded = Results[Index];
+		const FOnlineSessionSearchResult& SearchResult = Search->SearchResults[Decoded.ResultIndex];
+
+		UMultiplayerSessionListItem* Item = GetPooledItem(Index);
+		Item->OwnerName = SearchResult.Session.OwningUserName;
+		Item->MatchType = Decoded.SessionInfo.MatchType == EMultiplayerMatchType::Custom
+			? FMultiplayerSessionInfo::ReadMatchType(SearchResult.Session.SessionSettings)
+			: FMultiplayerSessionInfo::MatchTypeToString(Decoded.SessionInfo.MatchType);
+		Item->OpenSlots = Decoded.OpenSlots;
+		Item->PingInMs = Decoded.PingInMs;
+		Item->bFromCache = false;
+		Item->bFromLan = false;
+		Item->ResultIndex = Decoded.ResultIndex;
+		Item->ConnectAddress.Empty();
+	}
+
+	ApplyView();
+}
+
+void UMultiplayerSessionBrowser::ReleaseItems()
+{
+	m_Search.Reset();
+	m_NumItems = 0;
+	m_ItemPool.Empty();
+	m_VisibleItems.Empty();
+
+	if (SessionList)
+	{
+		SessionList->ClearListItems();
+	}
+}
+
+void UMultiplayerSessionBrowser::PopulateFromCache()
+{
+	if (!m_MultiplayerSessionsSubsystem.IsValid())
+		return;
+
+	const TArray<FMultiplayerRecentSession> RecentSessions = m_MultiplayerSessionsSubsystem->GetRecentSessions();
+
+	m_NumItems = 0;
+	for (const FMultiplayerRecentSession& RecentSession : RecentSessions)
+	{
+		if (RecentSession.ConnectAddress.IsEmpty())
+			continue;
+
+		UMultiplayerSessionListItem* Item = GetPooledItem(m_NumItems++);
+		Item->OwnerName = RecentSession.OwnerName;
+		Item->MatchType = RecentSession.MatchType;
+		Item->OpenSlots = RecentSession.OpenSlots;
+		Item->PingInMs = RecentSession.PingInMs;
+		Item->bFromCache = true;
+		Item->bFromLan = false;
+		Item->ResultIndex = INDEX_NONE;
+		Item->ConnectAddress = RecentSession.ConnectAddress;
+	}
+
+	ApplyView();
+}
+
+void UMultiplayerSessionBrowser::PopulateFromLan()
+{
+	if (!m_MultiplayerSessionsSubsystem.IsValid())
+		return;
+
+	const TArray<FMultiplayerLanSession> LanSessions = m_MultiplayerSessionsSubsystem->GetLanSessions();
+
+	m_NumItems = 0;
+	for (const FMultiplayerLanSession& LanSession : LanSessions)
+	{
+		UMultiplayerSessionListItem* Item = GetPooledItem(m_NumItems++);
+		Item->OwnerName = LanSession.OwnerName;
+		Item->MatchType = LanSession.MatchType;
+		Item->OpenSlots = LanSession.OpenSlots;
+		Item->PingInMs = 0;
+		Item->bFromCache = false;
+		Item->bFromLan = true;
+		Item->ResultIndex = INDEX_NONE;
+		Item->ConnectAddress = LanSession.ConnectAddress;
+	}
+
+	ApplyView();
+}
+
+UMultiplayerSessionListItem* UMultiplayerSessionBrowser::GetPooledItem(int32 Index)
+{
+	while (m_ItemPool.Num() <= Index)
+	{
+		m_ItemPool.Add(NewObject<UMultiplayerSessionListItem>(this));
+	}
+
+	return m_ItemPool[Index];
+}
+
+void UMultiplayerSessionBrowser::ApplyView()
+{
+	m_VisibleItems.Reset();
+
+	for (int32 Index = 0; Index < m_NumItems; ++Index)
+	{
+		if (PassesFilter(*m_ItemPool[Index]))
+		{
+			m_VisibleItems.Add(m_ItemPool[Index]);
+		}
+	}
+
+	m_VisibleItems.Sort([this](const UMultiplayerSessionListItem& A, const UMultiplayerSessionListItem& B)
+		{
+			return SortPredicate(A, B);
+		});
+
+	if (SessionList == nullptr)
+		return;
+
+	// 리스트 뷰는 보이는 줄의 엔트리만 만들고 재사용한다.
+	SessionList->SetListItems(m_VisibleItems);
+
+	// 아이템 객체를 재사용했기 때문에 이미 떠있는 엔트리는 직접 갱신
+	for (UUserWidget* EntryWidget : SessionList->GetDisplayedEntryWidgets())
+	{
+		if (UMultiplayerSessionEntry* Entry = Cast<UMultiplayerSessionEntry>(EntryWidget))
+		{
+			Entry->RefreshFromItem();
+		}
+	}
+}
+
+bool UMultiplayerSessionBrowser::PassesFilter(const UMultiplayerSessionListItem& Item) const
+{
+	if (m_Filter.bHideFull && Item.OpenSlots <= 0)
+		return false;
+
+	if (m_Filter.MaxPingInMs > 0 && Item.PingInMs > m_Filter.MaxPingInMs)
+		return false;
+
+	if (!m_Filter.MatchType.IsEmpty() && Item.MatchType != m_Filter.MatchType)
+		return false;
+
+	if (!m_Filter.OwnerNameContains.IsEmpty() && !Item.OwnerName.Contains(m_Filter.OwnerNameContains))
+		return false;
+
+	return true;
+}
+
+bool UMultiplayerSessionBrowser::SortPredicate(const UMultiplayerSessionListItem& A, const UMultiplayerSessionListItem& B) const
+{
+	int32 Compare = 0;
+
+	switch (m_SortMode)
+	{
+	case EMultiplayerSessionSortMode::Ping:
+		Compare = A.PingInMs - B.PingInMs;
+		break;
+	case EMultiplayerSessionSortMode::OpenSlots:
+		Compare = A.OpenSlots - B.OpenSlots;
+		break;
+	case EMultiplayerSessionSortMode::OwnerName:
+		Compare = A.OwnerName.Compare(B.OwnerName, ESearchCase::IgnoreCase);
+		break;
+	case EMultiplayerSessionSortMode::MatchType:
+		Compare = A.MatchType.Compare(B.MatchType, ESearchCase::IgnoreCase);
+		break;
+	}
+
+	// 같은 값이라면 백엔드가 돌려준 순서를 유지
+	if (Compare == 0)
+		return A.ResultIndex < B.ResultIndex;
+
+	return m_bSortDescending ? Compare > 0 : Compare < 0;
+}
@@ -0,0 +1,322 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionCache.h"
+#include "MultiplayerSessions.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	struct FSessionCacheHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 RecordSize;
+		uint32 RecordCount;
+	};
+
+	static_assert(sizeof(FSessionCacheHeader) == 16, "Session cache header layout changed");
+}
+
+FMultiplayerSessionCache::FMultiplayerSessionCache(int32 InMaxRecords) :
+	m_MaxRecords(FMath::Max(InMaxRecords, 1))
+{
+}
+
+bool FMultiplayerSessionCache::Load(const FString& InFilePath)
+{
+	m_FilePath = InFilePath;
+	m_Records.Reset();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*m_FilePath))
+		return false;
+
+	// 매핑이 되면 레코드 배열을 복사 한번으로 가져온다.
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*m_FilePath));
+	if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+		if (MappedRegion.IsValid())
+		{
+			return ReadRecords(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+		}
+	}
+
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *m_FilePath))
+		return false;
+
+	return ReadRecords(FileData.GetData(), FileData.Num());
+}
+
+bool FMultiplayerSessionCache::ReadRecords(const uint8* Data, int64 DataSize)
+{
+	if (Data == nullptr || DataSize < static_cast<int64>(sizeof(FSessionCacheHeader)))
+		return false;
+
+	FSessionCacheHeader Header;
+	FMemory::Memcpy(&Header, Data, sizeof(Header));
+
+	// 형식이 바뀐 파일은 버리고 새로 만든다.
+	if (Header.Magic != Magic || Header.Version != Version || Header.RecordSize != sizeof(FMultiplayerSessionCacheRecord))
+	{
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Discarding session cache %s (version %u)"), *m_FilePath, Header.Version);
+		return false;
+	}
+
+	const int64 RecordBytes = DataSize - static_cast<int64>(sizeof(FSessionCacheHeader));
+	const int32 RecordCount = static_cast<int32>(FMath::Min<int64>(Header.RecordCount, RecordBytes / sizeof(FMultiplayerSessionCacheRecord)));
+
+	m_Records.SetNumUninitialized(RecordCount);
+	FMemory::Memcpy(m_Records.GetData(), Data + sizeof(FSessionCacheHeader), RecordCount * sizeof(FMultiplayerSessionCacheRecord));
+
+	const int64 OldestTicks = (FDateTime::UtcNow() - m_MaxRecordAge).GetTicks();
+	m_Records.RemoveAll([OldestTicks](const FMultiplayerSessionCacheRecord& Record)
+		{
+			return FMath::Max(Record.LastSeenTicks, Record.LastJoinedTicks) < OldestTicks;
+		});
+
+	for (FMultiplayerSessionCacheRecord& Record : m_Records)
+	{
+		// 파일이 깨졌더라도 문자열 밖을 읽지 않도록
+		Record.SessionId[FMultiplayerSessionCacheRecord::SessionIdSize - 1] = 0;
+		Record.ConnectAddress[FMultiplayerSessionCacheRecord::ConnectAddressSize - 1] = 0;
+		Record.OwnerName[FMultiplayerSessionCacheRecord::OwnerNameSize - 1] = 0;
+
+		// 재검증은 실행할때마다 다시 한다.
+		Record.Flags &= ~Validated;
+	}
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Loaded %d cached sessions from %s"), m_Records.Num(), *m_FilePath);
+
+	return true;
+}
+
+bool FMultiplayerSessionCache::Save() const
+{
+	if (m_FilePath.IsEmpty())
+		return false;
+
+	FSessionCacheHeader Header;
+	Header.Magic = Magic;
+	Header.Version = Version;
+	Header.RecordSize = sizeof(FMultiplayerSessionCacheRecord);
+	Header.RecordCount = m_Records.Num();
+
+	TArray<uint8> FileData;
+	FileData.SetNumUninitialized(sizeof(Header) + m_Records.Num() * sizeof(FMultiplayerSessionCacheRecord));
+	FMemory::Memcpy(FileData.GetData(), &Header, sizeof(Header));
+	FMemory::Memcpy(FileData.GetData() + sizeof(Header), m_Records.GetData(), m_Records.Num() * sizeof(FMultiplayerSessionCacheRecord));
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(m_FilePath));
+
+	// 중간에 꺼져도 이전 파일이 남아있도록 임시 파일에 쓰고 바꿔친다.
+	const FString TempFilePath = m_FilePath + TEXT(".tmp");
+	if (!FFileHelper::SaveArrayToFile(FileData, *TempFilePath))
+		return false;
+
+	PlatformFile.DeleteFile(*m_FilePath);
+	return PlatformFile.MoveFile(*m_FilePath, *TempFilePath);
+}
+
+void FMultiplayerSessionCache::RecordSeen(const FString& SessionId, const FString& ConnectAddress, const FString& OwnerName, int32 PingInMs, int32 SessionInfo, int32 OpenSlots)
+{
+	FMultiplayerSessionCacheRecord* Record = FindOrAddRecord(SessionId, false);
+	if (Record == nullptr)
+		return;
+
+	if (!ConnectAddress.IsEmpty())
+	{
+		WriteString(Record->ConnectAddress, FMultiplayerSessionCacheRecord::ConnectAddressSize, ConnectAddress);
+	}
+
+	WriteString(Record->OwnerName, FMultiplayerSessionCacheRecord::OwnerNameSize, OwnerName);
+	Record->LastSeenTicks = FDateTime::UtcNow().GetTicks();
+	Record->PingInMs = PingInMs;
+	Record->SessionInfo = SessionInfo;
+	Record->OpenSlots = OpenSlots;
+	// 검색 결과에 나왔다면 살아있는 세션
+	Record->Flags |= Validated;
+}
+
+void FMultiplayerSessionCache::RecordJoined(const FString& SessionId, const FString& ConnectAddress)
+{
+	FMultiplayerSessionCacheRecord* Record = FindOrAddRecord(SessionId, true);
+	if (Record == nullptr)
+		return;
+
+	WriteString(Record->ConnectAddress, FMultiplayerSessionCacheRecord::ConnectAddressSize, ConnectAddress);
+	Record->LastJoinedTicks = FDateTime::UtcNow().GetTicks();
+	Record->LastSeenTicks = Record->LastJoinedTicks;
+	Record->Flags |= Joined | Validated;
+}
+
+void FMultiplayerSessionCache::MarkValidated(const FString& SessionId, int32 PingInMs, int32 OpenSlots)
+{
+	for (FMultiplayerSessionCacheRecord& Record : m_Records)
+	{
+		if (GetSessionId(Record) == SessionId)
+		{
+			Record.LastSeenTicks = FDateTime::UtcNow().GetTicks();
+			Record.PingInMs = PingInMs;
+			Record.OpenSlots = OpenSlots;
+			Record.Flags |= Validated;
+			return;
+		}
+	}
+}
+
+void FMultiplayerSessionCache::Remove(const FString& SessionId)
+{
+	m_Records.RemoveAll([&SessionId](const FMultiplayerSessionCacheRecord& Record)
+		{
+			return GetSessionId(Record) == SessionId;
+		});
+}
+
+const FMultiplayerSessionCacheRecord* FMultiplayerSessionCache::FindLastJoined() const
+{
+	const FMultiplayerSessionCacheRecord* LastJoined = nullptr;
+
+	for (const FMultiplayerSessionCacheRecord& Record : m_Records)
+	{
+		if ((Record.Flags & Joined) == 0 || Record.ConnectAddress[0] == 0)
+			continue;
+
+		if (LastJoined == nullptr || Record.LastJoinedTicks > LastJoined->LastJoinedTicks)
+		{
+			LastJoined = &Record;
+		}
+	}
+
+	return LastJoined;
+}
+
+TArray<FMultiplayerRecentSession> FMultiplayerSessionCache::GetRecentSessions() const
+{
+	TArray<FMultiplayerRecentSession> RecentSessions;
+	RecentSessions.Reserve(m_Records.Num());
+
+	for (const FMultiplayerSessionCacheRecord& Record : m_Records)
+	{
+		const FMultiplayerSessionInfo SessionInfo = FMultiplayerSessionInfo::Unpack(Record.SessionInfo);
+
+		FMultiplayerRecentSession& RecentSession = RecentSessions.AddDefaulted_GetRef();
+		RecentSession.SessionId = GetSessionId(Record);
+		RecentSession.ConnectAddress = GetConnectAddress(Record);
+		RecentSession.OwnerName = ReadString(Record.OwnerName, FMultiplayerSessionCacheRecord::OwnerNameSize);
+		RecentSession.MatchType = FMultiplayerSessionInfo::MatchTypeToString(SessionInfo.MatchType);
+		RecentSession.PingInMs = Record.PingInMs;
+		RecentSession.OpenSlots = Record.OpenSlots;
+		RecentSession.LastSeen = FDateTime(Record.LastSeenTicks);
+		RecentSession.bJoined = (Record.Flags & Joined) != 0;
+		RecentSession.bValidated = (Record.Flags & Validated) != 0;
+	}
+
+	// 최근에 본 세션이 앞으로
+	RecentSessions.Sort([](const FMultiplayerRecentSession& A, const FMultiplayerRecentSession& B)
+		{
+			return A.LastSeen > B.LastSeen;
+		});
+
+	return RecentSessions;
+}
+
+FString FMultiplayerSessionCache::GetSessionId(const FMultiplayerSessionCacheRecord& Record)
+{
+	return ReadString(Record.SessionId, FMultiplayerSessionCacheRecord::SessionIdSize);
+}
+
+FString FMultiplayerSessionCache::GetConnectAddress(const FMultiplayerSessionCacheRecord& Record)
+{
+	return ReadString(Record.ConnectAddress, FMultiplayerSessionCacheRecord::ConnectAddressSize);
+}
+
+FMultiplayerSessionCacheRecord* FMultiplayerSessionCache::FindOrAddRecord(const FString& SessionId, bool bJoining)
+{
+	if (SessionId.IsEmpty() || SessionId.Len() >= FMultiplayerSessionCacheRecord::SessionIdSize)
+		return nullptr;
+
+	for (FMultiplayerSessionCacheRecord& Record : m_Records)
+	{
+		if (GetSessionId(Record) == SessionId)
+			return &Record;
+	}
+
+	// 꽉 찼다면 가장 오래전에 본 세션을 밀어낸다.
+	// 참가한 세션은 재접속 후보이기 때문에 검색 결과로는 밀어내지 않는다.
+	if (m_Records.Num() >= m_MaxRecords)
+	{
+		int32 OldestIndex = INDEX_NONE;
+		for (int32 Index = 0; Index < m_Records.Num(); ++Index)
+		{
+			if ((m_Records[Index].Flags & Joined) != 0)
+				continue;
+
+			if (OldestIndex == INDEX_NONE || m_Records[Index].LastSeenTicks < m_Records[OldestIndex].LastSeenTicks)
+			{
+				OldestIndex = Index;
+			}
+		}
+
+		// 전부 참가한 세션이라면 새로 참가할때만 가장 오래전에 참가한 세션과 바꾼다.
+		if (OldestIndex == INDEX_NONE && bJoining)
+		{
+			OldestIndex = 0;
+			for (int32 Index = 1; Index < m_Records.Num(); ++Index)
+			{
+				if (m_Records[Index].LastJoinedTicks < m_Records[OldestIndex].LastJoinedTicks)
+				{
+					OldestIndex = Index;
+				}
+			}
+		}
+
+		if (OldestIndex == INDEX_NONE)
+			return nullptr;
+
+		m_Records.RemoveAtSwap(OldestIndex);
+	}
+
+	FMultiplayerSessionCacheRecord& Record = m_Records.AddZeroed_GetRef();
+	WriteString(Record.SessionId, FMultiplayerSessionCacheRecord::SessionIdSize, SessionId);
+
+	return &Record;
+}
+
+void FMultiplayerSessionCache::WriteString(UTF8CHAR* Dest, int32 DestSize, const FString& Source)
+{
+	FMemory::Memzero(Dest, DestSize);
+
+	FTCHARToUTF8 Converted(*Source);
+	int32 Length = FMath::Min(Converted.Length(), DestSize - 1);
+
+	// 잘린 자리가 멀티바이트 문자 중간이라면 그 문자는 통째로 버린다.
+	const uint8* Bytes = reinterpret_cast<const uint8*>(Converted.Get());
+	if (Length < Converted.Length())
+	{
+		while (Length > 0 && (Bytes[Length] & 0xC0) == 0x80)
+		{
+			--Length;
+		}
+	}
+
+	FMemory::Memcpy(Dest, Bytes, Length);
+}
+
+FString FMultiplayerSessionCache::ReadString(const UTF8CHAR* Source, int32 SourceSize)
+{
+	int32 Length = 0;
+	while (Length < SourceSize && Source[Length] != 0)
+	{
+		++Length;
+	}
+
+	const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Source), Length);
+	return FString(Converted.Length(), Converted.Get());
+}
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionEntry.h"
+#include "MultiplayerSessionBrowser.h"
+#include "Components/TextBlock.h"
+
+void UMultiplayerSessionEntry::NativeOnListItemObjectSet(UObject* ListItemObject)
+{
+	IUserObjectListEntry::NativeOnListItemObjectSet(ListItemObject);
+
+	m_Item = Cast<UMultiplayerSessionListItem>(ListItemObject);
+	RefreshFromItem();
+}
+
+void UMultiplayerSessionEntry::RefreshFromItem()
+{
+	if (!m_Item.IsValid())
+		return;
+
+	if (OwnerNameText)
+	{
+		OwnerNameText->SetText(FText::FromString(m_Item->OwnerName));
+	}
+	if (MatchTypeText)
+	{
+		MatchTypeText->SetText(FText::FromString(m_Item->MatchType));
+	}
+	if (OpenSlotsText)
+	{
+		OpenSlotsText->SetText(FText::AsNumber(m_Item->OpenSlots));
+	}
+	if (PingText)
+	{
+		// 캐시 세션은 마지막으로 확인했을때의 핑이라 따로 표시
+		const FString Ping = FString::Printf(m_Item->bFromCache ? TEXT("(%dms)") : TEXT("%dms"), m_Item->PingInMs);
+		PingText->SetText(FText::FromString(Ping));
+	}
+}
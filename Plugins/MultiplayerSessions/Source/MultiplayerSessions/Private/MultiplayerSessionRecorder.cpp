@@ -0,0 +1,526 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionRecorder.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessions.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "TimerManager.h"
+
+namespace
+{
+	struct FSessionRecordingHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 OperationCount;
+		uint32 UncompressedSize;
+	};
+
+	static_assert(sizeof(FSessionRecordingHeader) == 16, "Session recording header layout changed");
+
+	// 헤더가 깨졌을때 이 크기를 믿고 버퍼를 잡지 않도록. 몇 시간 녹화해도 수 MB 수준이다.
+	constexpr uint32 MaxUncompressedSize = 256 * 1024 * 1024;
+	static_assert(MaxUncompressedSize <= static_cast<uint32>(MAX_int32), "Uncompressed size must fit in a TArray");
+
+	// 재생한 검색 결과에 녹화 당시 세션 아이디를 남겨두는 키. 광고되지 않는다.
+	const FName RecordedSessionIdKey(TEXT("MultiplayerSessions.RecordedSessionId"));
+
+	// 값은 문자열로 저장하고 불러올때 원래 타입으로 되돌린다.
+	// Blob은 세션 설정에 사용하지 않아서 담지 않는다.
+	void SerializeVariant(FArchive& Ar, FVariantData& Data)
+	{
+		uint8 Type = static_cast<uint8>(Data.GetType());
+		FString Value;
+		if (Ar.IsSaving())
+		{
+			Value = Data.GetType() == EOnlineKeyValuePairDataType::Blob ? FString() : Data.ToString();
+		}
+
+		Ar << Type << Value;
+
+		if (!Ar.IsLoading())
+			return;
+
+		switch (static_cast<EOnlineKeyValuePairDataType::Type>(Type))
+		{
+		case EOnlineKeyValuePairDataType::Int32:	Data.SetValue(static_cast<int32>(0)); break;
+		case EOnlineKeyValuePairDataType::UInt32:	Data.SetValue(static_cast<uint32>(0)); break;
+		case EOnlineKeyValuePairDataType::Int64:	Data.SetValue(static_cast<int64>(0)); break;
+		case EOnlineKeyValuePairDataType::UInt64:	Data.SetValue(static_cast<uint64>(0)); break;
+		case EOnlineKeyValuePairDataType::Float:	Data.SetValue(0.f); break;
+		case EOnlineKeyValuePairDataType::Double:	Data.SetValue(0.0); break;
+		case EOnlineKeyValuePairDataType::Bool:		Data.SetValue(false); break;
+		case EOnlineKeyValuePairDataType::String:	Data.SetValue(Value); return;
+		case EOnlineKeyValuePairDataType::Json:		Data.SetJsonValueFromString(Value); return;
+		default:									Data.Empty(); return;
+		}
+
+		Data.FromString(Value);
+	}
+
+	void SerializeSettings(FArchive& Ar, FSessionSettings& Settings)
+	{
+		int32 Num = Settings.Num();
+		Ar << Num;
+
+		if (Ar.IsSaving())
+		{
+			for (TPair<FName, FOnlineSessionSetting>& Pair : Settings)
+			{
+				uint8 AdvertisementType = static_cast<uint8>(Pair.Value.AdvertisementType);
+				Ar << Pair.Key;
+				SerializeVariant(Ar, Pair.Value.Data);
+				Ar << AdvertisementType;
+			}
+			return;
+		}
+
+		Settings.Reset();
+		Settings.Reserve(Num);
+		for (int32 Index = 0; Index < Num && !Ar.IsError(); ++Index)
+		{
+			FName Key;
+			FOnlineSessionSetting Setting;
+			uint8 AdvertisementType = 0;
+			Ar << Key;
+			SerializeVariant(Ar, Setting.Data);
+			Ar << AdvertisementType;
+
+			Setting.AdvertisementType = static_cast<EOnlineDataAdvertisementType::Type>(AdvertisementType);
+			Settings.Add(Key, MoveTemp(Setting));
+		}
+	}
+
+	FString GetDefaultRecordingPath()
+	{
+		return FPaths::ProjectSavedDir() / TEXT("MultiplayerSessions") / TEXT("Recording.mpsr");
+	}
+
+	UMultiplayerSessionsSubsystem* GetSubsystem(UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		return GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs RecordCommand(
+		TEXT("MultiplayerSessions.Record"),
+		TEXT("Records session backend traffic to a file. Usage: MultiplayerSessions.Record [File|Stop]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UMultiplayerSessionsSubsystem* Subsystem = GetSubsystem(World);
+			if (Subsystem == nullptr)
+				return;
+
+			if (Args.Num() > 0 && Args[0] == TEXT("Stop"))
+			{
+				Subsystem->StopRecording();
+				return;
+			}
+
+			Subsystem->StartRecording(Args.Num() > 0 ? Args[0] : GetDefaultRecordingPath());
+		}));
+
+	FAutoConsoleCommandWithWorldAndArgs ReplayCommand(
+		TEXT("MultiplayerSessions.Replay"),
+		TEXT("Replays a recording instead of the session backend. Usage: MultiplayerSessions.Replay [File|Stop] [Timed]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UMultiplayerSessionsSubsystem* Subsystem = GetSubsystem(World);
+			if (Subsystem == nullptr)
+				return;
+
+			if (Args.Num() > 0 && Args[0] == TEXT("Stop"))
+			{
+				Subsystem->StopReplay();
+				return;
+			}
+
+			const bool bUseRecordedTiming = Args.Num() > 1 && Args[1] == TEXT("Timed");
+			Subsystem->StartReplay(Args.Num() > 0 ? Args[0] : GetDefaultRecordingPath(), bUseRecordedTiming);
+		}));
+
+	FAutoConsoleCommandWithWorldAndArgs SearchMashCommand(
+		TEXT("MultiplayerSessions.SearchMash"),
+		TEXT("Mashes the search button against a replayed backend and checks the searches sent stay within the search throttle. Usage: MultiplayerSessions.SearchMash [Seconds] [ClicksPerSecond]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UMultiplayerSessionsSubsystem* Subsystem = GetSubsystem(World);
+			if (Subsystem == nullptr)
+				return;
+
+			const float Seconds = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 20.f;
+			const float ClicksPerSecond = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 10.f;
+			Subsystem->StartSearchMash(Seconds, ClicksPerSecond);
+		}));
+}
+
+FArchive& operator<<(FArchive& Ar, FMultiplayerRecordedResult& Result)
+{
+	Ar << Result.SessionId;
+	Ar << Result.OwnerName;
+	Ar << Result.PingInMs;
+	Ar << Result.NumOpenPublicConnections;
+	Ar << Result.NumPublicConnections;
+	Ar << Result.BuildUniqueId;
+	SerializeSettings(Ar, Result.Settings);
+
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FMultiplayerRecordedOperation& Operation)
+{
+	uint8 Op = static_cast<uint8>(Operation.Op);
+	Ar << Op;
+	Operation.Op = static_cast<EMultiplayerRecordedOp>(Op);
+
+	Ar << Operation.StartTime;
+	Ar << Operation.Duration;
+	Ar << Operation.Result;
+	Ar << Operation.IntParam;
+	Ar << Operation.StringParam;
+	Ar << Operation.Results;
+
+	return Ar;
+}
+
+FMultiplayerSessionRecorder::FMultiplayerSessionRecorder(const FString& InFilePath) :
+	m_FilePath(InFilePath),
+	m_StartTime(FPlatformTime::Seconds())
+{
+	for (int32& PendingIndex : m_PendingOperations)
+	{
+		PendingIndex = INDEX_NONE;
+	}
+}
+
+void FMultiplayerSessionRecorder::BeginOperation(EMultiplayerRecordedOp Op, int32 IntParam, const FString& StringParam)
+{
+	FMultiplayerRecordedOperation& Operation = m_Operations.AddDefaulted_GetRef();
+	Operation.Op = Op;
+	Operation.StartTime = FPlatformTime::Seconds() - m_StartTime;
+	Operation.IntParam = IntParam;
+	Operation.StringParam = StringParam;
+
+	m_PendingOperations[static_cast<int32>(Op)] = m_Operations.Num() - 1;
+}
+
+void FMultiplayerSessionRecorder::EndOperation(EMultiplayerRecordedOp Op, int32 Result, const FOnlineSessionSearch* Search)
+{
+	int32& PendingIndex = m_PendingOperations[static_cast<int32>(Op)];
+	if (!m_Operations.IsValidIndex(PendingIndex))
+		return;
+
+	FMultiplayerRecordedOperation& Operation = m_Operations[PendingIndex];
+	PendingIndex = INDEX_NONE;
+
+	Operation.Duration = static_cast<float>(FPlatformTime::Seconds() - m_StartTime - Operation.StartTime);
+	Operation.Result = Result;
+
+	if (Search)
+	{
+		Operation.Results.Reserve(Search->SearchResults.Num());
+		for (const FOnlineSessionSearchResult& SearchResult : Search->SearchResults)
+		{
+			Operation.Results.Add(CaptureResult(SearchResult));
+		}
+	}
+}
+
+bool FMultiplayerSessionRecorder::Save() const
+{
+	if (m_FilePath.IsEmpty())
+		return false;
+
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+	Writer << const_cast<TArray<FMultiplayerRecordedOperation>&>(m_Operations);
+
+	// 검색 결과는 키와 값이 반복되기 때문에 압축하면 크게 줄어든다.
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Payload.Num());
+	TArray<uint8> FileData;
+	FileData.SetNumUninitialized(sizeof(FSessionRecordingHeader) + CompressedSize);
+
+	if (!FCompression::CompressMemory(NAME_Zlib, FileData.GetData() + sizeof(FSessionRecordingHeader), CompressedSize, Payload.GetData(), Payload.Num()))
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Failed to compress session recording %s"), *m_FilePath);
+		return false;
+	}
+
+	FSessionRecordingHeader Header;
+	Header.Magic = Magic;
+	Header.Version = Version;
+	Header.OperationCount = m_Operations.Num();
+	Header.UncompressedSize = Payload.Num();
+	FMemory::Memcpy(FileData.GetData(), &Header, sizeof(Header));
+	FileData.SetNum(sizeof(FSessionRecordingHeader) + CompressedSize);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(m_FilePath));
+
+	if (!FFileHelper::SaveArrayToFile(FileData, *m_FilePath))
+		return false;
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Saved %d recorded session operations to %s (%d bytes, %d uncompressed)"),
+		m_Operations.Num(), *m_FilePath, FileData.Num(), Payload.Num());
+
+	return true;
+}
+
+bool FMultiplayerSessionRecorder::Load(const FString& FilePath, TArray<FMultiplayerRecordedOperation>& OutOperations)
+{
+	OutOperations.Reset();
+
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath) || FileData.Num() < static_cast<int32>(sizeof(FSessionRecordingHeader)))
+		return false;
+
+	FSessionRecordingHeader Header;
+	FMemory::Memcpy(&Header, FileData.GetData(), sizeof(Header));
+
+	if (Header.Magic != Magic || Header.Version != Version)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Unsupported session recording %s (version %u)"), *FilePath, Header.Version);
+		return false;
+	}
+
+	if (Header.UncompressedSize == 0 || Header.UncompressedSize > MaxUncompressedSize)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Session recording %s is corrupted (uncompressed size %u)"), *FilePath, Header.UncompressedSize);
+		return false;
+	}
+
+	TArray<uint8> Payload;
+	Payload.SetNumUninitialized(static_cast<int32>(Header.UncompressedSize));
+
+	const int32 CompressedSize = FileData.Num() - sizeof(FSessionRecordingHeader);
+	if (!FCompression::UncompressMemory(NAME_Zlib, Payload.GetData(), Payload.Num(), FileData.GetData() + sizeof(FSessionRecordingHeader), CompressedSize))
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Session recording %s is corrupted"), *FilePath);
+		return false;
+	}
+
+	FMemoryReader Reader(Payload);
+	Reader << OutOperations;
+
+	if (Reader.IsError() || OutOperations.Num() != static_cast<int32>(Header.OperationCount))
+	{
+		OutOperations.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+FMultiplayerRecordedResult FMultiplayerSessionRecorder::CaptureResult(const FOnlineSessionSearchResult& SearchResult)
+{
+	const FOnlineSession& Session = SearchResult.Session;
+
+	FMultiplayerRecordedResult Recorded;
+	Recorded.SessionId = GetRecordedSessionId(SearchResult);
+	Recorded.OwnerName = Session.OwningUserName;
+	Recorded.PingInMs = SearchResult.PingInMs;
+	Recorded.NumOpenPublicConnections = Session.NumOpenPublicConnections;
+	Recorded.NumPublicConnections = Session.SessionSettings.NumPublicConnections;
+	Recorded.BuildUniqueId = Session.SessionSettings.BuildUniqueId;
+	Recorded.Settings = Session.SessionSettings.Settings;
+	Recorded.Settings.Remove(RecordedSessionIdKey);
+
+	return Recorded;
+}
+
+FOnlineSessionSearchResult FMultiplayerSessionRecorder::RestoreResult(const FMultiplayerRecordedResult& Recorded)
+{
+	FOnlineSessionSearchResult SearchResult;
+	SearchResult.PingInMs = Recorded.PingInMs;
+
+	FOnlineSession& Session = SearchResult.Session;
+	Session.OwningUserName = Recorded.OwnerName;
+	Session.NumOpenPublicConnections = Recorded.NumOpenPublicConnections;
+	Session.SessionSettings.NumPublicConnections = Recorded.NumPublicConnections;
+	Session.SessionSettings.BuildUniqueId = Recorded.BuildUniqueId;
+	Session.SessionSettings.Settings = Recorded.Settings;
+	Session.SessionSettings.Settings.Add(RecordedSessionIdKey, FOnlineSessionSetting(Recorded.SessionId, EOnlineDataAdvertisementType::DontAdvertise));
+
+	return SearchResult;
+}
+
+FString FMultiplayerSessionRecorder::GetRecordedSessionId(const FOnlineSessionSearchResult& SearchResult)
+{
+	if (const FOnlineSessionSetting* Setting = SearchResult.Session.SessionSettings.Settings.Find(RecordedSessionIdKey))
+		return Setting->Data.ToString();
+
+	return SearchResult.GetSessionIdStr();
+}
+
+FString FMultiplayerSessionRecorder::DescribeQuery(const FOnlineSessionSearch& Search)
+{
+	FString Description = FString::Printf(TEXT("Lan=%d"), Search.bIsLanQuery ? 1 : 0);
+
+	for (const TPair<FName, FOnlineSessionSearchParam>& Pair : Search.QuerySettings.SearchParams)
+	{
+		Description += FString::Printf(TEXT(" %s%s%s"), *Pair.Key.ToString(),
+			EOnlineComparisonOp::ToString(Pair.Value.ComparisonOp), *Pair.Value.Data.ToString());
+	}
+
+	return Description;
+}
+
+bool FMultiplayerSessionReplay::Load(const FString& FilePath, bool bInUseRecordedTiming)
+{
+	m_FilePath = FilePath;
+	m_bUseRecordedTiming = bInUseRecordedTiming;
+	m_NextFind = 0;
+	m_NextJoin = 0;
+	m_NumReplayedFinds = 0;
+	m_NumReplayedJoins = 0;
+	m_NumJoinMismatches = 0;
+
+	if (!FMultiplayerSessionRecorder::Load(FilePath, m_Operations))
+		return false;
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Replaying %d recorded session operations from %s"), m_Operations.Num(), *FilePath);
+
+	return true;
+}
+
+void FMultiplayerSessionReplay::SetOperations(TArray<FMultiplayerRecordedOperation>&& Operations, bool bInUseRecordedTiming, bool bInLoop)
+{
+	m_FilePath = TEXT("(in memory)");
+	m_Operations = MoveTemp(Operations);
+	m_bUseRecordedTiming = bInUseRecordedTiming;
+	m_bLoop = bInLoop;
+	m_NextFind = 0;
+	m_NextJoin = 0;
+	m_NumReplayedFinds = 0;
+	m_NumReplayedJoins = 0;
+	m_NumJoinMismatches = 0;
+}
+
+bool FMultiplayerSessionReplay::FindSessions(const IOnlineSessionPtr& SessionInterface, const TSharedRef<FOnlineSessionSearch>& Search, FTimerManager& TimerManager)
+{
+	const FMultiplayerRecordedOperation* Operation = NextOperation(EMultiplayerRecordedOp::Find, m_NextFind);
+	if (Operation == nullptr || !SessionInterface.IsValid())
+		return false;
+
+	++m_NumReplayedFinds;
+
+	TWeakPtr<IOnlineSession, ESPMode::ThreadSafe> WeakSessionInterface = SessionInterface;
+	TWeakPtr<FOnlineSessionSearch> WeakSearch = Search;
+	const bool bWasSuccessful = Operation->Result != 0;
+	// 응답 전에 재생을 멈춰도 되도록 결과는 복사해서 넘긴다.
+	TArray<FMultiplayerRecordedResult> Results = Operation->Results;
+
+	Search->SearchState = EOnlineAsyncTaskState::InProgress;
+
+	// 결과는 응답하는 순간에 채운다. 실제 백엔드도 완료 전까지는 결과가 비어있다.
+	Schedule(TimerManager, Operation->Duration, [WeakSessionInterface, WeakSearch, bWasSuccessful, Results = MoveTemp(Results)]()
+		{
+			TSharedPtr<IOnlineSession, ESPMode::ThreadSafe> PinnedSessionInterface = WeakSessionInterface.Pin();
+			if (!PinnedSessionInterface.IsValid())
+				return;
+
+			if (TSharedPtr<FOnlineSessionSearch> PinnedSearch = WeakSearch.Pin())
+			{
+				PinnedSearch->SearchResults.Reset(Results.Num());
+				for (const FMultiplayerRecordedResult& Recorded : Results)
+				{
+					PinnedSearch->SearchResults.Add(FMultiplayerSessionRecorder::RestoreResult(Recorded));
+				}
+
+				PinnedSearch->SearchState = bWasSuccessful ? EOnlineAsyncTaskState::Done : EOnlineAsyncTaskState::Failed;
+			}
+
+			PinnedSessionInterface->TriggerOnFindSessionsCompleteDelegates(bWasSuccessful);
+		});
+
+	return true;
+}
+
+bool FMultiplayerSessionReplay::JoinSession(const IOnlineSessionPtr& SessionInterface, const FOnlineSessionSearchResult& SessionResult, FTimerManager& TimerManager)
+{
+	const FMultiplayerRecordedOperation* Operation = NextOperation(EMultiplayerRecordedOp::Join, m_NextJoin);
+	if (Operation == nullptr || !SessionInterface.IsValid())
+		return false;
+
+	++m_NumReplayedJoins;
+
+	const FString SessionId = FMultiplayerSessionRecorder::GetRecordedSessionId(SessionResult);
+	if (SessionId != Operation->StringParam)
+	{
+		++m_NumJoinMismatches;
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Replay join %d picked %s, recording joined %s"), m_NumReplayedJoins, *SessionId, *Operation->StringParam);
+	}
+
+	TWeakPtr<IOnlineSession, ESPMode::ThreadSafe> WeakSessionInterface = SessionInterface;
+	const EOnJoinSessionCompleteResult::Type Result = static_cast<EOnJoinSessionCompleteResult::Type>(Operation->Result);
+
+	Schedule(TimerManager, Operation->Duration, [WeakSessionInterface, Result]()
+		{
+			if (TSharedPtr<IOnlineSession, ESPMode::ThreadSafe> PinnedSessionInterface = WeakSessionInterface.Pin())
+			{
+				PinnedSessionInterface->TriggerOnJoinSessionCompleteDelegates(NAME_GameSession, Result);
+			}
+		});
+
+	return true;
+}
+
+bool FMultiplayerSessionReplay::IsFinished() const
+{
+	int32 FindCursor = m_NextFind;
+	int32 JoinCursor = m_NextJoin;
+
+	return NextOperation(EMultiplayerRecordedOp::Find, FindCursor) == nullptr
+		&& NextOperation(EMultiplayerRecordedOp::Join, JoinCursor) == nullptr;
+}
+
+void FMultiplayerSessionReplay::LogSummary() const
+{
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Replay of %s: %d searches, %d joins, %d joins picked a different session than recorded"),
+		*m_FilePath, m_NumReplayedFinds, m_NumReplayedJoins, m_NumJoinMismatches);
+}
+
+const FMultiplayerRecordedOperation* FMultiplayerSessionReplay::NextOperation(EMultiplayerRecordedOp Op, int32& Cursor) const
+{
+	while (m_Operations.IsValidIndex(Cursor))
+	{
+		const FMultiplayerRecordedOperation& Operation = m_Operations[Cursor++];
+		if (Operation.Op == Op)
+			return &Operation;
+	}
+
+	// 반복 재생이라면 처음부터 한번 더 찾는다.
+	if (m_bLoop)
+	{
+		for (Cursor = 0; m_Operations.IsValidIndex(Cursor);)
+		{
+			const FMultiplayerRecordedOperation& Operation = m_Operations[Cursor++];
+			if (Operation.Op == Op)
+				return &Operation;
+		}
+	}
+
+	return nullptr;
+}
+
+void FMultiplayerSessionReplay::Schedule(FTimerManager& TimerManager, float Duration, TFunction<void()>&& Respond) const
+{
+	// 실제 백엔드처럼 요청한 함수가 반환된 뒤에 응답한다.
+	if (!m_bUseRecordedTiming || Duration <= 0.f)
+	{
+		TimerManager.SetTimerForNextTick(MoveTemp(Respond));
+		return;
+	}
+
+	FTimerHandle TimerHandle;
+	TimerManager.SetTimer(TimerHandle, FTimerDelegate::CreateLambda(MoveTemp(Respond)), Duration, false);
+}
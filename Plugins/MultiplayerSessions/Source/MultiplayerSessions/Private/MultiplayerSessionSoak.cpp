@@ -0,0 +1,343 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionSoak.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerSessions.h"
+#include "Menu.h"
+#include "Blueprint/UserWidget.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "TimerManager.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	// 소크 테스트에서 만드는 세션. 다른 매치 타입으로 검색하는 클라이언트에게는 보이지 않는다.
+	const FString SoakMatchType(TEXT("Soak"));
+	constexpr int32 SoakNumPublicConnections{ 2 };
+
+	FAutoConsoleCommandWithWorldAndArgs SoakCommand(
+		TEXT("MultiplayerSessions.Soak"),
+		TEXT("Repeats menu/host/lobby/destroy cycles and reports latency and leaks. Usage: MultiplayerSessions.Soak [Cycles] [LobbyPath]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+			UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+			if (Subsystem == nullptr)
+				return;
+
+			const int32 Cycles = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+			if (Args.Num() > 1)
+			{
+				Subsystem->StartSoak(Cycles, Args[1]);
+			}
+			else
+			{
+				Subsystem->StartSoak(Cycles);
+			}
+		}));
+}
+
+bool UMultiplayerSessionSoak::Start(UMultiplayerSessionsSubsystem* Subsystem, int32 Cycles, const FString& LobbyPath)
+{
+	if (m_bRunning || Subsystem == nullptr || Cycles <= WarmupCycles)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Soak not started, needs more than %d cycles and no soak running"), WarmupCycles);
+		return false;
+	}
+
+	if (Subsystem->GetPendingOnlineCallbackCount() > 0)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Soak not started, a session request is in progress"));
+		return false;
+	}
+
+	// 첫 사이클의 생성이 지금 세션을 지워버린다.
+	if (Subsystem->HasSession())
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Soak not started, destroy the current session first"));
+		return false;
+	}
+
+	// 로비로 ServerTravel 하려면 호스트여야 한다.
+	UWorld* World = Subsystem->GetWorld();
+	if (World == nullptr || World->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Soak not started, run it from the menu map as standalone or host"));
+		return false;
+	}
+
+	// 게임 인스턴스를 아우터로 만들어져서 맵을 옮겨도 같은 메뉴를 계속 쓸 수 있다.
+	m_Menu = CreateWidget<UMenu>(World, UMenu::StaticClass());
+	if (m_Menu == nullptr)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Soak not started, failed to create the menu"));
+		return false;
+	}
+
+	m_Subsystem = Subsystem;
+	m_bRunning = true;
+	m_Phase = ESoakPhase::None;
+	m_MenuMapPath = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+	m_LobbyPath = LobbyPath;
+	m_NumCycles = Cycles;
+	m_CurrentCycle = 0;
+	m_NumFailures = 0;
+	m_MinLatency = TNumericLimits<double>::Max();
+	m_MaxLatency = 0.0;
+	m_TotalLatency = 0.0;
+	// 워밍업 전에 끝나도 비교할 수 있도록 시작 값으로 채워둔다.
+	m_BaselineMemory = FPlatformMemory::GetStats().UsedPhysical;
+	m_BaselineListeners = Subsystem->GetDelegateListenerCount();
+	m_BaselineCallbacks = 0;
+
+	Subsystem->MultiplayerOnCreateSessionComplete.AddDynamic(this, &ThisClass::OnCreateSessionComplete);
+	Subsystem->MultiplayerOnStartSessionComplete.AddDynamic(this, &ThisClass::OnStartSessionComplete);
+	Subsystem->MultiplayerOnDestroySessionComplete.AddDynamic(this, &ThisClass::OnDestroySessionComplete);
+	m_PostLoadMapDelegateHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMap);
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Soak started, %d cycles between %s and %s"), Cycles, *m_MenuMapPath, *m_LobbyPath);
+
+	BeginCycle();
+	return true;
+}
+
+void UMultiplayerSessionSoak::Stop()
+{
+	if (!m_bRunning)
+		return;
+
+	m_bRunning = false;
+	m_Phase = ESoakPhase::None;
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(m_PostLoadMapDelegateHandle);
+
+	if (FTimerManager* TimerManager = GetTimerManager())
+	{
+		TimerManager->ClearTimer(m_CycleTimerHandle);
+	}
+
+	if (m_Subsystem.IsValid())
+	{
+		m_Subsystem->MultiplayerOnCreateSessionComplete.RemoveDynamic(this, &ThisClass::OnCreateSessionComplete);
+		m_Subsystem->MultiplayerOnStartSessionComplete.RemoveDynamic(this, &ThisClass::OnStartSessionComplete);
+		m_Subsystem->MultiplayerOnDestroySessionComplete.RemoveDynamic(this, &ThisClass::OnDestroySessionComplete);
+	}
+
+	// 사이클 중간에 멈췄다면 메뉴가 떠있을 수 있다.
+	if (m_Menu)
+	{
+		m_Menu->MenuTearDown();
+		m_Menu = nullptr;
+	}
+}
+
+void UMultiplayerSessionSoak::BeginCycle()
+{
+	FTimerManager* TimerManager = GetTimerManager();
+	if (!m_Subsystem.IsValid() || TimerManager == nullptr)
+	{
+		Stop();
+		return;
+	}
+
+	m_CycleStartTime = FPlatformTime::Seconds();
+	TimerManager->SetTimer(m_CycleTimerHandle, this, &ThisClass::OnCycleTimeout, CycleTimeout, false);
+
+	m_Phase = ESoakPhase::Hosting;
+	m_bSessionStarted = false;
+	m_bLobbyLoaded = false;
+	m_bCycleSucceeded = true;
+
+	// 호스트 버튼을 누른 것과 같다. 생성에 성공하면 메뉴가 로비로 이동하고, 레벨이 내려갈때 스스로 닫힌다.
+	// 닫을때 메뉴의 바인딩이 모두 풀리지 않았다면 리스너 수가 사이클마다 늘어난다.
+	if (m_Menu)
+	{
+		m_Menu->MenuSetup(SoakNumPublicConnections, SoakMatchType, m_LobbyPath);
+	}
+
+	m_Subsystem->CreateSession(SoakNumPublicConnections, SoakMatchType);
+}
+
+void UMultiplayerSessionSoak::EndCycle(bool bWasSuccessful)
+{
+	FTimerManager* TimerManager = GetTimerManager();
+	if (TimerManager == nullptr || !m_Subsystem.IsValid())
+	{
+		Stop();
+		return;
+	}
+
+	TimerManager->ClearTimer(m_CycleTimerHandle);
+	m_Phase = ESoakPhase::None;
+
+	const double Latency = FPlatformTime::Seconds() - m_CycleStartTime;
+	m_MinLatency = FMath::Min(m_MinLatency, Latency);
+	m_MaxLatency = FMath::Max(m_MaxLatency, Latency);
+	m_TotalLatency += Latency;
+	if (!bWasSuccessful)
+	{
+		++m_NumFailures;
+	}
+
+	++m_CurrentCycle;
+
+	if (m_CurrentCycle == WarmupCycles)
+	{
+		m_BaselineMemory = FPlatformMemory::GetStats().UsedPhysical;
+		m_BaselineListeners = m_Subsystem->GetDelegateListenerCount();
+		m_BaselineCallbacks = m_Subsystem->GetPendingOnlineCallbackCount();
+	}
+	else if (m_CurrentCycle % LogInterval == 0)
+	{
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Soak %d/%d, failures %d, avg %.1fms, listeners %d, pending callbacks %d"),
+			m_CurrentCycle, m_NumCycles, m_NumFailures, m_TotalLatency / m_CurrentCycle * 1000.0,
+			m_Subsystem->GetDelegateListenerCount(), m_Subsystem->GetPendingOnlineCallbackCount());
+	}
+
+	if (m_CurrentCycle >= m_NumCycles)
+	{
+		Finish();
+		return;
+	}
+
+	// NULL 서브시스템은 콜백을 바로 호출하기 때문에 여기서 다음 사이클을 시작하면 스택이 계속 깊어진다.
+	TimerManager->SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &ThisClass::BeginCycle));
+}
+
+void UMultiplayerSessionSoak::Finish()
+{
+	if (!m_Subsystem.IsValid())
+	{
+		Stop();
+		return;
+	}
+
+	const int32 Listeners = m_Subsystem->GetDelegateListenerCount();
+	const int32 Callbacks = m_Subsystem->GetPendingOnlineCallbackCount();
+	const int64 MemoryGrowth = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical) - static_cast<int64>(m_BaselineMemory);
+
+	Stop();
+
+	const bool bLeaked = Listeners > m_BaselineListeners
+		|| Callbacks > m_BaselineCallbacks
+		|| MemoryGrowth > static_cast<int64>(MaxMemoryGrowth);
+	const bool bPassed = !bLeaked && m_NumFailures == 0;
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Soak %s: %d cycles, %d failures, latency min %.1fms avg %.1fms max %.1fms"),
+		bPassed ? TEXT("PASSED") : TEXT("FAILED"), m_CurrentCycle, m_NumFailures,
+		m_CurrentCycle > 0 ? m_MinLatency * 1000.0 : 0.0, m_TotalLatency / FMath::Max(m_CurrentCycle, 1) * 1000.0, m_MaxLatency * 1000.0);
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Soak listeners %d -> %d, pending callbacks %d -> %d, memory growth %.1fMB"),
+		m_BaselineListeners, Listeners, m_BaselineCallbacks, Callbacks, MemoryGrowth / (1024.0 * 1024.0));
+
+	if (bLeaked)
+	{
+		UE_LOG(LogMultiplayerSessions, Error, TEXT("Soak detected growth after warmup, check delegate handles and search results"));
+	}
+}
+
+void UMultiplayerSessionSoak::OnCycleTimeout()
+{
+	// 콜백이 오지 않았다면 핸들이 덮어써졌거나 요청이 사라진 것. 더 돌려도 같은 자리에서 멈춘다.
+	// 멈춘 곳까지의 결과는 남겨야 원인을 찾을 수 있다.
+	UE_LOG(LogMultiplayerSessions, Error, TEXT("Soak cycle %d timed out, pending callbacks %d"),
+		m_CurrentCycle, m_Subsystem.IsValid() ? m_Subsystem->GetPendingOnlineCallbackCount() : 0);
+
+	++m_NumFailures;
+	Finish();
+}
+
+void UMultiplayerSessionSoak::OnCreateSessionComplete(bool bWasSuccessful)
+{
+	if (!m_bRunning || !m_Subsystem.IsValid())
+		return;
+
+	if (!bWasSuccessful)
+	{
+		// 메뉴는 로비로 이동하지 않았기 때문에 그대로 떠있다.
+		if (m_Menu)
+		{
+			m_Menu->MenuTearDown();
+		}
+		EndCycle(false);
+		return;
+	}
+
+	m_Phase = ESoakPhase::TravellingToLobby;
+	m_Subsystem->StartSession();
+}
+
+void UMultiplayerSessionSoak::OnStartSessionComplete(bool bWasSuccessful)
+{
+	if (!m_bRunning || !m_Subsystem.IsValid())
+		return;
+
+	if (!bWasSuccessful)
+	{
+		m_bCycleSucceeded = false;
+	}
+
+	// 시작에 실패해도 세션은 남아있기 때문에 파괴는 한다.
+	m_bSessionStarted = true;
+	DestroyInLobby();
+}
+
+void UMultiplayerSessionSoak::OnDestroySessionComplete(bool bWasSuccessful)
+{
+	if (!m_bRunning || m_Phase != ESoakPhase::Destroying)
+		return;
+
+	if (!bWasSuccessful)
+	{
+		m_bCycleSucceeded = false;
+	}
+
+	UWorld* World = m_Subsystem.IsValid() ? m_Subsystem->GetWorld() : nullptr;
+	if (World == nullptr)
+	{
+		EndCycle(false);
+		return;
+	}
+
+	// 메뉴 맵을 다시 불러와야 다음 사이클의 메뉴가 처음과 같은 상태에서 시작한다.
+	m_Phase = ESoakPhase::Returning;
+	World->ServerTravel(m_MenuMapPath);
+}
+
+void UMultiplayerSessionSoak::DestroyInLobby()
+{
+	if (m_Phase != ESoakPhase::TravellingToLobby || !m_bSessionStarted || !m_bLobbyLoaded || !m_Subsystem.IsValid())
+		return;
+
+	m_Phase = ESoakPhase::Destroying;
+	m_Subsystem->DestroySession();
+}
+
+void UMultiplayerSessionSoak::OnPostLoadMap(UWorld* World)
+{
+	if (!m_bRunning)
+		return;
+
+	switch (m_Phase)
+	{
+	case ESoakPhase::TravellingToLobby:
+		m_bLobbyLoaded = true;
+		DestroyInLobby();
+		break;
+
+	case ESoakPhase::Returning:
+		EndCycle(m_bCycleSucceeded);
+		break;
+
+	default:
+		break;
+	}
+}
+
+FTimerManager* UMultiplayerSessionSoak::GetTimerManager() const
+{
+	UGameInstance* GameInstance = m_Subsystem.IsValid() ? m_Subsystem->GetGameInstance() : nullptr;
+	return GameInstance ? &GameInstance->GetTimerManager() : nullptr;
+}
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerSessionTypes.h"
+
+const TMultiplayerSessionKey<int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing> FMultiplayerSessionKeys::SessionInfo(TEXT("SessionInfo"));
+const TMultiplayerSessionKey<FString, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing> FMultiplayerSessionKeys::MatchType(TEXT("MatchType"));
+const TMultiplayerSessionKey<int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing> FMultiplayerSessionKeys::OpenSlots(TEXT("OpenSlots"));
+const TMultiplayerSessionKey<int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing> FMultiplayerSessionKeys::Skill(TEXT("Skill"));
+const TMultiplayerSessionKey<int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing> FMultiplayerSessionKeys::BuildId(TEXT("BuildId"));
+const TMultiplayerSessionKey<int32, EOnlineDataAdvertisementType::ViaOnlineService> FMultiplayerSessionKeys::BeaconPort(TEXT("BEACONPORT"));
+
+int32 FMultiplayerSessionInfo::Pack() const
+{
+	return static_cast<int32>(MatchType) |
+		(static_cast<int32>(Region) << 8) |
+		(static_cast<int32>(State) << 16);
+}
+
+FMultiplayerSessionInfo FMultiplayerSessionInfo::Unpack(int32 Packed)
+{
+	FMultiplayerSessionInfo Info;
+	Info.MatchType = static_cast<EMultiplayerMatchType>(Packed & 0xFF);
+	Info.Region = static_cast<EMultiplayerRegion>((Packed >> 8) & 0xFF);
+	Info.State = static_cast<EMultiplayerSessionState>((Packed >> 16) & 0xFF);
+
+	return Info;
+}
+
+EMultiplayerMatchType FMultiplayerSessionInfo::MatchTypeFromString(const FString& MatchType)
+{
+	const int64 Value = StaticEnum<EMultiplayerMatchType>()->GetValueByNameString(MatchType);
+
+	return Value == INDEX_NONE ? EMultiplayerMatchType::Custom : static_cast<EMultiplayerMatchType>(Value);
+}
+
+FString FMultiplayerSessionInfo::MatchTypeToString(EMultiplayerMatchType MatchType)
+{
+	return StaticEnum<EMultiplayerMatchType>()->GetNameStringByValue(static_cast<int64>(MatchType));
+}
+
+void FMultiplayerSessionInfo::Write(FOnlineSessionSettings& Settings, const FString& MatchTypeString) const
+{
+	FMultiplayerSessionKeys::SessionInfo.Set(Settings, Pack());
+
+	if (MatchType == EMultiplayerMatchType::Custom)
+	{
+		FMultiplayerSessionKeys::MatchType.Set(Settings, MatchTypeString);
+	}
+	else
+	{
+		FMultiplayerSessionKeys::MatchType.Remove(Settings);
+	}
+}
+
+FMultiplayerSessionInfo FMultiplayerSessionInfo::Read(const FOnlineSessionSettings& Settings)
+{
+	return Unpack(FMultiplayerSessionKeys::SessionInfo.GetOr(Settings, 0));
+}
+
+FString FMultiplayerSessionInfo::ReadMatchType(const FOnlineSessionSettings& Settings)
+{
+	const FMultiplayerSessionInfo Info = Read(Settings);
+
+	if (Info.MatchType != EMultiplayerMatchType::Custom)
+		return MatchTypeToString(Info.MatchType);
+
+	FString MatchType;
+	FMultiplayerSessionKeys::MatchType.Get(Settings, MatchType);
+
+	return MatchType;
+}
+
+FMultiplayerSessionResult::FMultiplayerSessionResult(const FOnlineSessionSearchResult& InResult) :
+	OwnerName(InResult.Session.OwningUserName),
+	PingInMs(InResult.PingInMs),
+	OnlineResult(InResult)
+{
+	MatchType = FMultiplayerSessionInfo::ReadMatchType(InResult.Session.SessionSettings);
+
+	OpenSlots = FMultiplayerSessionKeys::OpenSlots.GetOr(InResult.Session.SessionSettings, InResult.Session.NumOpenPublicConnections);
+}
+
+const TCHAR* FMultiplayerAdmission::BuildOption = TEXT("Build");
+
+namespace MultiplayerAdmission
+{
+	// 엔진이 보내는 다른 에러 메시지와 구분하기 위한 접두사
+	static const TCHAR* RejectPrefix = TEXT("MultiplayerSessions.Rejected:");
+}
+
+FString FMultiplayerAdmission::MakeRejectMessage(EMultiplayerAdmissionResult Result)
+{
+	return MultiplayerAdmission::RejectPrefix + StaticEnum<EMultiplayerAdmissionResult>()->GetNameStringByValue(static_cast<int64>(Result));
+}
+
+bool FMultiplayerAdmission::ParseRejectMessage(const FString& ErrorMessage, EMultiplayerAdmissionResult& OutResult)
+{
+	if (!ErrorMessage.StartsWith(MultiplayerAdmission::RejectPrefix))
+		return false;
+
+	const FString ResultName = ErrorMessage.RightChop(FCString::Strlen(MultiplayerAdmission::RejectPrefix));
+	const int64 Value = StaticEnum<EMultiplayerAdmissionResult>()->GetValueByNameString(ResultName);
+	if (Value == INDEX_NONE || Value == static_cast<int64>(EMultiplayerAdmissionResult::Accepted))
+		return false;
+
+	OutResult = static_cast<EMultiplayerAdmissionResult>(Value);
+	return true;
+}
@@ -2,15 +2,67 @@
 
 
 #include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerMatchmaker.h"
+#include "MultiplayerLanDiscovery.h"
+#include "MultiplayerSessionCache.h"
+#include "MultiplayerSessionRecorder.h"
+#include "MultiplayerSessionSoak.h"
+#include "MultiplayerNetSweep.h"
+#include "MultiplayerSearchResultProcessor.h"
+#include "MultiplayerSessions.h"
 #include "OnlineSubsystem.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/NetworkVersion.h"
 #include "OnlineSessionSettings.h"
+#include "Engine/GameInstance.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "IPAddress.h"
+#include "OnlineBeaconHost.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "TimerManager.h"
+#include "UObject/UObjectGlobals.h"
+#include "Misc/Paths.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Math/RandomStream.h"
+
+// 서브시스템이 들고 있는 마지막 검색 결과의 크기. 다른 곳에서 들고 있는 참조는 포함하지 않는다.
+DECLARE_MEMORY_STAT(TEXT("Search Results Memory"), STAT_MultiplayerSearchResultsMemory, STATGROUP_MultiplayerSessions);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Search Results Held"), STAT_MultiplayerSearchResultsHeld, STATGROUP_MultiplayerSessions);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Searches Sent"), STAT_MultiplayerSearchesSent, STATGROUP_MultiplayerSessions);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Searches Throttled"), STAT_MultiplayerSearchesThrottled, STATGROUP_MultiplayerSessions);
+// Steam은 검색 조건의 빌드 아이디로 백엔드에서 거르기 때문에 0으로 남는다. 받은 뒤에 거르는 것은 NULL, LAN 결과뿐이다.
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Incompatible Results Dropped"), STAT_MultiplayerIncompatibleResults, STATGROUP_MultiplayerSessions);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pending Online Callbacks"), STAT_MultiplayerPendingOnlineCallbacks, STATGROUP_MultiplayerSessions);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Delegate Listeners"), STAT_MultiplayerDelegateListeners, STATGROUP_MultiplayerSessions);
+// 네이티브 델리게이트는 바인딩 수를 밖에서 알 수 없어서 할당 크기로 늘어나는지 본다.
+DECLARE_MEMORY_STAT(TEXT("Delegate Memory"), STAT_MultiplayerDelegateMemory, STATGROUP_MultiplayerSessions);
+
+namespace
+{
+	// 검색 결과 하나가 차지하는 대략적인 메모리
+	// 세션 정보 내부 구현이나 설정의 문자열 값처럼 밖에서 크기를 알 수 없는 부분은 빠져있다.
+	SIZE_T GetSearchResultAllocatedSize(const FOnlineSessionSearchResult& SearchResult)
+	{
+		const FOnlineSession& Session = SearchResult.Session;
+
+		SIZE_T Size = Session.OwningUserName.GetAllocatedSize();
+		Size += Session.SessionSettings.Settings.GetAllocatedSize();
+		Size += Session.SessionSettings.MemberSettings.GetAllocatedSize();
+
+		return Size;
+	}
+}
 
 UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem()	:
 	m_CreateSessionCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateSessionComplete)),
 	m_FindSessionCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnFindSessionComplete)),
 	m_JoinSessionCompleteDelegate(FOnJoinSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnJoinSessionComplete)),
 	m_DestroySessionCompleteDelegate(FOnDestroySessionCompleteDelegate::CreateUObject(this, &ThisClass::OnDestroySessionComplete)),
-	m_StartSessionCompleteDelegate(FOnStartSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnStartSessionComplete))
+	m_StartSessionCompleteDelegate(FOnStartSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnStartSessionComplete)),
+	m_UpdateSessionCompleteDelegate(FOnUpdateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnUpdateSessionComplete))
 {
 	IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
 
@@ -20,6 +72,93 @@ UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem()	:
 	}
 }
 
+void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (GEngine)
+	{
+		// 호스트와의 연결이 끊기는 것을 감지해서 호스트 승계를 시작
+		m_NetworkFailureDelegateHandle = GEngine->OnNetworkFailure().AddUObject(this, &ThisClass::HandleNetworkFailure);
+	}
+	m_PostLoadMapDelegateHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMap);
+
+	if (GConfig)
+	{
+		GConfig->GetInt(TEXT("MultiplayerSessions.Search"), TEXT("MaxResults"), m_SearchMaxResults, GGameIni);
+		GConfig->GetInt64(TEXT("MultiplayerSessions.Search"), TEXT("MaxBytes"), m_SearchMaxBytes, GGameIni);
+		GConfig->GetFloat(TEXT("MultiplayerSessions.Search"), TEXT("MinInterval"), m_SearchMinInterval, GGameIni);
+		GConfig->GetFloat(TEXT("MultiplayerSessions.Search"), TEXT("BackoffBase"), m_SearchBackoffBase, GGameIni);
+		GConfig->GetFloat(TEXT("MultiplayerSessions.Search"), TEXT("BackoffMax"), m_SearchBackoffMax, GGameIni);
+		GConfig->GetFloat(TEXT("MultiplayerSessions.Reservation"), TEXT("Timeout"), m_ReservationTimeout, GGameIni);
+	}
+
+	// 설정에서 고른 넷 프로필은 월드가 열릴때마다 넷 드라이버에 적용
+	FMultiplayerNetProfile::Load(FMultiplayerNetProfile::GetConfiguredProfileName(), m_NetProfile);
+	m_WorldInitializedActorsDelegateHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &ThisClass::OnWorldInitializedActors);
+
+	// 지난 실행에서 보거나 참가했던 세션을 불러와서 첫 검색 전에도 후보로 사용
+	m_SessionCache = MakeShared<FMultiplayerSessionCache>();
+	m_SessionCache->Load(FPaths::ProjectSavedDir() / TEXT("MultiplayerSessions") / TEXT("RecentSessions.bin"));
+
+	// LAN 세션은 비콘이 알아서 갱신하기 때문에 온라인 세션만 재검증
+	if (!IsLanMatch() && GetGameInstance())
+	{
+		for (const FMultiplayerSessionCacheRecord& Record : m_SessionCache->GetRecords())
+		{
+			m_PendingRevalidation.Add(FMultiplayerSessionCache::GetSessionId(Record));
+		}
+
+		if (m_PendingRevalidation.Num() > 0)
+		{
+			GetGameInstance()->GetTimerManager().SetTimer(m_RevalidateTimerHandle, this, &ThisClass::RevalidateNextCachedSession, m_RevalidateInterval, false);
+		}
+	}
+}
+
+void UMultiplayerSessionsSubsystem::Deinitialize()
+{
+	if (GEngine)
+	{
+		GEngine->OnNetworkFailure().Remove(m_NetworkFailureDelegateHandle);
+	}
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(m_PostLoadMapDelegateHandle);
+
+	if (m_Soak)
+	{
+		m_Soak->Stop();
+	}
+	if (m_NetSweep)
+	{
+		m_NetSweep->Stop();
+	}
+
+	StopRecording();
+	StopReplay();
+
+	m_LanDiscovery.Reset();
+	StopReservationHost();
+
+	FWorldDelegates::OnWorldInitializedActors.Remove(m_WorldInitializedActorsDelegateHandle);
+
+	if (GetGameInstance())
+	{
+		GetGameInstance()->GetTimerManager().ClearTimer(m_RevalidateTimerHandle);
+		GetGameInstance()->GetTimerManager().ClearTimer(m_DeferredSearchTimerHandle);
+		GetGameInstance()->GetTimerManager().ClearTimer(m_SearchMashTimerHandle);
+	}
+
+	ResetPartyJoin();
+
+	if (m_SessionCache.IsValid())
+	{
+		m_SessionCache->Save();
+		m_SessionCache.Reset();
+	}
+
+	Super::Deinitialize();
+}
+
 void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FString MatchType)
 {
 	// 유효한지 체크
@@ -28,6 +167,159 @@ void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FS
 		return;
 	}
 
+	// 미리 만들어둔 세션이 같은 조건이라면 광고만 켜고 바로 로비로 이동
+	if (m_SpeculativeState != ESpeculativeSessionState::None)
+	{
+		if (NumPublicConnections == m_SpeculativeNumPublicConnections && MatchType == m_SpeculativeMatchType)
+		{
+			if (m_SpeculativeState == ESpeculativeSessionState::Creating)
+			{
+				// 아직 만드는 중이라면 생성이 끝나는 대로 광고
+				m_SpeculativeCreateAction = ESpeculativeCreateAction::Publish;
+			}
+			else
+			{
+				PublishSpeculativeSession();
+			}
+			return;
+		}
+
+		// 조건이 다르고 아직 만드는 중이라면 생성이 끝난 뒤에 지우고 새로 만든다.
+		if (m_SpeculativeState == ESpeculativeSessionState::Creating)
+		{
+			m_SpeculativeCreateAction = ESpeculativeCreateAction::Replace;
+			m_LastNumPublicConnections = NumPublicConnections;
+			m_LastMatchType = MatchType;
+			return;
+		}
+
+		// 이미 만들어졌다면 아래에서 기존 세션을 지우고 새로 만든다.
+		m_SpeculativeState = ESpeculativeSessionState::None;
+		m_SpeculativeCreateAction = ESpeculativeCreateAction::None;
+	}
+
+	CreateSessionInternal(NumPublicConnections, MatchType, true);
+}
+
+void UMultiplayerSessionsSubsystem::PrepareSpeculativeSession(int32 NumPublicConnections, FString MatchType)
+{
+	if (!m_SessionInterface.IsValid())
+		return;
+
+	// 메뉴를 다시 띄웠을때 이미 미리 만든 세션이 있다면 조건이 같으면 그대로 쓰고 다르면 다시 만든다.
+	if (m_SpeculativeState != ESpeculativeSessionState::None)
+	{
+		const bool bSameParams = NumPublicConnections == m_SpeculativeNumPublicConnections && MatchType == m_SpeculativeMatchType;
+
+		if (m_SpeculativeState == ESpeculativeSessionState::Creating)
+		{
+			// 호스트 요청이 이미 들어왔다면 그 요청대로 처리한다.
+			if (m_SpeculativeCreateAction == ESpeculativeCreateAction::None || m_SpeculativeCreateAction == ESpeculativeCreateAction::Destroy)
+			{
+				m_SpeculativeCreateAction = bSameParams ? ESpeculativeCreateAction::None : ESpeculativeCreateAction::Restart;
+				m_SpeculativeNumPublicConnections = NumPublicConnections;
+				m_SpeculativeMatchType = MatchType;
+			}
+			return;
+		}
+
+		if (bSameParams)
+			return;
+
+		// 기존 세션을 지우고 광고하지 않은 채로 다시 만든다. 끝날때까지 Creating
+		m_SpeculativeState = ESpeculativeSessionState::Creating;
+		m_SpeculativeNumPublicConnections = NumPublicConnections;
+		m_SpeculativeMatchType = MatchType;
+		m_SpeculativeCreateAction = ESpeculativeCreateAction::None;
+
+		CreateSessionInternal(NumPublicConnections, MatchType, false);
+		return;
+	}
+
+	if (IsCreateSessionInProgress())
+		return;
+
+	// 이미 세션이 있다면 (로비에서 돌아왔거나 참가 중) 미리 만들지 않는다.
+	if (m_SessionInterface->GetNamedSession(NAME_GameSession) != nullptr)
+		return;
+
+	m_SpeculativeState = ESpeculativeSessionState::Creating;
+	m_SpeculativeNumPublicConnections = NumPublicConnections;
+	m_SpeculativeMatchType = MatchType;
+	m_SpeculativeCreateAction = ESpeculativeCreateAction::None;
+
+	CreateSessionInternal(NumPublicConnections, MatchType, false);
+}
+
+void UMultiplayerSessionsSubsystem::CancelSpeculativeSession()
+{
+	if (m_SpeculativeState == ESpeculativeSessionState::None)
+		return;
+
+	// 생성 중에 지우면 생성 콜백이 세션이 없는 상태로 들어온다. 생성이 끝나면 OnCreateSessionComplete에서 지운다.
+	if (m_SpeculativeState == ESpeculativeSessionState::Creating)
+	{
+		m_SpeculativeCreateAction = ESpeculativeCreateAction::Destroy;
+		return;
+	}
+
+	m_SpeculativeState = ESpeculativeSessionState::None;
+	m_SpeculativeCreateAction = ESpeculativeCreateAction::None;
+
+	DestroySession();
+}
+
+void UMultiplayerSessionsSubsystem::PublishSpeculativeSession()
+{
+	m_SpeculativeState = ESpeculativeSessionState::None;
+
+	FOnlineSessionSettings* CurrentSettings = m_SessionInterface->GetSessionSettings(NAME_GameSession);
+	if (CurrentSettings == nullptr)
+	{
+		// 세션이 사라졌다면 처음부터 다시 만든다.
+		CreateSessionInternal(m_SpeculativeNumPublicConnections, m_SpeculativeMatchType, true);
+		return;
+	}
+
+	FOnlineSessionSettings UpdatedSettings = *CurrentSettings;
+	UpdatedSettings.bShouldAdvertise = true;
+	if (m_LastSessionSettings.IsValid())
+	{
+		m_LastSessionSettings->bShouldAdvertise = true;
+	}
+
+	// 인원 갱신이 진행 중이라면 이미 바인딩된 콜백이 같이 받는다. 핸들을 덮어쓰면 이전 바인딩을 지울 수 없게 된다.
+	const bool bAlreadyBound = m_UpdateSessionCompleteDelegateHandle.IsValid();
+	m_bSessionUpdateInFlight = true;
+	m_LastSessionUpdateTime = FPlatformTime::Seconds();
+	if (!bAlreadyBound)
+	{
+		m_UpdateSessionCompleteDelegateHandle = m_SessionInterface->AddOnUpdateSessionCompleteDelegate_Handle(m_UpdateSessionCompleteDelegate);
+	}
+
+	if (!m_SessionInterface->UpdateSession(NAME_GameSession, UpdatedSettings, true))
+	{
+		if (!bAlreadyBound)
+		{
+			m_SessionInterface->ClearOnUpdateSessionCompleteDelegate_Handle(m_UpdateSessionCompleteDelegateHandle);
+			m_bSessionUpdateInFlight = false;
+		}
+
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Failed to advertise the pre-hosted session"));
+	}
+
+	StartLanBroadcast();
+
+	// 광고 갱신은 로비로 이동하는 동안 백엔드에서 처리되기 때문에 기다리지 않는다.
+	MultiplayerOnCreateSessionComplete.Broadcast(true);
+}
+
+void UMultiplayerSessionsSubsystem::CreateSessionInternal(int32 NumPublicConnections, const FString& MatchType, bool bShouldAdvertise)
+{
+	// 생성 중에 다시 요청하면 핸들이 덮어써져서 먼저 추가한 바인딩이 남는다. 진행 중인 생성의 결과가 브로드캐스트된다.
+	if (IsCreateSessionInProgress())
+		return;
+
 	auto ExistingSession = m_SessionInterface->GetNamedSession(NAME_GameSession);
 
 	// 널이 아니라면 이미 세션이 생성되어 있다는것
@@ -36,8 +328,12 @@ void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FS
 		m_bCreateSessionOnDestroy = true;
 		m_LastNumPublicConnections = NumPublicConnections;
 		m_LastMatchType = MatchType;
+		m_LastShouldAdvertise = bShouldAdvertise;
 
+		// 파괴가 끝나면 OnDestroySessionComplete에서 다시 생성한다.
+		// 여기서 바로 생성하면 세션이 남아있어서 실패하고 메뉴에 실패와 성공이 연달아 전달된다.
 		DestroySession();
+		return;
 	}
 
 	// m_CreateSessionCompleteDelegateHandle는 나중에 델리게이트 목록에서 지울 수 있다.
@@ -45,21 +341,46 @@ void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FS
 
 	m_LastSessionSettings = MakeShareable(new FOnlineSessionSettings());
 	// LAN인지 아닌지에 다라 자동으로 설정된다.
-	m_LastSessionSettings->bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false;
+	m_LastSessionSettings->bIsLANMatch = IsLanMatch();
 	m_LastSessionSettings->NumPublicConnections = NumPublicConnections;
 	m_LastSessionSettings->bAllowJoinInProgress = true;
 	m_LastSessionSettings->bAllowJoinViaPresence = true;
-	m_LastSessionSettings->bShouldAdvertise = true;
+	// 미리 만드는 세션은 호스트 버튼을 누를때까지 광고하지 않는다.
+	m_LastSessionSettings->bShouldAdvertise = bShouldAdvertise;
 	m_LastSessionSettings->bUsesPresence = true;
 	m_LastSessionSettings->bUseLobbiesIfAvailable = true;
-	m_LastSessionSettings->Set(FName("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
-	// 이것을 1로 설정하면 여러 사용자가 자체 빌드 및 호스팅을 시작할 수 있다고 한다.
-	m_LastSessionSettings->BuildUniqueId = 1;
+	// 매치 타입, 지역, 상태는 숫자 하나로 압축해서 광고
+	FMultiplayerSessionInfo SessionInfo;
+	SessionInfo.MatchType = FMultiplayerSessionInfo::MatchTypeFromString(MatchType);
+	SessionInfo.Region = m_LocalRegion;
+	SessionInfo.State = EMultiplayerSessionState::Lobby;
+	SessionInfo.Write(*m_LastSessionSettings, MatchType);
+	// 호스트 자신이 한자리를 차지하기 때문에 남은 자리는 -1
+	// 남은 자리와 실력은 백엔드에서 비교 필터를 걸 수 있도록 따로 광고
+	FMultiplayerSessionKeys::OpenSlots.Set(*m_LastSessionSettings, FMath::Max(NumPublicConnections - 1, 0));
+	FMultiplayerSessionKeys::Skill.Set(*m_LastSessionSettings, m_LocalSkill);
+	if (m_ReservationBeaconPort > 0)
+	{
+		FMultiplayerSessionKeys::BeaconPort.Set(*m_LastSessionSettings, m_ReservationBeaconPort);
+	}
+	// 같은 빌드끼리만 서로 검색되도록 빌드 아이디를 광고
+	m_LastSessionSettings->BuildUniqueId = GetBuildUniqueId();
+	FMultiplayerSessionKeys::BuildId.Set(*m_LastSessionSettings, GetBuildUniqueId());
+
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->BeginOperation(EMultiplayerRecordedOp::Create, NumPublicConnections, MatchType);
+	}
 
 	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
 	// 생성 실패시 아래로 들어감
 	if (!m_SessionInterface->CreateSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, *m_LastSessionSettings))
 	{
+		if (m_Recorder.IsValid())
+		{
+			m_Recorder->EndOperation(EMultiplayerRecordedOp::Create, false);
+		}
+
 		// 생성 실패시 델리게이트 리스트에서 해당 델리게이트 제거
 		m_SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(m_CreateSessionCompleteDelegateHandle);
 
@@ -72,28 +393,150 @@ void UMultiplayerSessionsSubsystem::FindSession(int32 MaxSearchResults)
 	if (!m_SessionInterface.IsValid())
 		return;
 
+	// 검색 중이라면 새로 요청하지 않아도 끝나면 같은 결과가 브로드캐스트된다.
+	if (IsFindSessionInProgress())
+	{
+		INC_DWORD_STAT(STAT_MultiplayerSearchesThrottled);
+		return;
+	}
+
+	// 너무 자주 요청하면 백엔드에 보내지 않고 마지막 결과로 응답
+	// 재생 중에는 녹화된 순서대로 응답해야 결과가 실행 시간에 영향을 받지 않는다. 제한 자체를 측정하는 재생만 예외
+	const double Now = FPlatformTime::Seconds();
+	const bool bApplySearchThrottle = !m_Replay.IsValid() || m_Replay->AppliesSearchThrottle();
+	if (bApplySearchThrottle && Now < m_NextSearchAllowedTime)
+	{
+		INC_DWORD_STAT(STAT_MultiplayerSearchesThrottled);
+
+		UGameInstance* GameInstance = GetGameInstance();
+		if (GameInstance == nullptr)
+			return;
+
+		if (m_LastSessionSearch.IsValid() && m_LastSessionSearch->SearchResults.Num() > 0)
+		{
+			// 호출한 쪽이 바인딩을 마치기 전에 브로드캐스트되지 않도록 다음 틱에 응답
+			GameInstance->GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateUObject(this, &ThisClass::BroadcastLastSearchResults));
+		}
+		else if (!GameInstance->GetTimerManager().IsTimerActive(m_DeferredSearchTimerHandle))
+		{
+			// 돌려줄 결과가 없다면 허용되는 시간에 한번만 검색
+			GameInstance->GetTimerManager().SetTimer(m_DeferredSearchTimerHandle,
+				FTimerDelegate::CreateUObject(this, &ThisClass::FindSession, MaxSearchResults),
+				static_cast<float>(m_NextSearchAllowedTime - Now), false);
+		}
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(MultiplayerSessionsSearch);
+	INC_DWORD_STAT(STAT_MultiplayerSearchesSent);
+
 	m_FindSessionCompleteDelegateHandle = m_SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(m_FindSessionCompleteDelegate);
 
+	// 이전 검색 결과는 새 검색을 요청하는 순간 놓아준다.
+	ReleaseSearchResults();
+
 	m_LastSessionSearch = MakeShareable(new FOnlineSessionSearch());
-	m_LastSessionSearch->MaxSearchResults = MaxSearchResults;
-	m_LastSessionSearch->bIsLanQuery = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false;
+	m_LastSessionSearch->MaxSearchResults = FMath::Min(MaxSearchResults, m_SearchMaxResults);
+	m_LastSessionSearch->bIsLanQuery = IsLanMatch();
 	m_LastSessionSearch->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
+	// 꽉 찬 세션은 백엔드에서 걸러지도록 남은 자리로 필터. 파티는 전원이 들어갈 자리가 필요하다.
+	const int32 RequiredOpenSlots = m_bPartySearchPending ? m_PartyMemberIds.Num() + 1 : 1;
+	FMultiplayerSessionKeys::OpenSlots.SetQuery(m_LastSessionSearch->QuerySettings, RequiredOpenSlots, EOnlineComparisonOp::GreaterThanEquals);
+	// 다른 빌드의 세션은 참가해도 이동한 뒤에 실패하기 때문에 백엔드에서부터 거른다.
+	FMultiplayerSessionKeys::BuildId.SetQuery(m_LastSessionSearch->QuerySettings, GetBuildUniqueId(), EOnlineComparisonOp::Equals);
 
 	// 로컬 플레이어를 얻어와 넷ID를 얻을 수 있다.
 	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
 
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->BeginOperation(EMultiplayerRecordedOp::Find, m_LastSessionSearch->MaxSearchResults, FMultiplayerSessionRecorder::DescribeQuery(*m_LastSessionSearch));
+	}
+
 	// 세션을 호출하고 세션이 완료되면 응답으로 콜백함수를 호출 요청
-	if (!m_SessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(), m_LastSessionSearch.ToSharedRef()))
+	const bool bSearchRequested = m_Replay.IsValid()
+		? m_Replay->FindSessions(m_SessionInterface, m_LastSessionSearch.ToSharedRef(), GetGameInstance()->GetTimerManager())
+		: m_SessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(), m_LastSessionSearch.ToSharedRef());
+	if (!bSearchRequested)
 	{
+		if (m_Recorder.IsValid())
+		{
+			m_Recorder->EndOperation(EMultiplayerRecordedOp::Find, false);
+		}
+
 		// 들어오면 실패
 		// 델리게이트 제거
 		m_SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(m_FindSessionCompleteDelegateHandle);
 
+		ScheduleNextSearch(false);
+
 		// 실패한것이기 때문에 빈 배열과 false를 전달
 		MultiplayerOnFindSessionComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
 	}
 }
 
+void UMultiplayerSessionsSubsystem::CancelFindSession()
+{
+	if (!m_SessionInterface.IsValid() || MultiplayerOnFindSessionComplete.IsBound())
+		return;
+
+	// 제한에 걸려 미뤄둔 검색도 기다리는 곳이 없다.
+	if (GetGameInstance())
+	{
+		GetGameInstance()->GetTimerManager().ClearTimer(m_DeferredSearchTimerHandle);
+	}
+
+	if (!IsFindSessionInProgress())
+		return;
+
+	m_SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(m_FindSessionCompleteDelegateHandle);
+	UpdateListenerStats();
+
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->EndOperation(EMultiplayerRecordedOp::Find, false);
+	}
+
+	// 재생은 타이머로 응답하기 때문에 백엔드에 취소할 요청이 없다. 응답은 핸들을 지웠으니 무시된다.
+	if (!m_Replay.IsValid())
+	{
+		m_SessionInterface->CancelFindSessions();
+	}
+
+	UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Cancelled the session search, no listeners left"));
+}
+
+void UMultiplayerSessionsSubsystem::ScheduleNextSearch(bool bWasSuccessful)
+{
+	if (bWasSuccessful)
+	{
+		m_SearchFailureCount = 0;
+		m_NextSearchAllowedTime = FPlatformTime::Seconds() + m_SearchMinInterval;
+		return;
+	}
+
+	// 실패가 이어질수록 간격을 두배씩 늘리고, 여러 클라이언트가 동시에 다시 요청하지 않도록 간격을 흔든다.
+	++m_SearchFailureCount;
+	const float Backoff = FMath::Min(m_SearchBackoffBase * FMath::Pow(2.f, static_cast<float>(m_SearchFailureCount - 1)), m_SearchBackoffMax);
+	const float Delay = FMath::Max(Backoff * FMath::FRandRange(0.5f, 1.f), m_SearchMinInterval);
+
+	m_NextSearchAllowedTime = FPlatformTime::Seconds() + Delay;
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Session search failed %d time(s) in a row, next search allowed in %.1fs"), m_SearchFailureCount, Delay);
+}
+
+void UMultiplayerSessionsSubsystem::BroadcastLastSearchResults()
+{
+	if (m_LastSessionSearch.IsValid() && m_LastSessionSearch->SearchResults.Num() > 0)
+	{
+		MultiplayerOnFindSessionComplete.Broadcast(m_LastSessionSearch->SearchResults, true);
+	}
+	else
+	{
+		MultiplayerOnFindSessionComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+	}
+}
+
 void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& SessionResult)
 {
 	if (!m_SessionInterface.IsValid())
@@ -103,113 +546,1855 @@ void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult
 		return;
 	}
 
+	// 참가 중에 다시 요청하면 진행 중인 참가의 결과만 브로드캐스트된다.
+	if (IsJoinSessionInProgress())
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("JoinSession ignored, a join is already in progress"));
+		return;
+	}
+
+	// 미리 만들어둔 세션이 있으면 참가할 수 없기 때문에 먼저 정리하고 참가
+	if (m_SpeculativeState != ESpeculativeSessionState::None)
+	{
+		m_SpeculativeState = ESpeculativeSessionState::None;
+		m_SpeculativeCreateAction = ESpeculativeCreateAction::None;
+		m_PendingJoinResult = SessionResult;
+		m_bJoinSessionOnDestroy = true;
+
+		DestroySession();
+		return;
+	}
+
 	m_JoinSessionCompleteDelegateHandle = m_SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(m_JoinSessionCompleteDelegate);
 
+	// 참가에 성공하면 재접속용으로 사용
+	m_JoiningResult = SessionResult;
+
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->BeginOperation(EMultiplayerRecordedOp::Join, 0, FMultiplayerSessionRecorder::GetRecordedSessionId(SessionResult));
+	}
+
 	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-	if (!m_SessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, SessionResult))
+	const bool bJoinRequested = m_Replay.IsValid()
+		? m_Replay->JoinSession(m_SessionInterface, SessionResult, GetGameInstance()->GetTimerManager())
+		: m_SessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, SessionResult);
+	if (!bJoinRequested)
 	{
+		if (m_Recorder.IsValid())
+		{
+			m_Recorder->EndOperation(EMultiplayerRecordedOp::Join, EOnJoinSessionCompleteResult::UnknownError);
+		}
+
 		m_SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(m_JoinSessionCompleteDelegateHandle);
+		m_JoiningResult = FOnlineSessionSearchResult();
+		m_bRejoinPending = false;
 
 		MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
 	}
 }
 
+bool UMultiplayerSessionsSubsystem::IsJoiningSession(const FOnlineSessionSearchResult& SessionResult) const
+{
+	// 미리 만든 세션을 정리하는 동안에는 m_PendingJoinResult가 참가할 세션
+	const FOnlineSessionSearchResult& JoiningResult = m_bJoinSessionOnDestroy ? m_PendingJoinResult : m_JoiningResult;
+
+	// 재생한 결과는 세션 정보가 없어서 녹화 당시 아이디로 비교한다.
+	return FMultiplayerSessionRecorder::GetRecordedSessionId(JoiningResult) == FMultiplayerSessionRecorder::GetRecordedSessionId(SessionResult);
+}
+
 void UMultiplayerSessionsSubsystem::DestroySession()
 {
 	if (!m_SessionInterface.IsValid())
 	{
+		FailCreateSessionOnDestroy();
 		MultiplayerOnDestroySessionComplete.Broadcast(false);
 
 		return;
 	}
 
+	// 이미 파괴 중이라면 그 결과가 브로드캐스트된다.
+	if (m_DestroySessionCompleteDelegateHandle.IsValid())
+		return;
+
 	m_DestroySessionCompleteDelegateHandle = m_SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(m_DestroySessionCompleteDelegate);
 
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->BeginOperation(EMultiplayerRecordedOp::Destroy);
+	}
+
 	if (!m_SessionInterface->DestroySession(NAME_GameSession))
 	{
+		if (m_Recorder.IsValid())
+		{
+			m_Recorder->EndOperation(EMultiplayerRecordedOp::Destroy, false);
+		}
+
 		m_SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(m_DestroySessionCompleteDelegateHandle);
+		FailCreateSessionOnDestroy();
 		MultiplayerOnDestroySessionComplete.Broadcast(false);
 	}
 }
 
+void UMultiplayerSessionsSubsystem::FailCreateSessionOnDestroy()
+{
+	if (!m_bCreateSessionOnDestroy)
+		return;
+
+	// 세션이 남아있어서 다시 만들 수 없다. 호스트 버튼을 누른 메뉴가 결과를 기다리고 있다.
+	m_bCreateSessionOnDestroy = false;
+
+	// 미리 만들던 세션이라면 호스트 버튼을 누르기 전까지는 메뉴가 기다리는 결과가 없다.
+	if (m_SpeculativeState == ESpeculativeSessionState::Creating)
+	{
+		const bool bHostRequested = m_SpeculativeCreateAction == ESpeculativeCreateAction::Publish;
+		m_SpeculativeState = ESpeculativeSessionState::None;
+		m_SpeculativeCreateAction = ESpeculativeCreateAction::None;
+		if (!bHostRequested)
+			return;
+	}
+
+	MultiplayerOnCreateSessionComplete.Broadcast(false);
+}
+
 void UMultiplayerSessionsSubsystem::StartSession()
 {
 	if (!m_SessionInterface.IsValid())
 		return;
 
+	if (m_StartSessionCompleteDelegateHandle.IsValid())
+		return;
+
 	m_StartSessionCompleteDelegateHandle = m_SessionInterface->AddOnStartSessionCompleteDelegate_Handle(m_StartSessionCompleteDelegate);
 
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->BeginOperation(EMultiplayerRecordedOp::Start);
+	}
+
 	if (!m_SessionInterface->StartSession(NAME_GameSession))
 	{
+		if (m_Recorder.IsValid())
+		{
+			m_Recorder->EndOperation(EMultiplayerRecordedOp::Start, false);
+		}
+
 		m_SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(m_StartSessionCompleteDelegateHandle);
 
 		MultiplayerOnStartSessionComplete.Broadcast(false);
 	}
 }
 
-void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
+void UMultiplayerSessionsSubsystem::UpdateSessionOccupancy(int32 NumPlayers, EMultiplayerSessionState State)
 {
-	if (m_SessionInterface)
+	if (!m_SessionInterface.IsValid() || m_SessionInterface->GetNamedSession(NAME_GameSession) == nullptr)
+		return;
+
+	m_PendingNumPlayers = NumPlayers;
+	m_PendingSessionState = State;
+	m_bSessionUpdatePending = true;
+
+	UGameInstance* GameInstance = GetGameInstance();
+
+	// 이미 갱신 중이거나 예약되어 있다면 최신 값만 저장해두고 나중에 한번에 반영
+	if (m_bSessionUpdateInFlight || GameInstance == nullptr || GameInstance->GetTimerManager().IsTimerActive(m_SessionUpdateTimerHandle))
+		return;
+
+	const double Elapsed = FPlatformTime::Seconds() - m_LastSessionUpdateTime;
+
+	if (Elapsed >= m_SessionUpdateInterval)
 	{
-		m_SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(m_CreateSessionCompleteDelegateHandle);
+		FlushSessionOccupancy();
+	}
+	else
+	{
+		GameInstance->GetTimerManager().SetTimer(m_SessionUpdateTimerHandle, this, &ThisClass::FlushSessionOccupancy,
+			static_cast<float>(m_SessionUpdateInterval - Elapsed), false);
 	}
+}
 
-	MultiplayerOnCreateSessionComplete.Broadcast(bWasSuccessful);
+void UMultiplayerSessionsSubsystem::SetMatchmakingProfile(int32 Skill, EMultiplayerRegion Region)
+{
+	m_LocalSkill = Skill;
+	m_LocalRegion = Region;
 }
 
-void UMultiplayerSessionsSubsystem::OnFindSessionComplete(bool bWasSuccessful)
+bool UMultiplayerSessionsSubsystem::StartSoak(int32 Cycles, const FString& LobbyPath)
 {
-	if (m_SessionInterface)
+	if (m_Soak == nullptr)
 	{
-		m_SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(m_FindSessionCompleteDelegateHandle);
+		m_Soak = NewObject<UMultiplayerSessionSoak>(this);
 	}
 
-	if (m_LastSessionSearch->SearchResults.Num() <= 0)
+	return m_Soak->Start(this, Cycles, LobbyPath);
+}
+
+bool UMultiplayerSessionsSubsystem::StartNetSweep(int32 NumClients, float SecondsPerStep)
+{
+	if (m_NetSweep == nullptr)
 	{
-		// 배열이 비어있다면 빈 배열과 false를 전달
-		MultiplayerOnFindSessionComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
-		return;
+		m_NetSweep = NewObject<UMultiplayerNetSweep>(this);
 	}
 
-	MultiplayerOnFindSessionComplete.Broadcast(m_LastSessionSearch->SearchResults, bWasSuccessful);
+	return m_NetSweep->Start(this, NumClients, SecondsPerStep);
 }
 
-void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+int32 UMultiplayerSessionsSubsystem::GetPendingOnlineCallbackCount() const
 {
-	if (m_SessionInterface)
+	const FDelegateHandle* Handles[] =
 	{
-		m_SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(m_JoinSessionCompleteDelegateHandle);
+		&m_CreateSessionCompleteDelegateHandle,
+		&m_FindSessionCompleteDelegateHandle,
+		&m_JoinSessionCompleteDelegateHandle,
+		&m_DestroySessionCompleteDelegateHandle,
+		&m_StartSessionCompleteDelegateHandle,
+		&m_UpdateSessionCompleteDelegateHandle,
+		&m_PartyFindSessionCompleteDelegateHandle,
+		&m_FindFriendSessionCompleteDelegateHandle
+	};
+
+	int32 Count = 0;
+	for (const FDelegateHandle* Handle : Handles)
+	{
+		if (Handle->IsValid())
+		{
+			++Count;
+		}
 	}
 
-	MultiplayerOnJoinSessionComplete.Broadcast(Result);
+	return Count;
 }
 
-void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+int32 UMultiplayerSessionsSubsystem::GetDelegateListenerCount() const
 {
-	if (m_SessionInterface)
-	{
-		m_SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(m_DestroySessionCompleteDelegateHandle);
-	}
+	return MultiplayerOnCreateSessionComplete.GetAllObjects().Num()
+		+ MultiplayerOnDestroySessionComplete.GetAllObjects().Num()
+		+ MultiplayerOnStartSessionComplete.GetAllObjects().Num()
+		+ MultiplayerOnFindSessionComplete.GetNumListeners()
+		+ MultiplayerOnJoinSessionComplete.GetNumListeners();
+}
+
+void UMultiplayerSessionsSubsystem::UpdateListenerStats() const
+{
+	SET_DWORD_STAT(STAT_MultiplayerPendingOnlineCallbacks, GetPendingOnlineCallbackCount());
+	SET_DWORD_STAT(STAT_MultiplayerDelegateListeners, GetDelegateListenerCount());
+	SET_MEMORY_STAT(STAT_MultiplayerDelegateMemory,
+		MultiplayerOnFindSessionComplete.GetAllocatedSize()
+		+ MultiplayerOnJoinSessionComplete.GetAllocatedSize()
+		+ MultiplayerOnJoinRejected.GetAllocatedSize()
+		+ MultiplayerOnPartySessionReady.GetAllocatedSize()
+		+ MultiplayerOnHostMigrationStarted.GetAllocatedSize()
+		+ MultiplayerOnLanSessionsUpdated.GetAllocatedSize());
+}
 
-	if (bWasSuccessful && m_bCreateSessionOnDestroy)
+bool UMultiplayerSessionsSubsystem::StartRecording(const FString& FilePath)
+{
+	if (m_Recorder.IsValid() || m_Replay.IsValid())
 	{
-		// 세션을 삭제하더라도 실수로 세션을 생성하지 않는다.
-		m_bCreateSessionOnDestroy = false;
-		CreateSession(m_LastNumPublicConnections, m_LastMatchType);
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Recording not started, already recording or replaying"));
+		return false;
 	}
 
-	MultiplayerOnDestroySessionComplete.Broadcast(bWasSuccessful);
+	m_Recorder = MakeShared<FMultiplayerSessionRecorder>(FilePath);
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Recording session operations to %s"), *FilePath);
+	return true;
 }
 
-void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName SessionName, bool bWasSuccessful)
+void UMultiplayerSessionsSubsystem::StopRecording()
 {
-	if (m_SessionInterface)
+	if (!m_Recorder.IsValid())
+		return;
+
+	m_Recorder->Save();
+	m_Recorder.Reset();
+}
+
+bool UMultiplayerSessionsSubsystem::StartReplay(const FString& FilePath, bool bUseRecordedTiming)
+{
+	if (m_Recorder.IsValid() || m_Replay.IsValid())
 	{
-		m_SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(m_StartSessionCompleteDelegateHandle);
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Replay not started, already recording or replaying"));
+		return false;
 	}
 
-	if (bWasSuccessful)
+	TSharedRef<FMultiplayerSessionReplay> Replay = MakeShared<FMultiplayerSessionReplay>();
+	if (!Replay->Load(FilePath, bUseRecordedTiming))
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Failed to load session recording %s"), *FilePath);
+		return false;
+	}
+
+	return StartReplay(Replay);
+}
+
+bool UMultiplayerSessionsSubsystem::StartReplay(TSharedRef<FMultiplayerSessionReplay> Replay)
+{
+	if (m_Recorder.IsValid() || m_Replay.IsValid())
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Replay not started, already recording or replaying"));
+		return false;
+	}
+
+	// 이전 검색 결과와 제한 시간이 남아있으면 첫 응답이 녹화와 달라진다.
+	ReleaseSearchResults();
+	m_SearchFailureCount = 0;
+	m_NextSearchAllowedTime = 0.0;
+
+	m_Replay = Replay;
+	return true;
+}
+
+bool UMultiplayerSessionsSubsystem::StartSearchMash(float Seconds, float ClicksPerSecond)
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	if (GameInstance == nullptr || Seconds <= 0.f || ClicksPerSecond <= 0.f || IsFindSessionInProgress())
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Search mash not started, needs a positive duration and click rate and no search in progress"));
+		return false;
+	}
+
+	// 같은 빌드의 세션 20개를 돌려주는 검색 하나를 반복. 백엔드처럼 응답에 시간이 걸리도록 녹화된 시간을 사용
+	FRandomStream Random(1);
+	FMultiplayerRecordedOperation Find;
+	Find.Op = EMultiplayerRecordedOp::Find;
+	Find.Duration = 0.2f;
+	Find.Result = 1;
+	for (FOnlineSessionSearchResult& SearchResult : FMultiplayerSearchResultProcessor::MakeBenchmarkResults(20, Random))
+	{
+		FMultiplayerSessionKeys::BuildId.Set(SearchResult.Session.SessionSettings, GetBuildUniqueId());
+		SearchResult.Session.SessionSettings.BuildUniqueId = GetBuildUniqueId();
+		Find.Results.Add(FMultiplayerSessionRecorder::CaptureResult(SearchResult));
+	}
+
+	TArray<FMultiplayerRecordedOperation> Operations;
+	Operations.Add(MoveTemp(Find));
+
+	TSharedRef<FMultiplayerSessionReplay> Replay = MakeShared<FMultiplayerSessionReplay>();
+	Replay->SetOperations(MoveTemp(Operations), true, true);
+	Replay->SetApplySearchThrottle(true);
+	if (!StartReplay(Replay))
+		return false;
+
+	// 처음 한번은 바로 나가고, 이후에는 최소 간격마다 한번씩만 나갈 수 있다. 타이머 오차로 하나는 더 허용
+	const double EndTime = FPlatformTime::Seconds() + Seconds;
+	const int32 MaxSearches = 2 + FMath::FloorToInt(Seconds / FMath::Max(m_SearchMinInterval, KINDA_SMALL_NUMBER));
+	TSharedRef<int32> NumClicks = MakeShared<int32>(0);
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Search mash started, %.0f clicks/s for %.0fs, min interval %.1fs"), ClicksPerSecond, Seconds, m_SearchMinInterval);
+
+	TWeakObjectPtr<UMultiplayerSessionsSubsystem> WeakThis(this);
+	GameInstance->GetTimerManager().SetTimer(m_SearchMashTimerHandle, FTimerDelegate::CreateLambda([WeakThis, Replay, EndTime, MaxSearches, NumClicks]()
+		{
+			UMultiplayerSessionsSubsystem* This = WeakThis.Get();
+			if (This == nullptr)
+				return;
+
+			if (FPlatformTime::Seconds() < EndTime)
+			{
+				++(*NumClicks);
+				This->FindSession(This->m_SearchMaxResults);
+				return;
+			}
+
+			This->GetGameInstance()->GetTimerManager().ClearTimer(This->m_SearchMashTimerHandle);
+
+			const int32 NumSearches = Replay->GetNumReplayedFinds();
+			const bool bPassed = NumSearches <= MaxSearches;
+			UE_LOG(LogMultiplayerSessions, Log, TEXT("Search mash %s: %d clicks sent %d searches to the backend (limit %d)"),
+				bPassed ? TEXT("PASSED") : TEXT("FAILED"), *NumClicks, NumSearches, MaxSearches);
+
+			This->CancelFindSession();
+			This->StopReplay();
+		}), 1.f / ClicksPerSecond, true);
+
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::StopReplay()
+{
+	if (!m_Replay.IsValid())
+		return;
+
+	m_Replay->LogSummary();
+	m_Replay.Reset();
+}
+
+UMultiplayerMatchmaker* UMultiplayerSessionsSubsystem::GetMatchmaker()
+{
+	if (m_Matchmaker == nullptr)
+	{
+		m_Matchmaker = NewObject<UMultiplayerMatchmaker>(this);
+		m_Matchmaker->Initialize(this);
+	}
+
+	return m_Matchmaker;
+}
+
+void UMultiplayerSessionsSubsystem::SetHostSuccession(const TArray<FMultiplayerHostSuccessor>& Successors)
+{
+	m_HostSuccession = Successors;
+}
+
+FString UMultiplayerSessionsSubsystem::GetSuccessorConnectAddress(const APlayerController* PlayerController)
+{
+	if (PlayerController == nullptr)
+		return FString();
+
+	const int32 Port = FURL::UrlConfig.DefaultPort;
+	IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
+
+	// 스팀은 P2P로 접속하기 때문에 IP가 아니라 넷ID로 주소를 만든다.
+	if (Subsystem && Subsystem->GetSubsystemName() == "STEAM")
+	{
+		const APlayerState* PlayerState = PlayerController->PlayerState;
+		if (PlayerState == nullptr || !PlayerState->GetUniqueId().IsValid())
+			return FString();
+
+		return FString::Printf(TEXT("steam.%s:%d"), *PlayerState->GetUniqueId().ToString(), Port);
+	}
+
+	UNetConnection* Connection = PlayerController->GetNetConnection();
+	if (Connection == nullptr)
+		return FString();
+
+	// 새 호스트는 기본 포트로 listen 서버를 연다.
+	return FString::Printf(TEXT("%s:%d"), *Connection->LowLevelGetRemoteAddress(false), Port);
+}
+
+void UMultiplayerSessionsSubsystem::HandleNetworkFailure(UWorld* World, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString)
+{
+	// 로비가 PreLogin에서 거절하면 맵을 불러오기 전에 연결이 끊기고 월드 없이 호출된다.
+	if (FailureType == ENetworkFailure::PendingConnectionFailure)
+	{
+		EMultiplayerAdmissionResult Reason;
+		if (FMultiplayerAdmission::ParseRejectMessage(ErrorString, Reason))
+		{
+			HandleJoinRejected(Reason);
+			return;
+		}
+	}
+
+	// 새 호스트에게 접속하지 못했다. 아직 로비를 열지 못했을 수 있어서 조금 뒤에 다시 시도
+	if (m_HostMigrationState == EHostMigrationState::Travelling && NetDriver && NetDriver->NetDriverName == NAME_PendingNetDriver)
+	{
+		RetryTravelToNewHost();
+		return;
+	}
+
+	if (FailureType == ENetworkFailure::PendingConnectionFailure)
+		return;
+
+	// 재접속 캐시는 끊긴 시점부터 오래되기 시작한다.
+	if (World && NetDriver && NetDriver->NetDriverName == NAME_GameNetDriver && World->GetNetMode() == NM_Client)
+	{
+		m_DisconnectTime = FPlatformTime::Seconds();
+	}
+
+	if (!m_bHostMigrationEnabled || World == nullptr || NetDriver == nullptr)
+		return;
+
+	// 클라이언트에서 호스트와의 게임 연결이 끊긴 경우만 처리
+	if (NetDriver->NetDriverName != NAME_GameNetDriver || World->GetNetMode() != NM_Client)
+		return;
+
+	if (FailureType != ENetworkFailure::ConnectionLost &&
+		FailureType != ENetworkFailure::ConnectionTimeout &&
+		FailureType != ENetworkFailure::FailureReceived)
+		return;
+
+	if (m_HostSuccession.Num() == 0 || m_HostMigrationState != EHostMigrationState::None)
+		return;
+
+	PrepareHostMigration(World);
+}
+
+void UMultiplayerSessionsSubsystem::HandleJoinRejected(EMultiplayerAdmissionResult Reason)
+{
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Join rejected by lobby: %s"),
+		*StaticEnum<EMultiplayerAdmissionResult>()->GetNameStringByValue(static_cast<int64>(Reason)));
+
+	// 새 호스트의 로비가 거절했다면 다시 시도해도 같은 결과
+	if (m_HostMigrationState == EHostMigrationState::Travelling)
+	{
+		FinishHostMigration();
+	}
+
+	// 거절당한 세션으로 재접속하지 않도록
+	m_bRejoinPending = false;
+	m_LastConnectString.Empty();
+	m_LastJoinedResult = FOnlineSessionSearchResult();
+
+	// 참가했던 세션이 남아있으면 다음 참가가 실패하기 때문에 먼저 정리하고 알린다.
+	if (m_SessionInterface.IsValid() && m_SessionInterface->GetNamedSession(NAME_GameSession) != nullptr)
+	{
+		m_PendingJoinRejection = Reason;
+		DestroySession();
+
+		// 파괴 요청이 바로 실패했다면 완료 콜백이 오지 않는다.
+		if (m_DestroySessionCompleteDelegateHandle.IsValid())
+			return;
+
+		m_PendingJoinRejection.Reset();
+	}
+
+	MultiplayerOnJoinRejected.Broadcast(Reason);
+}
+
+void UMultiplayerSessionsSubsystem::PrepareHostMigration(UWorld* World)
+{
+	const ULocalPlayer* LocalPlayer = World->GetFirstLocalPlayerFromController();
+	if (LocalPlayer == nullptr || !LocalPlayer->GetPreferredUniqueNetId().IsValid())
+		return;
+
+	// 참가했던 세션이 광고하던 설정 그대로 다시 광고한다. 엔진이 실패 처리로 세션을 정리할 수 있어서 지금 저장
+	const FOnlineSessionSettings* JoinedSettings = m_SessionInterface.IsValid() ? m_SessionInterface->GetSessionSettings(NAME_GameSession) : nullptr;
+	if (JoinedSettings == nullptr && m_LastJoinedResult.IsValid())
+	{
+		JoinedSettings = &m_LastJoinedResult.Session.SessionSettings;
+	}
+
+	if (JoinedSettings == nullptr)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Host migration skipped, the joined session settings are gone"));
+		return;
+	}
+
+	m_LastNumPublicConnections = JoinedSettings->NumPublicConnections;
+	m_LastMatchType = FMultiplayerSessionInfo::ReadMatchType(*JoinedSettings);
+
+	// 모든 클라이언트가 같은 목록을 가지고 있기 때문에 따로 투표 없이 첫번째 플레이어가 새 호스트가 된다.
+	// 목록은 승계가 끝날때까지 남겨두고, 새 호스트가 실패하면 모두 같은 순서로 다음 플레이어로 넘어간다.
+	m_HostMigrationLocalPlayerId = LocalPlayer->GetPreferredUniqueNetId()->ToString();
+	m_HostMigrationSuccessorIndex = 0;
+	SelectHostSuccessor();
+
+	m_HostMigrationTravelURL = FString::Printf(TEXT("%s?listen"), *World->URL.Map);
+	m_HostProbeAttempts = 0;
+
+	// 이 콜백 뒤에 엔진이 기본 맵으로 이동한다. 승계는 그 맵을 불러온 뒤에 이어간다.
+	m_HostMigrationState = EHostMigrationState::WaitingForMap;
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Lost the host, %s"),
+		m_bHostLeavingNotified ? TEXT("host announced it was leaving") : TEXT("checking whether the host left before migrating"));
+}
+
+void UMultiplayerSessionsSubsystem::BeginHostMigration()
+{
+	MultiplayerOnHostMigrationStarted.Broadcast(m_bIsNewHost);
+
+	const bool bHasJoinedSession = m_SessionInterface.IsValid() && m_SessionInterface->GetNamedSession(NAME_GameSession) != nullptr;
+
+	if (m_bIsNewHost)
+	{
+		m_HostMigrationState = EHostMigrationState::CreatingSession;
+
+		// 클라이언트로 참가했던 세션을 먼저 정리하고 파괴가 끝나면 새 세션을 생성
+		if (bHasJoinedSession)
+		{
+			m_bCreateSessionOnDestroy = true;
+			m_LastShouldAdvertise = true;
+			DestroySession();
+		}
+		else
+		{
+			CreateSession(m_LastNumPublicConnections, m_LastMatchType);
+		}
+		return;
+	}
+
+	if (bHasJoinedSession)
+	{
+		DestroySession();
+	}
+
+	// 새 호스트가 로비를 열 시간을 주고 검색 없이 바로 접속
+	m_HostMigrationState = EHostMigrationState::Travelling;
+
+	UGameInstance* GameInstance = GetGameInstance();
+	if (GameInstance)
+	{
+		GameInstance->GetTimerManager().SetTimer(m_HostMigrationTimerHandle, this, &ThisClass::TravelToNewHost, m_HostMigrationGraceTime, false);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::SelectHostSuccessor()
+{
+	m_HostMigrationSuccessor = m_HostSuccession[m_HostMigrationSuccessorIndex];
+	m_bIsNewHost = m_HostMigrationSuccessor.PlayerId == m_HostMigrationLocalPlayerId;
+	m_HostMigrationTravelAttempts = 0;
+}
+
+void UMultiplayerSessionsSubsystem::FallBackToNextHostSuccessor()
+{
+	++m_HostMigrationSuccessorIndex;
+	if (!m_HostSuccession.IsValidIndex(m_HostMigrationSuccessorIndex))
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Host migration gave up, no successor left to try"));
+		FinishHostMigration();
+		return;
+	}
+
+	if (GetGameInstance())
+	{
+		GetGameInstance()->GetTimerManager().ClearTimer(m_HostMigrationTimerHandle);
+	}
+
+	SelectHostSuccessor();
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Host migration falling back to successor %d/%d%s"),
+		m_HostMigrationSuccessorIndex + 1, m_HostSuccession.Num(), m_bIsNewHost ? TEXT(", this client is the new host") : TEXT(""));
+
+	BeginHostMigration();
+}
+
+void UMultiplayerSessionsSubsystem::ProbeHost()
+{
+	++m_HostProbeAttempts;
+	m_HostMigrationState = EHostMigrationState::Probing;
+
+	// 예약 요청에 응답이 온다면 호스트는 살아있고 끊긴 것은 이쪽 연결이다.
+	if (!RequestReservation())
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Host migration skipped, the lobby has no reservation beacon to confirm the host left"));
+		FinishHostMigration();
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnHostProbeComplete(EMultiplayerAdmissionResult Result)
+{
+	if (Result == EMultiplayerAdmissionResult::ReservationFailed)
+	{
+		// 한번은 일시적인 문제일 수 있어서 다시 확인. 비콘 클라이언트를 정리하는 중이라 다음 틱에
+		if (m_HostProbeAttempts < MaxHostProbeAttempts && GetGameInstance())
+		{
+			GetGameInstance()->GetTimerManager().SetTimerForNextTick(this, &ThisClass::ProbeHost);
+			return;
+		}
+
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Host did not answer %d probe(s), starting host migration"), m_HostProbeAttempts);
+		BeginHostMigration();
+		return;
+	}
+
+	// 호스트가 응답했다. 자리를 받았다면 같은 로비로 다시 접속하고 아니라면 거절로 알린다.
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Host is still reachable, rejoining instead of migrating"));
+	FinishHostMigration();
+
+	if (Result == EMultiplayerAdmissionResult::Accepted)
+	{
+		TravelToSession(m_LastConnectString);
+		return;
+	}
+
+	HandleJoinRejected(Result);
+}
+
+void UMultiplayerSessionsSubsystem::TravelToNewHost()
+{
+	++m_HostMigrationTravelAttempts;
+
+	TravelToSession(m_HostMigrationSuccessor.ConnectAddress);
+}
+
+void UMultiplayerSessionsSubsystem::RetryTravelToNewHost()
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	if (m_HostMigrationTravelAttempts >= MaxHostMigrationTravelAttempts || GameInstance == nullptr)
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Could not reach the new host after %d attempts"), m_HostMigrationTravelAttempts);
+		FallBackToNextHostSuccessor();
+		return;
+	}
+
+	GameInstance->GetTimerManager().SetTimer(m_HostMigrationTimerHandle, this, &ThisClass::TravelToNewHost, m_HostMigrationGraceTime, false);
+}
+
+void UMultiplayerSessionsSubsystem::FinishHostMigration()
+{
+	m_HostMigrationState = EHostMigrationState::None;
+	m_bHostLeavingNotified = false;
+	// 새 로비가 새 목록을 보낸다. 남은 목록으로 다시 승계하지 않도록 비운다.
+	m_HostSuccession.Reset();
+
+	if (GetGameInstance())
+	{
+		GetGameInstance()->GetTimerManager().ClearTimer(m_HostMigrationTimerHandle);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnPostLoadMap(UWorld* World)
+{
+	// 세션은 메뉴에서 만들고 로비에서 listen 서버가 열린다. 실제로 열린 포트로 비콘을 다시 만든다.
+	if (m_LanDiscovery.IsValid() && m_LanDiscovery->IsBroadcasting())
+	{
+		StartLanBroadcast();
+	}
+
+	switch (m_HostMigrationState)
+	{
+	case EHostMigrationState::WaitingForMap:
+		// 엔진의 실패 처리 이동이 끝났다. 이제 이동해도 덮어써지지 않는다.
+		if (m_bHostLeavingNotified)
+		{
+			BeginHostMigration();
+		}
+		else
+		{
+			ProbeHost();
+		}
+		break;
+
+	case EHostMigrationState::Travelling:
+		// 새 호스트의 로비를 불러왔다면 승계가 끝난 것
+		if (World && World->GetNetMode() == NM_Client)
+		{
+			FinishHostMigration();
+		}
+		break;
+
+	case EHostMigrationState::None:
+		// 이전 로비에서 받은 알림은 새 맵에서 의미가 없다.
+		m_bHostLeavingNotified = false;
+		break;
+
+	default:
+		break;
+	}
+}
+
+bool UMultiplayerSessionsSubsystem::GetLastConnectString(FString& OutAddress) const
+{
+	if (m_LastConnectString.IsEmpty())
+		return false;
+
+	OutAddress = m_LastConnectString;
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::TravelToSession(const FString& Address)
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	if (GameInstance == nullptr || Address.IsEmpty())
+		return;
+
+	// 세션으로 이동하면 더 이상 LAN 비콘을 받을 필요가 없다.
+	StopLanDiscovery();
+
+	APlayerController* PlayerController = GameInstance->GetFirstLocalPlayerController();
+	if (PlayerController)
+	{
+		const FString URL = FString::Printf(TEXT("%s?%s=%d"), *Address, FMultiplayerAdmission::BuildOption, GetBuildUniqueId());
+		PlayerController->ClientTravel(URL, ETravelType::TRAVEL_Absolute);
+	}
+}
+
+bool UMultiplayerSessionsSubsystem::RequestReservation()
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr || !m_SessionInterface.IsValid() || !m_LastJoinedResult.IsValid())
+		return false;
+
+	// 비콘을 광고하지 않는 로비는 PreLogin에서만 확인한다.
+	int32 BeaconPort = 0;
+	FString BeaconAddress;
+	if (!FMultiplayerSessionKeys::BeaconPort.Get(m_LastJoinedResult.Session.SessionSettings, BeaconPort) || BeaconPort <= 0 ||
+		!m_SessionInterface->GetResolvedConnectString(m_LastJoinedResult, NAME_BeaconPort, BeaconAddress))
+		return false;
+
+	const ULocalPlayer* LocalPlayer = World->GetFirstLocalPlayerFromController();
+	if (LocalPlayer == nullptr || !LocalPlayer->GetPreferredUniqueNetId().IsValid())
+		return false;
+
+	TArray<FString> PlayerIds;
+	PlayerIds.Add(LocalPlayer->GetPreferredUniqueNetId()->ToString());
+	if (m_bPartyJoinPending)
+	{
+		PlayerIds.Append(m_PartyMemberIds);
+	}
+
+	if (m_ReservationClient.IsValid())
+	{
+		m_ReservationClient->OnReservationComplete.RemoveAll(this);
+		m_ReservationClient->DestroyBeacon();
+	}
+
+	AMultiplayerReservationBeaconClient* ReservationClient = World->SpawnActor<AMultiplayerReservationBeaconClient>();
+	if (ReservationClient == nullptr)
+		return false;
+
+	ReservationClient->OnReservationComplete.AddUObject(this, &ThisClass::OnReservationComplete);
+
+	if (!ReservationClient->RequestReservation(BeaconAddress, PlayerIds, m_ReservationTimeout))
+	{
+		ReservationClient->DestroyBeacon();
+		return false;
+	}
+
+	m_ReservationClient = ReservationClient;
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::OnReservationComplete(EMultiplayerAdmissionResult Result)
+{
+	// 비콘은 결과를 알린 뒤에 스스로 연결을 닫는다.
+	m_ReservationClient.Reset();
+
+	if (m_HostMigrationState == EHostMigrationState::Probing)
+	{
+		OnHostProbeComplete(Result);
+		return;
+	}
+
+	if (Result == EMultiplayerAdmissionResult::Accepted)
+	{
+		if (m_bRejoinPending)
+		{
+			m_bRejoinPending = false;
+			TravelToSession(m_LastConnectString);
+			return;
+		}
+
+		// 파티원이 따라올 수 있도록 파티장이 이동하기 전에 알린다.
+		if (m_bPartyJoinPending)
+		{
+			FinishPartyJoin(true);
+		}
+
+		MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::Success);
+		return;
+	}
+
+	HandleJoinRejected(Result);
+}
+
+void UMultiplayerSessionsSubsystem::FindPartySession(const TArray<FString>& MemberIds, int32 MaxSearchResults)
+{
+	if (m_bPartyJoinPending)
+		return;
+
+	UGameInstance* GameInstance = GetGameInstance();
+	if (!m_SessionInterface.IsValid() || GameInstance == nullptr)
+	{
+		MultiplayerOnPartySessionReady.Broadcast(false);
+		return;
+	}
+
+	m_PartyMemberIds = MemberIds;
+	m_PartyCandidates.Reset();
+	m_bPartySearchPending = true;
+	m_bPartyJoinPending = true;
+
+	// 어느 단계에서 응답이 오지 않더라도 파티가 묶여있지 않도록
+	GameInstance->GetTimerManager().SetTimer(m_PartyJoinTimerHandle, this, &ThisClass::OnPartyJoinTimeout, PartyJoinTimeout, false);
+
+	// 파티원 각자가 검색하지 않고 파티장 한명만 검색
+	// 요청이 바로 실패하면 이 안에서 OnPartySearchComplete가 불려서 끝난다.
+	m_PartyFindSessionCompleteDelegateHandle = MultiplayerOnFindSessionComplete.AddUObject(this, &ThisClass::OnPartySearchComplete);
+	m_PartyJoinRejectedDelegateHandle = MultiplayerOnJoinRejected.AddUObject(this, &ThisClass::OnPartyJoinRejected);
+
+	FindSession(MaxSearchResults);
+}
+
+void UMultiplayerSessionsSubsystem::CancelPartySession()
+{
+	if (!m_bPartyJoinPending)
+		return;
+
+	const bool bWasSearching = m_bPartySearchPending;
+	ResetPartyJoin();
+
+	// 파티 검색을 기다리는 곳이 없다면 검색도 취소
+	if (bWasSearching)
+	{
+		CancelFindSession();
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnPartyJoinTimeout()
+{
+	if (!m_bPartyJoinPending)
+		return;
+
+	UE_LOG(LogMultiplayerSessions, Warning, TEXT("Party join timed out after %.0fs (%s)"), PartyJoinTimeout,
+		m_bPartySearchPending ? TEXT("searching") : TEXT("joining"));
+
+	CancelPartySession();
+	MultiplayerOnPartySessionReady.Broadcast(false);
+}
+
+void UMultiplayerSessionsSubsystem::OnPartySearchComplete(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful)
+{
+	if (!m_bPartySearchPending)
+		return;
+
+	m_bPartySearchPending = false;
+	MultiplayerOnFindSessionComplete.Remove(m_PartyFindSessionCompleteDelegateHandle);
+
+	if (!bWasSuccessful || !m_LastSessionSearch.IsValid())
+	{
+		FinishPartyJoin(false);
+		return;
+	}
+
+	// 제한에 걸려 마지막 결과로 응답했을 수도 있어서 자리 수는 여기서 다시 확인
+	const int32 PartySize = m_PartyMemberIds.Num() + 1;
+	FMultiplayerSearchResultProcessor::FFilterAndScore FilterAndScore = [PartySize](const FOnlineSessionSearchResult& SearchResult, FMultiplayerDecodedResult& Decoded)
+		{
+			if (Decoded.OpenSlots < PartySize || Decoded.SessionInfo.State != EMultiplayerSessionState::Lobby)
+				return false;
+
+			Decoded.Score = 1.f - FMath::Clamp(Decoded.PingInMs / 300.f, 0.f, 1.f);
+			return true;
+		};
+
+	TWeakObjectPtr<UMultiplayerSessionsSubsystem> WeakThis(this);
+	FMultiplayerSearchResultProcessor::ProcessAsync(m_LastSessionSearch.ToSharedRef(), MoveTemp(FilterAndScore),
+		[WeakThis](TSharedRef<const FOnlineSessionSearch> Search, TArray<FMultiplayerDecodedResult>&& SortedResults)
+		{
+			if (WeakThis.IsValid())
+			{
+				WeakThis->OnPartySearchProcessed(Search, MoveTemp(SortedResults));
+			}
+		});
+}
+
+void UMultiplayerSessionsSubsystem::OnPartySearchProcessed(TSharedRef<const FOnlineSessionSearch> Search, TArray<FMultiplayerDecodedResult>&& SortedResults)
+{
+	if (!m_bPartyJoinPending)
+		return;
+
+	// 참가가 끝나면 검색 결과가 해제되기 때문에 후보 몇개만 복사해둔다.
+	m_PartyCandidates.Reset();
+	for (const FMultiplayerDecodedResult& Decoded : SortedResults)
+	{
+		if (m_PartyCandidates.Num() >= MaxPartyCandidates)
+			break;
+
+		if (Search->SearchResults.IsValidIndex(Decoded.ResultIndex))
+		{
+			m_PartyCandidates.Add(Search->SearchResults[Decoded.ResultIndex]);
+		}
+	}
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Party of %d found %d candidate session(s)"), m_PartyMemberIds.Num() + 1, m_PartyCandidates.Num());
+
+	JoinNextPartyCandidate();
+}
+
+void UMultiplayerSessionsSubsystem::OnPartyJoinRejected(EMultiplayerAdmissionResult Reason)
+{
+	if (m_bPartyJoinPending)
+	{
+		JoinNextPartyCandidate();
+	}
+}
+
+void UMultiplayerSessionsSubsystem::JoinNextPartyCandidate()
+{
+	while (m_PartyCandidates.Num() > 0)
+	{
+		const FOnlineSessionSearchResult Candidate = m_PartyCandidates[0];
+		m_PartyCandidates.RemoveAt(0);
+
+		// 참가가 끝나면 RequestReservation에서 파티 전원의 자리를 예약
+		JoinSession(Candidate);
+
+		// 요청이 바로 실패하지 않았다면 결과를 기다린다.
+		if (IsJoinSessionInProgress() || m_bJoinSessionOnDestroy)
+			return;
+	}
+
+	FinishPartyJoin(false);
+}
+
+void UMultiplayerSessionsSubsystem::FinishPartyJoin(bool bWasSuccessful)
+{
+	ResetPartyJoin();
+
+	MultiplayerOnPartySessionReady.Broadcast(bWasSuccessful);
+}
+
+void UMultiplayerSessionsSubsystem::ResetPartyJoin()
+{
+	m_bPartySearchPending = false;
+	m_bPartyJoinPending = false;
+	m_PartyCandidates.Empty();
+
+	MultiplayerOnFindSessionComplete.Remove(m_PartyFindSessionCompleteDelegateHandle);
+	MultiplayerOnJoinRejected.Remove(m_PartyJoinRejectedDelegateHandle);
+	m_PartyFindSessionCompleteDelegateHandle.Reset();
+	m_PartyJoinRejectedDelegateHandle.Reset();
+
+	if (GetGameInstance())
+	{
+		GetGameInstance()->GetTimerManager().ClearTimer(m_PartyJoinTimerHandle);
+	}
+}
+
+bool UMultiplayerSessionsSubsystem::FollowPartyLeader(const FUniqueNetIdRepl& LeaderId)
+{
+	const ULocalPlayer* LocalPlayer = GetWorld() ? GetWorld()->GetFirstLocalPlayerFromController() : nullptr;
+	if (!m_SessionInterface.IsValid() || LocalPlayer == nullptr || !LeaderId.IsValid() || !LocalPlayer->GetPreferredUniqueNetId().IsValid())
+		return false;
+
+	if (m_FindFriendSessionCompleteDelegateHandle.IsValid())
+		return true;
+
+	const int32 LocalUserNum = LocalPlayer->GetControllerId();
+	m_FindFriendSessionCompleteDelegateHandle = m_SessionInterface->AddOnFindFriendSessionCompleteDelegate_Handle(LocalUserNum,
+		FOnFindFriendSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnFindFriendSessionComplete));
+
+	if (!m_SessionInterface->FindFriendSession(*LocalPlayer->GetPreferredUniqueNetId(), *LeaderId))
+	{
+		m_SessionInterface->ClearOnFindFriendSessionCompleteDelegate_Handle(LocalUserNum, m_FindFriendSessionCompleteDelegateHandle);
+		return false;
+	}
+
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::OnFindFriendSessionComplete(int32 LocalUserNum, bool bWasSuccessful, const TArray<FOnlineSessionSearchResult>& SearchResults)
+{
+	if (m_SessionInterface.IsValid())
+	{
+		m_SessionInterface->ClearOnFindFriendSessionCompleteDelegate_Handle(LocalUserNum, m_FindFriendSessionCompleteDelegateHandle);
+	}
+
+	if (!bWasSuccessful || SearchResults.Num() == 0 || !SearchResults[0].IsValid())
+	{
+		MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::SessionDoesNotExist);
+		return;
+	}
+
+	// 자리는 파티장이 예약해뒀기 때문에 일반 참가와 같은 흐름으로 이동
+	JoinSession(SearchResults[0]);
+}
+
+bool UMultiplayerSessionsSubsystem::StartReservationHost(UWorld* World, const FMultiplayerOnReservationRequest& OnReservationRequest)
+{
+	if (World == nullptr)
+		return false;
+
+	StopReservationHost();
+
+	// 리슨 포트는 DefaultEngine.ini의 [/Script/OnlineSubsystemUtils.OnlineBeaconHost]에서 읽는다.
+	AOnlineBeaconHost* BeaconHost = World->SpawnActor<AOnlineBeaconHost>(AOnlineBeaconHost::StaticClass());
+	if (BeaconHost == nullptr)
+		return false;
+
+	if (!BeaconHost->InitHost())
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Failed to open the reservation beacon host"));
+
+		BeaconHost->DestroyBeacon();
+		return false;
+	}
+
+	AMultiplayerReservationBeaconHostObject* HostObject = World->SpawnActor<AMultiplayerReservationBeaconHostObject>();
+	if (HostObject == nullptr)
+	{
+		BeaconHost->DestroyBeacon();
+		return false;
+	}
+
+	HostObject->OnReservationRequest = OnReservationRequest;
+	BeaconHost->RegisterHost(HostObject);
+	BeaconHost->PauseBeaconRequests(false);
+
+	m_ReservationBeaconHost = BeaconHost;
+	m_ReservationHostObject = HostObject;
+	m_ReservationBeaconPort = BeaconHost->GetListenPort();
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Reservation beacon listening on port %d"), m_ReservationBeaconPort);
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::StopReservationHost()
+{
+	if (m_ReservationBeaconHost.IsValid())
+	{
+		if (m_ReservationHostObject.IsValid())
+		{
+			m_ReservationBeaconHost->UnregisterHost(m_ReservationHostObject->GetBeaconType());
+		}
+		m_ReservationBeaconHost->DestroyBeacon();
+	}
+
+	if (m_ReservationHostObject.IsValid())
+	{
+		m_ReservationHostObject->Destroy();
+	}
+
+	m_ReservationBeaconHost.Reset();
+	m_ReservationHostObject.Reset();
+	m_ReservationBeaconPort = 0;
+}
+
+bool UMultiplayerSessionsSubsystem::HasSession() const
+{
+	return m_SessionInterface.IsValid() && m_SessionInterface->GetNamedSession(NAME_GameSession) != nullptr;
+}
+
+int32 UMultiplayerSessionsSubsystem::GetSessionCapacity() const
+{
+	const FOnlineSessionSettings* Settings = m_SessionInterface.IsValid() ? m_SessionInterface->GetSessionSettings(NAME_GameSession) : nullptr;
+
+	return Settings ? Settings->NumPublicConnections : 0;
+}
+
+EMultiplayerSessionState UMultiplayerSessionsSubsystem::GetSessionState() const
+{
+	// 아직 광고에 반영되지 않은 상태가 더 최신이다.
+	if (m_bSessionUpdatePending)
+		return m_PendingSessionState;
+
+	const FOnlineSessionSettings* Settings = m_SessionInterface.IsValid() ? m_SessionInterface->GetSessionSettings(NAME_GameSession) : nullptr;
+
+	return Settings ? FMultiplayerSessionInfo::Read(*Settings).State : EMultiplayerSessionState::Lobby;
+}
+
+int32 UMultiplayerSessionsSubsystem::GetBuildUniqueId()
+{
+	// 실행 중에는 바뀌지 않는다.
+	static const int32 BuildUniqueId = []()
+	{
+		uint32 Hash = FNetworkVersion::GetLocalNetworkVersion();
+
+		const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("MultiplayerSessions"));
+		if (Plugin.IsValid())
+		{
+			Hash = HashCombine(Hash, GetTypeHash(Plugin->GetDescriptor().Version));
+		}
+
+		// INDEX_NONE는 빌드를 확인하지 않는다는 의미로 쓰기 때문에 양수로 맞춘다.
+		const int32 Result = static_cast<int32>(Hash & 0x7FFFFFFF);
+
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Build unique id %d (network version %u, plugin version %d)"),
+			Result, FNetworkVersion::GetLocalNetworkVersion(), Plugin.IsValid() ? Plugin->GetDescriptor().Version : 0);
+
+		return Result;
+	}();
+
+	return BuildUniqueId;
+}
+
+bool UMultiplayerSessionsSubsystem::Rejoin()
+{
+	if (!m_LastJoinedResult.IsValid() || m_LastConnectString.IsEmpty())
+	{
+		// 재시작해서 메모리에 검색 결과가 없다면 디스크 캐시의 세션 아이디로 세션을 찾아서 참가
+		const FMultiplayerSessionCacheRecord* LastJoined = m_SessionCache.IsValid() ? m_SessionCache->FindLastJoined() : nullptr;
+		if (LastJoined == nullptr)
+			return false;
+
+		if (FDateTime::UtcNow() - FDateTime(LastJoined->LastJoinedTicks) > FTimespan::FromSeconds(m_RejoinCacheLifetime))
+			return false;
+
+		const FString SessionId = FMultiplayerSessionCache::GetSessionId(*LastJoined);
+		const FString ConnectAddress = FMultiplayerSessionCache::GetConnectAddress(*LastJoined);
+
+		const ULocalPlayer* LocalPlayer = GetGameInstance() ? GetGameInstance()->GetFirstGamePlayer() : nullptr;
+		const FUniqueNetIdRepl UserId = LocalPlayer ? LocalPlayer->GetPreferredUniqueNetId() : FUniqueNetIdRepl();
+		const TSharedPtr<const FUniqueNetId> SessionNetId = m_SessionInterface.IsValid() ? m_SessionInterface->CreateSessionIdFromString(SessionId) : TSharedPtr<const FUniqueNetId>();
+		if (UserId.IsValid() && SessionNetId.IsValid())
+		{
+			const FOnSingleSessionResultCompleteDelegate CompletionDelegate = FOnSingleSessionResultCompleteDelegate::CreateUObject(this, &ThisClass::OnRejoinSessionFound, SessionId, ConnectAddress);
+			if (m_SessionInterface->FindSessionById(*UserId, *SessionNetId, *UserId, CompletionDelegate))
+				return true;
+		}
+
+		// 아이디로 찾을 수 없는 백엔드. 예약을 요구하지 않는 로비에만 들어갈 수 있다.
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Rejoin could not look up session %s, travelling to the cached address without joining"), *SessionId);
+		TravelToSession(ConnectAddress);
+		return true;
+	}
+
+	// 참가한 뒤로 끊긴 적이 없다면 캐시는 지금도 유효하다.
+	if (m_DisconnectTime > m_LastJoinTime && FPlatformTime::Seconds() - m_DisconnectTime > m_RejoinCacheLifetime)
+		return false;
+
+	// 아직 세션에 참가한 상태라면 접속만 다시 하면 된다.
+	if (m_SessionInterface.IsValid() && m_SessionInterface->GetNamedSession(NAME_GameSession) != nullptr)
+	{
+		TravelToSession(m_LastConnectString);
+		return true;
+	}
+
+	// 세션에서 빠졌다면 캐시된 검색 결과로 바로 참가. 참가가 끝나면 OnJoinSessionComplete에서 접속
+	m_bRejoinPending = true;
+	JoinSession(m_LastJoinedResult);
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::OnRejoinSessionFound(int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& SearchResult, FString SessionId, FString ConnectAddress)
+{
+	// 세션에 다시 참가하고 예약을 받은 뒤에 OnJoinSessionComplete, OnReservationComplete에서 접속
+	if (bWasSuccessful && SearchResult.IsValid())
+	{
+		m_bRejoinPending = true;
+		JoinSession(SearchResult);
+		return;
+	}
+
+	// 검색은 성공했는데 결과가 없다면 세션이 사라진 것
+	if (bWasSuccessful)
+	{
+		if (m_SessionCache.IsValid())
+		{
+			m_SessionCache->Remove(SessionId);
+			m_SessionCache->Save();
+		}
+
+		MultiplayerOnJoinSessionComplete.Broadcast(EOnJoinSessionCompleteResult::SessionDoesNotExist);
+		return;
+	}
+
+	// 실패는 지원하지 않는 백엔드일 수도 있어서 주소로 바로 접속
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Rejoin could not look up session %s, travelling to the cached address without joining"), *SessionId);
+	TravelToSession(ConnectAddress);
+}
+
+TArray<FMultiplayerRecentSession> UMultiplayerSessionsSubsystem::GetRecentSessions() const
+{
+	if (!m_SessionCache.IsValid())
+		return TArray<FMultiplayerRecentSession>();
+
+	return m_SessionCache->GetRecentSessions();
+}
+
+void UMultiplayerSessionsSubsystem::ReleaseSearchResults()
+{
+	m_LastSessionSearch.Reset();
+	m_SearchMemoryUsage = 0;
+
+	// 이 서브시스템이 들고 있던 참조만 기준으로 한 값이다.
+	// 브라우저나 비동기 처리가 아직 참조를 들고 있다면 실제 메모리는 그 참조가 사라질때 해제되고, 그동안은 이 통계에 잡히지 않는다.
+	SET_MEMORY_STAT(STAT_MultiplayerSearchResultsMemory, 0);
+	SET_DWORD_STAT(STAT_MultiplayerSearchResultsHeld, 0);
+}
+
+void UMultiplayerSessionsSubsystem::RemoveIncompatibleResults()
+{
+	// 녹화된 결과는 녹화한 빌드의 아이디를 가지고 있다. 여기서 거르면 다른 빌드에서 녹화한 파일은 항상 빈 결과가 된다.
+	if (m_Replay.IsValid())
+	{
+		m_LastIncompatibleResults = 0;
+		UE_LOG(LogMultiplayerSessions, Verbose, TEXT("Replaying, kept %d result(s) without checking the build id"), m_LastSessionSearch->SearchResults.Num());
+		return;
+	}
+
+	const int32 BuildUniqueId = GetBuildUniqueId();
+
+	// 빌드 아이디를 광고하지 않는 세션은 이 기능 이전 빌드라서 역시 호환되지 않는다.
+	m_LastIncompatibleResults = m_LastSessionSearch->SearchResults.RemoveAll([BuildUniqueId](const FOnlineSessionSearchResult& SearchResult)
+		{
+			return FMultiplayerSessionKeys::BuildId.GetOr(SearchResult.Session.SessionSettings, INDEX_NONE) != BuildUniqueId;
+		});
+
+	if (m_LastIncompatibleResults <= 0)
+		return;
+
+	m_TotalIncompatibleResults += m_LastIncompatibleResults;
+	INC_DWORD_STAT_BY(STAT_MultiplayerIncompatibleResults, m_LastIncompatibleResults);
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Dropped %d session(s) from other builds (%d total)"), m_LastIncompatibleResults, m_TotalIncompatibleResults);
+}
+
+void UMultiplayerSessionsSubsystem::EnforceSearchBudget()
+{
+	if (!m_LastSessionSearch.IsValid())
+		return;
+
+	TArray<FOnlineSessionSearchResult>& SearchResults = m_LastSessionSearch->SearchResults;
+
+	// 백엔드가 MaxSearchResults보다 많이 돌려줄 수도 있어서 개수도 다시 확인
+	int32 NumToKeep = FMath::Min(SearchResults.Num(), m_SearchMaxResults);
+	int64 Usage = 0;
+
+	for (int32 Index = 0; Index < NumToKeep; ++Index)
+	{
+		const int64 ResultSize = sizeof(FOnlineSessionSearchResult) + GetSearchResultAllocatedSize(SearchResults[Index]);
+		if (Usage + ResultSize > m_SearchMaxBytes)
+		{
+			NumToKeep = Index;
+			break;
+		}
+
+		Usage += ResultSize;
+	}
+
+	if (NumToKeep < SearchResults.Num())
+	{
+		UE_LOG(LogMultiplayerSessions, Log, TEXT("Trimmed search results from %d to %d to stay within %lld bytes"), SearchResults.Num(), NumToKeep, m_SearchMaxBytes);
+
+		SearchResults.SetNum(NumToKeep);
+		SearchResults.Shrink();
+	}
+
+	m_SearchMemoryUsage = Usage + (SearchResults.GetSlack() * sizeof(FOnlineSessionSearchResult));
+
+	SET_MEMORY_STAT(STAT_MultiplayerSearchResultsMemory, m_SearchMemoryUsage);
+	SET_DWORD_STAT(STAT_MultiplayerSearchResultsHeld, SearchResults.Num());
+}
+
+void UMultiplayerSessionsSubsystem::RecordSearchResults(const TArray<FOnlineSessionSearchResult>& SessionResults)
+{
+	if (!m_SessionCache.IsValid() || !m_SessionInterface.IsValid())
+		return;
+
+	// 결과가 많아도 캐시 크기만큼만 기록
+	const int32 NumToRecord = FMath::Min(SessionResults.Num(), m_SessionCache->GetMaxRecords());
+	for (int32 Index = 0; Index < NumToRecord; ++Index)
+	{
+		const FOnlineSessionSearchResult& Result = SessionResults[Index];
+		if (!Result.IsValid())
+			continue;
+
+		const FOnlineSessionSettings& Settings = Result.Session.SessionSettings;
+
+		FString ConnectAddress;
+		m_SessionInterface->GetResolvedConnectString(Result, NAME_GamePort, ConnectAddress);
+
+		m_SessionCache->RecordSeen(Result.GetSessionIdStr(), ConnectAddress, Result.Session.OwningUserName,
+			Result.PingInMs, FMultiplayerSessionInfo::Read(Settings).Pack(), FMultiplayerSessionKeys::OpenSlots.GetOr(Settings, 0));
+	}
+}
+
+void UMultiplayerSessionsSubsystem::RevalidateNextCachedSession()
+{
+	if (!m_SessionInterface.IsValid() || !m_SessionCache.IsValid() || m_PendingRevalidation.Num() == 0)
+	{
+		m_PendingRevalidation.Empty();
+		return;
+	}
+
+	// 로컬 플레이어가 로그인하기 전이라면 조금 뒤에 다시 시도
+	const ULocalPlayer* LocalPlayer = GetGameInstance() ? GetGameInstance()->GetFirstGamePlayer() : nullptr;
+	const FUniqueNetIdRepl UserId = LocalPlayer ? LocalPlayer->GetPreferredUniqueNetId() : FUniqueNetIdRepl();
+	if (!UserId.IsValid())
+	{
+		GetGameInstance()->GetTimerManager().SetTimer(m_RevalidateTimerHandle, this, &ThisClass::RevalidateNextCachedSession, m_RevalidateInterval, false);
+		return;
+	}
+
+	const FString SessionId = m_PendingRevalidation.Pop(false);
+	const TSharedPtr<const FUniqueNetId> SessionNetId = m_SessionInterface->CreateSessionIdFromString(SessionId);
+	if (!SessionNetId.IsValid())
+	{
+		RevalidateNextCachedSession();
+		return;
+	}
+
+	const FOnSingleSessionResultCompleteDelegate CompletionDelegate = FOnSingleSessionResultCompleteDelegate::CreateUObject(this, &ThisClass::OnRevalidateSessionComplete, SessionId);
+	if (!m_SessionInterface->FindSessionById(*UserId, *SessionNetId, *UserId, CompletionDelegate))
+	{
+		// 아이디로 찾는 기능을 지원하지 않는 백엔드. 캐시는 그대로 두고 다음 검색 결과로 갱신한다.
+		UE_LOG(LogMultiplayerSessions, Verbose, TEXT("FindSessionById is not supported, skipping session cache revalidation"));
+		m_PendingRevalidation.Empty();
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnRevalidateSessionComplete(int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& SearchResult, FString SessionId)
+{
+	if (!m_SessionCache.IsValid())
+		return;
+
+	// 실패는 지원하지 않는 백엔드일 수도 있어서 지우지 않고 확인되지 않은 상태로 남겨둔다.
+	if (bWasSuccessful && SearchResult.IsValid())
+	{
+		m_SessionCache->MarkValidated(SessionId, SearchResult.PingInMs, FMultiplayerSessionKeys::OpenSlots.GetOr(SearchResult.Session.SessionSettings, 0));
+	}
+	else if (bWasSuccessful)
+	{
+		// 검색은 성공했는데 결과가 없다면 세션이 사라진 것
+		m_SessionCache->Remove(SessionId);
+		m_SessionCache->Save();
+	}
+
+	if (m_PendingRevalidation.Num() > 0 && GetGameInstance())
+	{
+		GetGameInstance()->GetTimerManager().SetTimer(m_RevalidateTimerHandle, this, &ThisClass::RevalidateNextCachedSession, m_RevalidateInterval, false);
+	}
+}
+
+bool UMultiplayerSessionsSubsystem::SetNetProfile(const FString& ProfileName)
+{
+	FMultiplayerNetProfile NetProfile;
+	if (!FMultiplayerNetProfile::Load(ProfileName, NetProfile))
+	{
+		UE_LOG(LogMultiplayerSessions, Warning, TEXT("Unknown net profile %s"), *ProfileName);
+		return false;
+	}
+
+	m_NetProfile = NetProfile;
+	ApplyNetProfile(GetWorld());
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::LogNetStats() const
+{
+	const UWorld* World = GetWorld();
+	if (World && World->GetNetDriver())
+	{
+		FMultiplayerNetProfile::LogNetDriverStats(*World->GetNetDriver());
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params)
+{
+	// 다른 게임 인스턴스의 월드는 건드리지 않는다. (PIE 여러 창)
+	if (Params.World && Params.World->GetGameInstance() == GetGameInstance())
+	{
+		ApplyNetProfile(Params.World);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::ApplyNetProfile(UWorld* World)
+{
+	if (m_NetProfile.Name.IsEmpty())
+		return;
+
+	// 리슨 서버는 Listen이 끝난 뒤, 클라이언트는 접속하면서 넷 드라이버가 만들어져 있다.
+	if (World && World->GetNetDriver())
+	{
+		m_NetProfile.Apply(*World->GetNetDriver());
+	}
+
+	if (GetGameInstance())
+	{
+		for (ULocalPlayer* LocalPlayer : GetGameInstance()->GetLocalPlayers())
+		{
+			if (LocalPlayer)
+			{
+				m_NetProfile.Apply(*LocalPlayer);
+			}
+		}
+	}
+}
+
+bool UMultiplayerSessionsSubsystem::StartLanDiscovery()
+{
+	if (!IsLanMatch())
+		return false;
+
+	return GetLanDiscovery().StartListening();
+}
+
+void UMultiplayerSessionsSubsystem::StopLanDiscovery()
+{
+	if (m_LanDiscovery.IsValid())
+	{
+		m_LanDiscovery->StopListening();
+	}
+}
+
+TArray<FMultiplayerLanSession> UMultiplayerSessionsSubsystem::GetLanSessions() const
+{
+	TArray<FMultiplayerLanSession> Sessions;
+
+	if (m_LanDiscovery.IsValid())
+	{
+		m_LanDiscovery->GetSessions().GenerateValueArray(Sessions);
+	}
+
+	return Sessions;
+}
+
+FMultiplayerLanDiscovery& UMultiplayerSessionsSubsystem::GetLanDiscovery()
+{
+	if (!m_LanDiscovery.IsValid())
+	{
+		m_LanDiscovery = MakeShared<FMultiplayerLanDiscovery>();
+		m_LanDiscovery->OnLanSessionsChanged.AddUObject(this, &ThisClass::OnLanSessionsChanged);
+	}
+
+	return *m_LanDiscovery;
+}
+
+bool UMultiplayerSessionsSubsystem::IsLanMatch() const
+{
+	IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
+
+	return Subsystem && Subsystem->GetSubsystemName() == "NULL";
+}
+
+void UMultiplayerSessionsSubsystem::OnLanSessionsChanged()
+{
+	MultiplayerOnLanSessionsUpdated.Broadcast();
+}
+
+void UMultiplayerSessionsSubsystem::FlushSessionOccupancy()
+{
+	if (!m_SessionInterface.IsValid() || !m_bSessionUpdatePending)
+		return;
+
+	FOnlineSessionSettings* CurrentSettings = m_SessionInterface->GetSessionSettings(NAME_GameSession);
+
+	if (CurrentSettings == nullptr)
+	{
+		m_bSessionUpdatePending = false;
+		return;
+	}
+
+	// 현재 세션 설정을 복사해서 인원 정보만 바꾼다.
+	FOnlineSessionSettings UpdatedSettings = *CurrentSettings;
+	const int32 OpenSlots = FMath::Max(UpdatedSettings.NumPublicConnections - m_PendingNumPlayers, 0);
+	FMultiplayerSessionKeys::OpenSlots.Set(UpdatedSettings, OpenSlots);
+
+	FMultiplayerSessionInfo SessionInfo = FMultiplayerSessionInfo::Read(UpdatedSettings);
+	SessionInfo.State = m_PendingSessionState;
+	FMultiplayerSessionKeys::SessionInfo.Set(UpdatedSettings, SessionInfo.Pack());
+
+	if (m_ReservationBeaconPort > 0)
+	{
+		FMultiplayerSessionKeys::BeaconPort.Set(UpdatedSettings, m_ReservationBeaconPort);
+	}
+
+	if (m_LanDiscovery.IsValid() && m_LanDiscovery->IsBroadcasting())
+	{
+		m_LanDiscovery->UpdateBroadcast(OpenSlots, SessionInfo.Pack());
+	}
+
+	m_bSessionUpdatePending = false;
+	m_bSessionUpdateInFlight = true;
+	m_LastSessionUpdateTime = FPlatformTime::Seconds();
+
+	m_UpdateSessionCompleteDelegateHandle = m_SessionInterface->AddOnUpdateSessionCompleteDelegate_Handle(m_UpdateSessionCompleteDelegate);
+
+	if (!m_SessionInterface->UpdateSession(NAME_GameSession, UpdatedSettings, true))
+	{
+		m_SessionInterface->ClearOnUpdateSessionCompleteDelegate_Handle(m_UpdateSessionCompleteDelegateHandle);
+		m_bSessionUpdateInFlight = false;
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if (m_SessionInterface)
+	{
+		m_SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(m_CreateSessionCompleteDelegateHandle);
+	}
+
+	UpdateListenerStats();
+
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->EndOperation(EMultiplayerRecordedOp::Create, bWasSuccessful);
+	}
+
+	// 미리 만든 세션은 호스트 버튼을 누르기 전까지 메뉴에 알리지 않는다.
+	if (m_SpeculativeState == ESpeculativeSessionState::Creating)
+	{
+		const ESpeculativeCreateAction Action = m_SpeculativeCreateAction;
+		m_SpeculativeCreateAction = ESpeculativeCreateAction::None;
+
+		if (!bWasSuccessful)
+		{
+			m_SpeculativeState = ESpeculativeSessionState::None;
+
+			// 이미 호스트 버튼을 눌렀다면 실패를 알려야 버튼이 다시 활성화된다.
+			if (Action == ESpeculativeCreateAction::Publish)
+			{
+				MultiplayerOnCreateSessionComplete.Broadcast(false);
+			}
+			// 다른 조건으로 요청했다면 지울 세션이 없으니 바로 만든다.
+			else if (Action == ESpeculativeCreateAction::Replace)
+			{
+				CreateSessionInternal(m_LastNumPublicConnections, m_LastMatchType, true);
+			}
+			else if (Action == ESpeculativeCreateAction::Restart)
+			{
+				m_SpeculativeState = ESpeculativeSessionState::Creating;
+				CreateSessionInternal(m_SpeculativeNumPublicConnections, m_SpeculativeMatchType, false);
+			}
+			return;
+		}
+
+		switch (Action)
+		{
+		case ESpeculativeCreateAction::Publish:
+			PublishSpeculativeSession();
+			break;
+		case ESpeculativeCreateAction::Replace:
+			// 세션이 남아있으니 CreateSessionInternal이 지운 뒤에 다시 만든다.
+			m_SpeculativeState = ESpeculativeSessionState::None;
+			CreateSessionInternal(m_LastNumPublicConnections, m_LastMatchType, true);
+			break;
+		case ESpeculativeCreateAction::Destroy:
+			m_SpeculativeState = ESpeculativeSessionState::None;
+			DestroySession();
+			break;
+		case ESpeculativeCreateAction::Restart:
+			// Creating을 유지한 채로 CreateSessionInternal이 지운 뒤에 새 조건으로 다시 만든다.
+			CreateSessionInternal(m_SpeculativeNumPublicConnections, m_SpeculativeMatchType, false);
+			break;
+		default:
+			m_SpeculativeState = ESpeculativeSessionState::Ready;
+			break;
+		}
+		return;
+	}
+
+	if (bWasSuccessful)
+	{
+		StartLanBroadcast();
+	}
+
+	// 호스트 승계로 만든 세션이라면 이전 로비를 listen 서버로 다시 연다.
+	// 세션은 엔진의 실패 처리 이동이 끝난 뒤에 만들기 때문에 이 이동이 덮어써지지 않는다.
+	// 만들지 못했다면 다른 클라이언트들과 같이 다음 승계자에게 넘긴다.
+	if (m_HostMigrationState == EHostMigrationState::CreatingSession)
+	{
+		UWorld* World = GetWorld();
+		if (bWasSuccessful && World)
+		{
+			FinishHostMigration();
+			World->ServerTravel(m_HostMigrationTravelURL);
+		}
+		else
+		{
+			FallBackToNextHostSuccessor();
+		}
+	}
+
+	MultiplayerOnCreateSessionComplete.Broadcast(bWasSuccessful);
+}
+
+void UMultiplayerSessionsSubsystem::StartLanBroadcast()
+{
+	// LAN 세션은 비콘으로도 광고해서 검색 타임아웃 없이 바로 발견되도록 한다.
+	if (!m_LastSessionSettings.IsValid() || !m_LastSessionSettings->bIsLANMatch)
+		return;
+
+	UWorld* World = GetWorld();
+	const ULocalPlayer* LocalPlayer = World ? World->GetFirstLocalPlayerFromController() : nullptr;
+
+	// 로비로 이동하기 전이라면 열게 될 포트. listen 서버가 열려있다면 실제로 바인딩한 포트를 쓴다.
+	// 포트가 사용 중이면 엔진이 다음 포트로 열 수 있어서 설정의 기본 포트와 다를 수 있다.
+	int32 GamePort = World ? World->URL.Port : FURL::UrlConfig.DefaultPort;
+	UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	const TSharedPtr<const FInternetAddr> LocalAddr = NetDriver ? NetDriver->GetLocalAddr() : TSharedPtr<const FInternetAddr>();
+	if (LocalAddr.IsValid() && LocalAddr->GetPort() > 0)
+	{
+		GamePort = LocalAddr->GetPort();
+	}
+
+	FMultiplayerLanSession LanSession;
+	LanSession.OwnerName = LocalPlayer ? LocalPlayer->GetNickname() : FString();
+	LanSession.MatchType = FMultiplayerSessionInfo::ReadMatchType(*m_LastSessionSettings);
+	LanSession.NumPublicConnections = m_LastSessionSettings->NumPublicConnections;
+	FMultiplayerSessionKeys::OpenSlots.Get(*m_LastSessionSettings, LanSession.OpenSlots);
+
+	GetLanDiscovery().StartBroadcasting(LanSession, FMultiplayerSessionInfo::Read(*m_LastSessionSettings).Pack(), GamePort);
+}
+
+void UMultiplayerSessionsSubsystem::OnFindSessionComplete(bool bWasSuccessful)
+{
+	if (m_SessionInterface)
+	{
+		m_SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(m_FindSessionCompleteDelegateHandle);
+	}
+
+	UpdateListenerStats();
+
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->EndOperation(EMultiplayerRecordedOp::Find, bWasSuccessful, m_LastSessionSearch.Get());
+	}
+
+	// 결과가 없는 것은 실패가 아니다. 백엔드가 응답하지 못했을때만 간격을 늘린다.
+	ScheduleNextSearch(bWasSuccessful);
+
+	// 검색 중에 결과를 놓아줬다면 (참가 완료, 메뉴 종료) 더 이상 기다리는 곳이 없다.
+	if (!m_LastSessionSearch.IsValid())
+	{
+		MultiplayerOnFindSessionComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(MultiplayerSessionsSearch);
+
+	RemoveIncompatibleResults();
+	EnforceSearchBudget();
+
+	if (m_LastSessionSearch->SearchResults.Num() <= 0)
+	{
+		// 배열이 비어있다면 빈 배열과 false를 전달
+		MultiplayerOnFindSessionComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+		return;
+	}
+
+	// 재생한 결과는 실제로 접속할 수 없는 세션이라 최근 세션 캐시에 남기지 않는다.
+	if (!m_Replay.IsValid())
+	{
+		RecordSearchResults(m_LastSessionSearch->SearchResults);
+	}
+
+	MultiplayerOnFindSessionComplete.Broadcast(m_LastSessionSearch->SearchResults, bWasSuccessful);
+}
+
+void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+{
+	if (m_SessionInterface)
+	{
+		m_SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(m_JoinSessionCompleteDelegateHandle);
+	}
+
+	UpdateListenerStats();
+
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->EndOperation(EMultiplayerRecordedOp::Join, Result);
+	}
+
+	// 다음에 검색 없이 재접속할 수 있도록 접속 주소를 저장
+	// 실패한 참가로 이전 세션의 재접속 정보를 지우지 않도록 성공했을때만 덮어쓴다.
+	if (Result == EOnJoinSessionCompleteResult::Success && m_SessionInterface)
+	{
+		m_LastJoinedResult = m_JoiningResult;
+		m_LastConnectString.Empty();
+		m_SessionInterface->GetResolvedConnectString(NAME_GameSession, m_LastConnectString);
+		m_LastJoinTime = FPlatformTime::Seconds();
+
+		// 재시작한 뒤에도 재접속할 수 있도록 디스크에 남긴다.
+		if (m_SessionCache.IsValid() && !m_LastConnectString.IsEmpty())
+		{
+			m_SessionCache->RecordJoined(m_LastJoinedResult.GetSessionIdStr(), m_LastConnectString);
+			m_SessionCache->Save();
+		}
+
+		// 참가한 세션은 m_LastJoinedResult에 남아있기 때문에 검색 결과는 더 이상 필요 없다.
+		ReleaseSearchResults();
+	}
+
+	m_JoiningResult = FOnlineSessionSearchResult();
+
+	// 재접속은 메뉴를 거치지 않고 바로 이동. 예약 비콘이 있는 로비라면 자리를 잡은 뒤 OnReservationComplete에서 이동
+	if (m_bRejoinPending)
+	{
+		if (Result == EOnJoinSessionCompleteResult::Success && !m_LastConnectString.IsEmpty())
+		{
+			if (RequestReservation())
+				return;
+
+			m_bRejoinPending = false;
+			TravelToSession(m_LastConnectString);
+			return;
+		}
+
+		m_bRejoinPending = false;
+	}
+
+	// 로비가 예약 비콘을 열어두었다면 자리를 잡은 뒤에 알려서 그때 이동하게 한다.
+	if (Result == EOnJoinSessionCompleteResult::Success && RequestReservation())
+		return;
+
+	if (m_bPartyJoinPending)
+	{
+		// 참가하지 못했다면 다음 후보로
+		if (Result != EOnJoinSessionCompleteResult::Success)
+		{
+			JoinNextPartyCandidate();
+			return;
+		}
+
+		// 예약 비콘이 없는 로비는 자리를 묶어둘 수 없어서 각자 PreLogin에서 확인받는다.
+		FinishPartyJoin(true);
+	}
+
+	MultiplayerOnJoinSessionComplete.Broadcast(Result);
+}
+
+void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if (m_SessionInterface)
+	{
+		m_SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(m_DestroySessionCompleteDelegateHandle);
+	}
+
+	UpdateListenerStats();
+
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->EndOperation(EMultiplayerRecordedOp::Destroy, bWasSuccessful);
+	}
+
+	if (m_LanDiscovery.IsValid())
+	{
+		m_LanDiscovery->StopBroadcasting();
+	}
+
+	// 참가했던 세션을 정리하지 못했다면 새 호스트가 될 수 없다. 다음 승계자에게 넘긴다.
+	if (!bWasSuccessful && m_HostMigrationState == EHostMigrationState::CreatingSession)
+	{
+		FallBackToNextHostSuccessor();
+	}
+
+	if (!bWasSuccessful)
+	{
+		FailCreateSessionOnDestroy();
+	}
+	else if (m_bCreateSessionOnDestroy)
+	{
+		// 세션을 삭제하더라도 실수로 세션을 생성하지 않는다.
+		// 미리 만드는 세션이었다면 광고하지 않은 채로 다시 만든다.
+		m_bCreateSessionOnDestroy = false;
+		CreateSessionInternal(m_LastNumPublicConnections, m_LastMatchType, m_LastShouldAdvertise);
+	}
+
+	// 미리 만든 세션을 정리했다면 기다리던 참가를 진행
+	if (m_bJoinSessionOnDestroy)
+	{
+		m_bJoinSessionOnDestroy = false;
+		JoinSession(m_PendingJoinResult);
+	}
+
+	MultiplayerOnDestroySessionComplete.Broadcast(bWasSuccessful);
+
+	// 거절당한 세션을 정리했으니 다른 후보를 시도할 수 있다.
+	if (m_PendingJoinRejection.IsSet())
+	{
+		const EMultiplayerAdmissionResult Reason = m_PendingJoinRejection.GetValue();
+		m_PendingJoinRejection.Reset();
+
+		MultiplayerOnJoinRejected.Broadcast(Reason);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if (m_SessionInterface)
+	{
+		m_SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(m_StartSessionCompleteDelegateHandle);
+	}
+
+	UpdateListenerStats();
+
+	if (m_Recorder.IsValid())
+	{
+		m_Recorder->EndOperation(EMultiplayerRecordedOp::Start, bWasSuccessful);
+	}
+
+	if (bWasSuccessful)
 	{
 		MultiplayerOnStartSessionComplete.Broadcast(bWasSuccessful);
 	}
 }
+
+void UMultiplayerSessionsSubsystem::OnUpdateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if (m_SessionInterface)
+	{
+		m_SessionInterface->ClearOnUpdateSessionCompleteDelegate_Handle(m_UpdateSessionCompleteDelegateHandle);
+	}
+
+	m_bSessionUpdateInFlight = false;
+
+	// 갱신하는 동안 인원이 또 바뀌었다면 다시 예약
+	if (m_bSessionUpdatePending)
+	{
+		UpdateSessionOccupancy(m_PendingNumPlayers, m_PendingSessionState);
+	}
+}
@@ -17,7 +17,10 @@ class MULTIPLAYERSESSIONS_API UMenu : public UUserWidget
 	
 public:
 	UFUNCTION(BlueprintCallable)
-	void MenuSetup(int32 NumberOfPublicConnections = 4, FString TypeOfMatch = FString(TEXT("FreeForAll")), FString LobbyPath = FString(TEXT("/Game/ThirdPerson/Maps/Lobby")));
+	// bSpeculativeHost를 켜면 메뉴가 떠있는 동안 세션을 미리 만들어두고 호스트 버튼을 누르면 광고만 켠다.
+	void MenuSetup(int32 NumberOfPublicConnections = 4, FString TypeOfMatch = FString(TEXT("FreeForAll")), FString LobbyPath = FString(TEXT("/Game/ThirdPerson/Maps/Lobby")), bool bSpeculativeHost = false);
+	// 메뉴를 닫고 서브시스템 바인딩을 모두 해제한다. 레벨이 내려갈때 호출되고 소크 테스트도 사이클마다 호출한다.
+	void MenuTearDown();
 
 protected:
 	virtual bool Initialize() override;
@@ -28,13 +31,15 @@ protected:
 	// DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam는 무조건 UFUNCTION으로 생성해야됨
 	UFUNCTION()
 	void OnCreateSession(bool bWasSuccessful);
-	void OnFindSession(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
 	void OnJoinSession(EOnJoinSessionCompleteResult::Type Result);
 
 	UFUNCTION()
 	void OnDestroySession(bool bWasSuccessful);
 	UFUNCTION()
 	void OnStartSession(bool bWasSuccessful);
+	// 매치메이킹이 세션을 찾지 못하고 끝나면 다시 참가 버튼을 활성화
+	UFUNCTION()
+	void OnMatchmakingComplete(bool bWasSuccessful);
 
 private:
 	// 블루프린트의 버튼이랑 c++버튼이랑 연동된다는 의미이다
@@ -51,10 +56,12 @@ private:
 	UFUNCTION()
 	void JoinButtonCliked();
 
-	void MenuTearDown();
+	// 메뉴가 사라진 뒤에도 서브시스템의 브로드캐스트를 받지 않도록 바인딩을 모두 해제
+	void UnbindSubsystemDelegates();
 
 	// 모든 온라인 세션 기능을 처리하도록 설계된 서브시스템
-	class UMultiplayerSessionsSubsystem* m_MultiplayerSessionsSubsystem;
+	// 메뉴가 서브시스템의 수명을 잡고 있지 않도록 약한 참조로 가지고 있는다.
+	TWeakObjectPtr<class UMultiplayerSessionsSubsystem> m_MultiplayerSessionsSubsystem;
 
 	int32 m_NumPublicConnections{4};
 	FString m_Matchtype{TEXT("FreeForAll")};
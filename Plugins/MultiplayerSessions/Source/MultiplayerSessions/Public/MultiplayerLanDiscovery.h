@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "MultiplayerSessionTypes.h"
+
+DECLARE_MULTICAST_DELEGATE(FMultiplayerOnLanSessionsChanged);
+
+/**
+ * 기본 LAN 비콘 대신 사용하는 UDP 비콘
+ * 호스트는 BeaconInterval마다 세션 정보를 브로드캐스트하고
+ * 리스너는 받은 비콘으로 세션 목록을 계속 갱신하기 때문에 검색 타임아웃을 기다릴 필요가 없다.
+ * 설정은 DefaultGame.ini의 [MultiplayerSessions.LanDiscovery]에서 읽는다.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerLanDiscovery
+{
+public:
+	FMultiplayerLanDiscovery();
+	~FMultiplayerLanDiscovery();
+
+	// 호스트: 세션 정보를 주기적으로 브로드캐스트. GamePort는 listen 서버가 실제로 열어둔 포트
+	bool StartBroadcasting(const FMultiplayerLanSession& Session, int32 SessionInfo, int32 GamePort);
+	// 인원이 바뀌었을때 다음 비콘부터 반영
+	void UpdateBroadcast(int32 OpenSlots, int32 SessionInfo);
+	void StopBroadcasting();
+	bool IsBroadcasting() const { return m_BroadcastSocket != nullptr; }
+
+	// 검색하는 쪽: 비콘을 받아서 세션 목록을 유지
+	bool StartListening();
+	void StopListening();
+	bool IsListening() const { return m_ListenSocket != nullptr; }
+
+	const TMap<FString, FMultiplayerLanSession>& GetSessions() const { return m_Sessions; }
+
+	void SetBeaconInterval(float BeaconInterval) { m_BeaconInterval = FMath::Max(BeaconInterval, 0.01f); }
+	float GetBeaconInterval() const { return m_BeaconInterval; }
+
+	// 세션이 추가, 갱신, 만료될때 호출
+	FMultiplayerOnLanSessionsChanged OnLanSessionsChanged;
+
+private:
+	bool Tick(float DeltaTime);
+	void UpdateTicker();
+
+	void BuildBeaconPacket();
+	void SendBeacon();
+	bool ReceiveBeacons(double Now);
+	bool ExpireSessions(double Now);
+
+	class FSocket* m_BroadcastSocket{ nullptr };
+	class FSocket* m_ListenSocket{ nullptr };
+	TSharedPtr<class FInternetAddr> m_BroadcastAddr;
+	TSharedPtr<class FInternetAddr> m_LoopbackAddr;
+
+	FTSTicker::FDelegateHandle m_TickerHandle;
+
+	// 자기 자신이 보낸 비콘은 무시하기 위한 값
+	uint32 m_InstanceId{ 0 };
+
+	int32 m_Port{ 14001 };
+	float m_BeaconInterval{ 0.25f };
+	float m_SessionTimeout{ 1.5f };
+	bool m_bBroadcastToLoopback{ true };
+	double m_LastBeaconTime{ 0.0 };
+
+	// 비콘으로 보낼 내용. 매번 만들지 않도록 바뀔때만 다시 직렬화
+	FMultiplayerLanSession m_BroadcastSession;
+	int32 m_BroadcastSessionInfo{ 0 };
+	int32 m_BroadcastGamePort{ 0 };
+	TArray<uint8> m_BeaconPacket;
+
+	TArray<uint8> m_ReceiveBuffer;
+	TMap<FString, FMultiplayerLanSession> m_Sessions;
+};
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "Engine/EngineTypes.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "MultiplayerSessionTypes.h"
+#include "MultiplayerSearchResultProcessor.h"
+#include "MultiplayerMatchmaker.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnMatchmakingComplete, bool, bWasSuccessful);
+
+/**
+ * 검색 결과를 지역, 매치 타입, 실력 구간으로 나눠서 가장 좋은 세션을 고른다.
+ * 시간 예산 안에서 좋은 매치를 기다리다가 시간이 지날수록 조건을 넓힌다.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UMultiplayerMatchmaker : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(class UMultiplayerSessionsSubsystem* Subsystem);
+	virtual void BeginDestroy() override;
+
+	void StartMatchmaking(const FMultiplayerMatchmakingParams& Params);
+	void CancelMatchmaking();
+
+	bool IsMatchmaking() const { return m_bMatchmaking; }
+
+	// 요청 조건과 경과 시간으로 검색 결과를 거르고 점수를 매기는 함수를 만든다. 벤치마크도 같은 함수를 사용
+	static FMultiplayerSearchResultProcessor::FFilterAndScore MakeFilterAndScore(const FMultiplayerMatchmakingParams& Params, double Elapsed, int32& OutSkillTolerance);
+
+	// 가상의 플레이어를 가상의 세션 목록에 매칭해서 매치까지 걸린 시간과 매치 품질 분포를 로그로 남긴다.
+	static void RunBenchmark(int32 NumPlayers, int32 NumSessions, int32 Seed);
+
+	// 고른 세션(또는 다음 후보)의 참가가 끝났거나, 시간 예산을 넘기거나 후보가 모두 실패했을때 호출
+	// 참가한 뒤에 로비가 PreLogin에서 입장을 거절하고 남은 후보도 없다면 성공 뒤에 한번 더 실패로 호출된다.
+	FMultiplayerOnMatchmakingComplete MultiplayerOnMatchmakingComplete;
+
+private:
+	void OnFindSessionComplete(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
+	// 워커 스레드에서 점수를 매긴 결과를 게임 스레드에서 받는다.
+	void OnSearchResultsProcessed(TSharedRef<const FOnlineSessionSearch> Search, TArray<struct FMultiplayerDecodedResult>&& SortedResults, uint32 SearchSerial, int32 SkillTolerance);
+	void RunSearch();
+	// 검색과 타이머만 멈춘다. 참가를 기다리는 후보는 그대로 둔다.
+	void StopSearch();
+	void FinishMatchmaking(bool bWasSuccessful);
+	// 검색 응답이 오지 않아도 시간 예산이 지나면 끝낸다.
+	void OnTimeBudgetExpired();
+
+	// 참가에 실패하거나 로비가 입장을 거절하면 다시 검색하지 않고 다음 후보에 바로 참가
+	void OnJoinSessionComplete(EOnJoinSessionCompleteResult::Type Result);
+	void OnJoinRejected(EMultiplayerAdmissionResult Reason);
+	// 남은 후보가 없다면 실패로 끝낸다.
+	void JoinNextCandidate();
+	// 맵을 불러왔다면 입장에 성공한 것이라 남은 후보는 필요 없다.
+	void OnPostLoadMap(UWorld* World);
+
+	// 실력 구간 크기. 버킷 키를 만들때 사용
+	static constexpr int32 SkillBucketSize{ 100 };
+
+	static uint32 MakeBucketKey(EMultiplayerRegion Region, EMultiplayerMatchType MatchType, int32 SkillBucket);
+
+	// 경과 시간 기준으로 허용 실력 차이
+	static int32 GetSkillTolerance(const FMultiplayerMatchmakingParams& Params, double Elapsed);
+
+	// 0 ~ 1 사이의 매치 품질. 1에 가까울수록 좋은 매치
+	// 워커 스레드에서 호출되기 때문에 멤버를 사용하지 않는다.
+	static float ScoreCandidate(int32 SkillDelta, int32 PingInMs, int32 SkillTolerance);
+
+	TWeakObjectPtr<class UMultiplayerSessionsSubsystem> m_Subsystem;
+	FDelegateHandle m_FindSessionCompleteDelegateHandle;
+	FTimerHandle m_SearchTimerHandle;
+	FTimerHandle m_TimeBudgetTimerHandle;
+
+	FMultiplayerMatchmakingParams m_Params;
+	double m_StartTime{ 0.0 };
+	bool m_bMatchmaking{ false };
+	// 처리 중에 취소되거나 다시 시작한 매치메이킹의 결과를 버리기 위한 번호
+	uint32 m_SearchSerial{ 0 };
+
+	// 고른 세션 다음으로 점수가 높은 후보. 앞에서부터 시도한다.
+	static constexpr int32 MaxFallbackCandidates{ 3 };
+	TArray<FOnlineSessionSearchResult> m_FallbackResults;
+	// 매치메이커가 요청한 JoinSession의 결과를 기다리는 중. 다른 곳에서 요청한 참가의 결과는 무시한다.
+	bool m_bAwaitingJoin{ false };
+	// 매치메이커가 고른 세션의 입장 결과를 기다리는 중. 맵을 불러오면 끝난다.
+	bool m_bAwaitingAdmission{ false };
+	FDelegateHandle m_JoinSessionCompleteDelegateHandle;
+	FDelegateHandle m_JoinRejectedDelegateHandle;
+	FDelegateHandle m_PostLoadMapDelegateHandle;
+};
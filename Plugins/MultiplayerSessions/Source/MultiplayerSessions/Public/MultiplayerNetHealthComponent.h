@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "MultiplayerNetHealthComponent.generated.h"
+
+// 연결 하나에서 한번 샘플링한 값
+struct FMultiplayerNetHealthSample
+{
+	float RttMs{ 0.f };
+	// 0..1
+	float InLoss{ 0.f };
+	float OutLoss{ 0.f };
+	// 보낸 양 / 연결 속도. 1에 가까우면 대역폭이 꽉 찬 것
+	float Saturation{ 0.f };
+	// 샘플링할때 더 보낼 수 없는 상태였는지
+	bool bSaturated{ false };
+};
+
+/**
+ * 서버에서 클라이언트 연결마다 RTT, 패킷 손실, 대역폭 포화를 주기적으로 샘플링
+ * 연결마다 최근 샘플을 링 버퍼에 모아두고 ExportInterval마다 지난 내보내기 이후의 샘플만 백분위수로 요약해서 CSV에 추가한다.
+ * 파일 쓰기는 백그라운드 스레드에서 한다.
+ * 서버 전체 값은 트레이스 카운터로도 내보내서 Insights에서 틱 시간과 같이 볼 수 있다.
+ * 로비 성능을 떨어뜨리는 플레이어를 찾기 위함. 지역은 주소로 따로 확인
+ */
+UCLASS(ClassGroup = (MultiplayerSessions), meta = (BlueprintSpawnableComponent))
+class MULTIPLAYERSESSIONS_API UMultiplayerNetHealthComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UMultiplayerNetHealthComponent();
+
+	// 지금까지 모은 샘플을 바로 요약해서 내보낸다.
+	UFUNCTION(BlueprintCallable)
+	void Export();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NetHealth")
+	float SampleInterval{ 1.f };
+
+	// 연결마다 보관하는 최근 샘플 수. 이보다 오래된 샘플은 덮어쓴다.
+	// ExportInterval 동안의 샘플보다 작으면 그만큼 늘려서 쓴다.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NetHealth")
+	int32 RingBufferSize{ 120 };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NetHealth")
+	float ExportInterval{ 60.f };
+
+	// 비어있으면 Saved/Profiling/NetHealth.csv
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NetHealth")
+	FString CsvFilePath;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void Sample();
+
+	struct FConnectionHealth
+	{
+		FString PlayerId;
+		FString Address;
+		TArray<FMultiplayerNetHealthSample> Samples;
+		// 다음에 쓸 위치. 버퍼가 차면 가장 오래된 샘플을 덮어쓴다.
+		int32 Head{ 0 };
+		// 마지막으로 내보낸 뒤에 추가된 샘플 수. 가장 최근 샘플부터 이만큼이 다음 요약에 들어간다.
+		int32 NumNewSamples{ 0 };
+		// 마지막 샘플링에서 연결이 남아있었는지. 끊긴 연결은 한번 더 내보내고 지운다.
+		bool bConnected{ true };
+
+		void Add(const FMultiplayerNetHealthSample& InSample, int32 Capacity);
+	};
+
+	static float Percentile(TArray<float>& Values, float Percent);
+	FString GetCsvFilePath() const;
+
+	TMap<TWeakObjectPtr<class UNetConnection>, FConnectionHealth> m_Connections;
+	FTimerHandle m_SampleTimerHandle;
+	FTimerHandle m_ExportTimerHandle;
+	int32 m_Capacity{ 1 };
+};
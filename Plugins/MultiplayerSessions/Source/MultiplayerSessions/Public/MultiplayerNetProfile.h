@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UNetDriver;
+class UPlayer;
+
+// 넷 드라이버 튜닝 프리셋
+// DefaultGame.ini의 [MultiplayerSessions.NetProfile.<이름>] 섹션에서 읽고 실행 중에 넷 드라이버에 적용한다.
+// 섹션에 없는 값은 엔진 설정을 그대로 사용
+struct MULTIPLAYERSESSIONS_API FMultiplayerNetProfile
+{
+	FString Name;
+
+	// 서버 틱레이트 (리슨 서버 포함)
+	TOptional<int32> NetServerMaxTickRate;
+	// 클라이언트 쪽 넷 틱 상한
+	TOptional<int32> MaxNetTickRate;
+	// 연결 하나에 허용하는 초당 바이트
+	TOptional<int32> MaxClientRate;
+	TOptional<int32> MaxInternetClientRate;
+	// 로컬 플레이어가 서버에 요청하는 속도
+	TOptional<int32> ConfiguredInternetSpeed;
+	TOptional<int32> ConfiguredLanSpeed;
+
+	// 섹션이 없으면 false
+	static bool Load(const FString& ProfileName, FMultiplayerNetProfile& OutProfile);
+	// [MultiplayerSessions.NetProfiles] ActiveProfile
+	static FString GetConfiguredProfileName();
+
+	void Apply(UNetDriver& NetDriver) const;
+	void Apply(UPlayer& Player) const;
+
+	// 프로필을 비교할때 볼 수 있도록 넷 드라이버의 현재 트래픽을 로그로 남긴다.
+	static void LogNetDriverStats(const UNetDriver& NetDriver);
+};
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "HAL/PlatformProcess.h"
+#include "MultiplayerNetProfile.h"
+#include "MultiplayerNetSweep.generated.h"
+
+/**
+ * 넷 프로필 값을 정하기 위한 측정
+ * 리슨 서버에서 같은 머신에 클라이언트 프로세스를 띄워 127.0.0.1로 접속시키고
+ * 서버 틱레이트, 연결당 바이트 상한, 클라이언트 이동 RPC 간격(코얼레싱)을 바꿔가며
+ * 연결당 CPU, 초당 패킷, 지연 시간을 CSV로 남긴다.
+ * 서버도 -nullrhi로 띄워야 렌더링이 CPU 값에 섞이지 않는다. 다른 플레이어가 접속해 있으면 안된다.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UMultiplayerNetSweep : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// 리슨 서버가 아니거나 이미 돌고 있다면 false
+	bool Start(class UMultiplayerSessionsSubsystem* Subsystem, int32 NumClients, float SecondsPerStep);
+	void Stop();
+	bool IsRunning() const { return m_bRunning; }
+
+private:
+	struct FSweepStep
+	{
+		int32 TickRate{ 0 };
+		int32 ClientRate{ 0 };
+		// 클라이언트 이동 RPC 최소 간격. 이 사이의 이동은 하나로 합쳐서 보낸다.
+		float ClientSendMoveDeltaTime{ 0.f };
+	};
+
+	struct FSweepResult
+	{
+		FSweepStep Step;
+		double CpuPercentPerConnection{ 0.0 };
+		double InPackets{ 0.0 };
+		double OutPackets{ 0.0 };
+		double LagMs{ 0.0 };
+	};
+
+	void BeginStep();
+	void LaunchClients(float ClientSendMoveDeltaTime);
+	void KillClients();
+	void WaitForClients();
+	void BeginSampling();
+	void Sample();
+	void EndStep();
+	void Finish();
+	// 지연 시간이 가장 낮은 값에 가까운 단계 중에서 연결당 CPU가 가장 낮은 단계를 프로필 섹션으로 남긴다.
+	void WriteBestProfile() const;
+
+	class UNetDriver* GetNetDriver() const;
+	class FTimerManager* GetTimerManager() const;
+
+	TWeakObjectPtr<class UMultiplayerSessionsSubsystem> m_Subsystem;
+	bool m_bRunning{ false };
+	int32 m_NumClients{ 0 };
+	float m_SecondsPerStep{ 0.f };
+
+	TArray<FSweepStep> m_Steps;
+	int32 m_StepIndex{ 0 };
+	FTimerHandle m_StepTimerHandle;
+	FString m_CsvFilePath;
+	TArray<FSweepResult> m_Results;
+
+	// 끝나면 되돌릴 원래 넷 드라이버 값
+	FMultiplayerNetProfile m_OriginalProfile;
+
+	TArray<FProcHandle> m_ClientProcesses;
+	// 클라이언트 값은 실행할때 정해지기 때문에 값이 바뀔때만 다시 띄운다.
+	float m_LaunchedSendMoveDeltaTime{ -1.f };
+	double m_LaunchTime{ 0.0 };
+
+	// 1초마다 쌓는 값. 넷 드라이버의 패킷, 바이트 값이 1초마다 갱신된다.
+	int32 m_NumSamples{ 0 };
+	double m_TotalCpuPercent{ 0.0 };
+	double m_TotalConnections{ 0.0 };
+	double m_TotalInPackets{ 0.0 };
+	double m_TotalOutPackets{ 0.0 };
+	double m_TotalInBytes{ 0.0 };
+	double m_TotalOutBytes{ 0.0 };
+	double m_TotalLagMs{ 0.0 };
+
+	// 설정을 바꾼 직후에는 값이 안정되지 않아서 버린다.
+	static constexpr float WarmupSeconds{ 3.f };
+	// 클라이언트가 이 시간 안에 모두 접속하지 않으면 중단
+	static constexpr float ClientConnectTimeout{ 60.f };
+	// 가장 낮은 지연 시간에서 이만큼까지는 같은 수준으로 본다.
+	static constexpr double LagToleranceMs{ 5.0 };
+};
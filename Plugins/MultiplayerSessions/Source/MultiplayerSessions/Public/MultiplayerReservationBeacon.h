@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineBeaconClient.h"
+#include "OnlineBeaconHostObject.h"
+#include "MultiplayerSessionTypes.h"
+#include "MultiplayerReservationBeacon.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnReservationComplete, EMultiplayerAdmissionResult Result);
+// 서버에서 예약 요청을 받았을때 로비가 판단해서 결과를 돌려준다. 받아들였다면 자리를 잡아두는 것까지 로비가 처리
+DECLARE_DELEGATE_RetVal_TwoParams(EMultiplayerAdmissionResult, FMultiplayerOnReservationRequest, const TArray<FString>& PlayerIds, int32 BuildUniqueId);
+
+/**
+ * 자리 예약용 비콘 클라이언트
+ * JoinSession이 끝나고 맵을 불러오기 전에 작은 비콘 연결로 자리를 먼저 잡는다.
+ * 예약이 확인되어야 ClientTravel 하기 때문에 그 사이에 다른 플레이어가 마지막 자리를 가져가도 맵 로딩을 낭비하지 않는다.
+ */
+UCLASS(Transient, notplaceable)
+class MULTIPLAYERSESSIONS_API AMultiplayerReservationBeaconClient : public AOnlineBeaconClient
+{
+	GENERATED_BODY()
+
+public:
+	// 비콘 주소로 연결해서 PlayerIds 전부의 자리를 한번에 예약. Timeout 안에 응답이 없으면 ReservationFailed
+	bool RequestReservation(const FString& ConnectAddress, const TArray<FString>& PlayerIds, float Timeout);
+
+	// 결과는 한번만 알린다. 이후에는 비콘을 정리해도 된다.
+	FMultiplayerOnReservationComplete OnReservationComplete;
+
+	virtual void OnConnected() override;
+	virtual void OnFailure() override;
+
+	UFUNCTION(Server, Reliable)
+	void ServerRequestReservation(const TArray<FString>& PlayerIds, int32 BuildUniqueId);
+
+	UFUNCTION(Client, Reliable)
+	void ClientReservationResponse(EMultiplayerAdmissionResult Result);
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void OnReservationTimeout();
+	void CompleteReservation(EMultiplayerAdmissionResult Result);
+
+	TArray<FString> m_PlayerIds;
+	FTimerHandle m_TimeoutTimerHandle;
+	bool m_bCompleted{ false };
+
+	// 서버에서 이 연결이 마지막으로 요청한 시간. 정상 클라이언트는 연결당 한번만 요청한다.
+	double m_LastServerRequestTime{ -1.0 };
+
+	// 파티 전체를 한번에 예약하더라도 이보다 큰 목록은 받지 않는다.
+	static constexpr int32 MaxReservationPlayers{ 16 };
+	// 같은 연결에서 이 간격 안에 다시 들어온 요청은 거절
+	static constexpr double MinServerRequestInterval{ 1.0 };
+};
+
+/**
+ * 로비 서버에서 예약 요청을 받는 비콘 호스트 객체
+ * 인원과 예약 목록은 로비가 들고 있기 때문에 판단은 OnReservationRequest에 맡긴다.
+ */
+UCLASS(Transient, notplaceable)
+class MULTIPLAYERSESSIONS_API AMultiplayerReservationBeaconHostObject : public AOnlineBeaconHostObject
+{
+	GENERATED_BODY()
+
+public:
+	AMultiplayerReservationBeaconHostObject();
+
+	EMultiplayerAdmissionResult ProcessReservationRequest(const TArray<FString>& PlayerIds, int32 BuildUniqueId);
+
+	FMultiplayerOnReservationRequest OnReservationRequest;
+};
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MultiplayerSessionTypes.h"
+
+class FOnlineSessionSearch;
+struct FRandomStream;
+
+// 검색 결과 하나를 디코딩한 값
+// 원본 검색 결과는 ResultIndex로 찾는다.
+struct FMultiplayerDecodedResult
+{
+	int32 ResultIndex{ INDEX_NONE };
+	FMultiplayerSessionInfo SessionInfo;
+	int32 OpenSlots{ 0 };
+	int32 Skill{ 0 };
+	int32 PingInMs{ 0 };
+	// 높을수록 앞으로 정렬된다.
+	float Score{ 0.f };
+};
+
+/**
+ * 검색 결과 디코딩, 필터, 점수 계산을 워커 스레드에서 나눠서 처리
+ * 결과가 수천개일때 게임 스레드에서 한번에 처리하면 프레임이 튀기 때문에
+ * 결과를 청크로 나눠서 병렬로 처리한 뒤 정렬된 목록만 게임 스레드로 넘겨준다.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSearchResultProcessor
+{
+public:
+	// 워커 스레드에서 호출된다. 디코딩된 값을 보고 false를 반환하면 결과에서 빠지고, 남길 결과는 Score를 채운다.
+	// 게임 스레드의 객체를 건드리면 안되기 때문에 필요한 값은 복사해서 캡처할 것
+	using FFilterAndScore = TFunction<bool(const FOnlineSessionSearchResult& SearchResult, FMultiplayerDecodedResult& Decoded)>;
+	// 게임 스레드에서 호출된다.
+	using FOnProcessed = TFunction<void(TSharedRef<const FOnlineSessionSearch> Search, TArray<FMultiplayerDecodedResult>&& SortedResults)>;
+
+	// 결과가 적으면 작업을 나누는 비용이 더 크기 때문에 바로 처리하고 콜백도 바로 호출된다.
+	static void ProcessAsync(TSharedRef<const FOnlineSessionSearch> Search, FFilterAndScore FilterAndScore, FOnProcessed OnProcessed);
+
+	// 호출한 스레드에서 병렬로 처리하고 정렬된 결과를 반환
+	// bSingleThreaded는 벤치마크에서 나누기 전과 비교하기 위한 값
+	static TArray<FMultiplayerDecodedResult> Process(const TArray<FOnlineSessionSearchResult>& SearchResults, const FFilterAndScore& FilterAndScore, bool bSingleThreaded = false);
+
+	// 벤치마크용 가상 세션 목록. 실제 광고와 같은 키로 매치 타입, 지역, 남은 자리, 실력, 핑을 채운다.
+	static TArray<FOnlineSessionSearchResult> MakeBenchmarkResults(int32 NumResults, FRandomStream& Random);
+	// 평균 1000 근처에 몰린 실력 값
+	static int32 MakeBenchmarkSkill(FRandomStream& Random);
+
+	// 결과 수별로 게임 스레드에서 한번에 처리할때와 워커 스레드로 넘길때의 게임 스레드 시간을 비교해서 로그로 남긴다.
+	// 비동기 콜백은 다음 틱에 오기 때문에 결과는 몇 프레임 뒤에 나온다.
+	static void RunBenchmark(int32 Iterations);
+
+private:
+	static void Decode(const FOnlineSessionSearchResult& SearchResult, int32 ResultIndex, FMultiplayerDecodedResult& OutDecoded);
+
+	// 청크 하나에 들어가는 결과 수
+	static constexpr int32 ChunkSize{ 256 };
+	// 이보다 결과가 적으면 게임 스레드에서 바로 처리
+	static constexpr int32 AsyncThreshold{ 512 };
+};
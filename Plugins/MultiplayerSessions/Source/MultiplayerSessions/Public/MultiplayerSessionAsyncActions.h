@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "MultiplayerSessionTypes.h"
+#include "MultiplayerSessionAsyncActions.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FMultiplayerCreateSessionAsyncPin);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerFindSessionsAsyncPin, const TArray<FMultiplayerSessionResult>&, Results);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerJoinSessionAsyncPin, const FString&, ConnectAddress);
+
+/**
+ * 세션 생성을 기다리는 비동기 노드
+ * 이미 생성 중인 요청이 있다면 새로 요청하지 않고 그 결과를 같이 받는다.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UCreateMultiplayerSessionAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "MultiplayerSessions")
+	static UCreateMultiplayerSessionAsyncAction* CreateMultiplayerSession(UObject* WorldContextObject, int32 NumPublicConnections = 4, FString MatchType = FString(TEXT("FreeForAll")));
+
+	virtual void Activate() override;
+
+	// 결과를 더 이상 받지 않는다. 진행중인 백엔드 요청은 다른 대기자를 위해 그대로 둔다.
+	UFUNCTION(BlueprintCallable, Category = "MultiplayerSessions")
+	void Cancel();
+
+	UPROPERTY(BlueprintAssignable)
+	FMultiplayerCreateSessionAsyncPin OnSuccess;
+
+	UPROPERTY(BlueprintAssignable)
+	FMultiplayerCreateSessionAsyncPin OnFailure;
+
+private:
+	UFUNCTION()
+	void OnCreateSessionComplete(bool bWasSuccessful);
+
+	TWeakObjectPtr<class UMultiplayerSessionsSubsystem> m_Subsystem;
+	int32 m_NumPublicConnections{ 4 };
+	FString m_MatchType;
+};
+
+/**
+ * 세션 검색을 기다리는 비동기 노드
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UFindMultiplayerSessionsAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "MultiplayerSessions")
+	static UFindMultiplayerSessionsAsyncAction* FindMultiplayerSessions(UObject* WorldContextObject, int32 MaxSearchResults = 10000);
+
+	virtual void Activate() override;
+
+	// 결과를 더 이상 받지 않는다. 이 노드가 시작한 검색을 다른 곳에서 기다리지 않는다면 백엔드 검색도 취소
+	UFUNCTION(BlueprintCallable, Category = "MultiplayerSessions")
+	void Cancel();
+
+	UPROPERTY(BlueprintAssignable)
+	FMultiplayerFindSessionsAsyncPin OnSuccess;
+
+	UPROPERTY(BlueprintAssignable)
+	FMultiplayerFindSessionsAsyncPin OnFailure;
+
+private:
+	void OnFindSessionComplete(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
+
+	TWeakObjectPtr<class UMultiplayerSessionsSubsystem> m_Subsystem;
+	FDelegateHandle m_FindSessionCompleteDelegateHandle;
+	int32 m_MaxSearchResults{ 10000 };
+	bool m_bStartedSearch{ false };
+};
+
+/**
+ * 세션 참가를 기다리는 비동기 노드
+ * bTravelOnSuccess가 true라면 참가에 성공한 뒤 바로 접속까지 한다.
+ * 다른 세션에 참가하는 중이라면 그 결과를 받지 않고 바로 실패한다.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UJoinMultiplayerSessionAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "MultiplayerSessions")
+	static UJoinMultiplayerSessionAsyncAction* JoinMultiplayerSession(UObject* WorldContextObject, const FMultiplayerSessionResult& SessionResult, bool bTravelOnSuccess = true);
+
+	virtual void Activate() override;
+
+	UFUNCTION(BlueprintCallable, Category = "MultiplayerSessions")
+	void Cancel();
+
+	UPROPERTY(BlueprintAssignable)
+	FMultiplayerJoinSessionAsyncPin OnSuccess;
+
+	UPROPERTY(BlueprintAssignable)
+	FMultiplayerJoinSessionAsyncPin OnFailure;
+
+private:
+	void OnJoinSessionComplete(EOnJoinSessionCompleteResult::Type Result);
+
+	TWeakObjectPtr<class UMultiplayerSessionsSubsystem> m_Subsystem;
+	FDelegateHandle m_JoinSessionCompleteDelegateHandle;
+	FMultiplayerSessionResult m_SessionResult;
+	bool m_bTravelOnSuccess{ true };
+};
@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "MultiplayerSessionTypes.h"
+#include "MultiplayerSessionBrowser.generated.h"
+
+UENUM(BlueprintType)
+enum class EMultiplayerSessionSortMode : uint8
+{
+	Ping,
+	OpenSlots,
+	OwnerName,
+	MatchType
+};
+
+// 세션 목록에 적용할 필터. 비어있는 조건은 적용하지 않는다.
+USTRUCT(BlueprintType)
+struct FMultiplayerSessionBrowserFilter
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString MatchType;
+
+	// 호스트 이름에 이 문자열이 들어간 세션만
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString OwnerNameContains;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bHideFull{ true };
+
+	// 0이면 제한 없음
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxPingInMs{ 0 };
+};
+
+/**
+ * 리스트 뷰에 들어가는 세션 하나
+ * 검색 결과를 통째로 복사하지 않고 화면에 필요한 값과 원본 인덱스만 가지고 있는다.
+ */
+UCLASS(BlueprintType)
+class MULTIPLAYERSESSIONS_API UMultiplayerSessionListItem : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly)
+	FString OwnerName;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString MatchType;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 OpenSlots{ 0 };
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 PingInMs{ 0 };
+
+	// 첫 검색이 끝나기 전에 디스크 캐시에서 가져온 세션
+	UPROPERTY(BlueprintReadOnly)
+	bool bFromCache{ false };
+
+	// LAN 비콘으로 발견한 세션
+	UPROPERTY(BlueprintReadOnly)
+	bool bFromLan{ false };
+
+	// 브라우저가 들고 있는 검색 결과에서의 인덱스. 캐시, LAN 세션은 INDEX_NONE
+	int32 ResultIndex{ INDEX_NONE };
+	// 캐시, LAN 세션은 검색 결과가 없기 때문에 접속 주소로 바로 이동
+	FString ConnectAddress;
+};
+
+/**
+ * 검색 결과를 리스트 뷰로 보여주는 세션 브라우저
+ * 리스트 뷰는 화면에 보이는 줄만 엔트리 위젯을 만들기 때문에 결과가 만개여도 위젯 수는 그대로다.
+ * 정렬과 필터는 아이템 배열만 다시 만들고, 새로고침도 아이템 객체를 재사용한다.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UMultiplayerSessionBrowser : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable)
+	void Refresh();
+
+	UFUNCTION(BlueprintCallable)
+	void SetSortMode(EMultiplayerSessionSortMode SortMode, bool bDescending = false);
+
+	UFUNCTION(BlueprintCallable)
+	void SetFilter(const FMultiplayerSessionBrowserFilter& Filter);
+
+	UFUNCTION(BlueprintCallable)
+	void JoinSelected();
+
+	UFUNCTION(BlueprintPure)
+	int32 GetNumVisibleSessions() const { return m_VisibleItems.Num(); }
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxSearchResults{ 10000 };
+
+protected:
+	virtual void NativeConstruct() override;
+	virtual void NativeDestruct() override;
+
+private:
+	UPROPERTY(meta = (BindWidget))
+	class UListView* SessionList;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UButton* RefreshButton;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UButton* JoinButton;
+
+	UFUNCTION()
+	void RefreshButtonClicked();
+
+	UFUNCTION()
+	void JoinButtonClicked();
+
+	void OnItemDoubleClicked(UObject* Item);
+	void JoinItem(const UMultiplayerSessionListItem* Item);
+
+	void OnFindSessionComplete(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
+	void OnJoinSessionComplete(EOnJoinSessionCompleteResult::Type Result);
+	void OnJoinRejected(EMultiplayerAdmissionResult Reason);
+	void OnLanSessionsUpdated();
+
+	// 디코딩된 결과로 아이템 객체를 채운다. 이미 만든 객체는 재사용
+	void UpdateItems(TSharedRef<const FOnlineSessionSearch> Search, TArray<struct FMultiplayerDecodedResult>&& Results);
+	void PopulateFromCache();
+	void PopulateFromLan();
+	void ReleaseItems();
+	UMultiplayerSessionListItem* GetPooledItem(int32 Index);
+
+	// 필터와 정렬을 다시 적용해서 리스트 뷰에 넘긴다. 엔트리 위젯은 다시 만들지 않는다.
+	void ApplyView();
+	bool PassesFilter(const UMultiplayerSessionListItem& Item) const;
+	bool SortPredicate(const UMultiplayerSessionListItem& A, const UMultiplayerSessionListItem& B) const;
+
+	TWeakObjectPtr<class UMultiplayerSessionsSubsystem> m_MultiplayerSessionsSubsystem;
+	FDelegateHandle m_FindSessionCompleteDelegateHandle;
+	FDelegateHandle m_JoinSessionCompleteDelegateHandle;
+	FDelegateHandle m_JoinRejectedDelegateHandle;
+	FDelegateHandle m_LanSessionsUpdatedDelegateHandle;
+
+	// LAN에서는 검색 결과 대신 비콘 리스너의 세션 목록을 보여준다.
+	bool m_bLanDiscovery{ false };
+
+	// 아이템이 가리키는 검색 결과
+	TSharedPtr<const FOnlineSessionSearch> m_Search;
+	uint32 m_RefreshSerial{ 0 };
+	bool m_bJoinRequested{ false };
+
+	// 만들어둔 아이템 객체. 새로고침할때 앞에서부터 재사용한다.
+	UPROPERTY()
+	TArray<UMultiplayerSessionListItem*> m_ItemPool;
+	int32 m_NumItems{ 0 };
+
+	// 필터와 정렬이 적용된 목록. 리스트 뷰가 이 배열을 본다.
+	UPROPERTY()
+	TArray<UMultiplayerSessionListItem*> m_VisibleItems;
+
+	FMultiplayerSessionBrowserFilter m_Filter;
+	EMultiplayerSessionSortMode m_SortMode{ EMultiplayerSessionSortMode::Ping };
+	bool m_bSortDescending{ false };
+};
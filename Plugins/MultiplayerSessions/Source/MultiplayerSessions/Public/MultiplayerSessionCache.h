@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MultiplayerSessionTypes.h"
+
+// 디스크에 저장되는 레코드 하나
+// 파일을 매핑해서 그대로 읽을 수 있도록 고정 크기, 포인터 없는 구조로 유지한다.
+struct FMultiplayerSessionCacheRecord
+{
+	static constexpr int32 SessionIdSize = 64;
+	static constexpr int32 ConnectAddressSize = 96;
+	static constexpr int32 OwnerNameSize = 64;
+
+	// 문자열은 UTF-8, 널 문자로 끝난다.
+	UTF8CHAR SessionId[SessionIdSize];
+	UTF8CHAR ConnectAddress[ConnectAddressSize];
+	UTF8CHAR OwnerName[OwnerNameSize];
+	// FDateTime 틱 (UTC)
+	int64 LastSeenTicks;
+	int64 LastJoinedTicks;
+	int32 PingInMs;
+	int32 SessionInfo;
+	int32 OpenSlots;
+	uint32 Flags;
+};
+
+static_assert(sizeof(FMultiplayerSessionCacheRecord) == 256, "Session cache record layout changed, bump FMultiplayerSessionCache::Version");
+
+/**
+ * 최근에 보거나 참가한 세션을 디스크에 저장
+ * 시작하자마자 첫 검색이 끝나기 전에도 브라우저와 재접속 경로가 후보를 가질 수 있다.
+ * 파일 형식: 헤더(Magic, Version, RecordSize, RecordCount) + 고정 크기 레코드 배열
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionCache
+{
+public:
+	static constexpr uint32 Magic = 0x4D505343;	// "MPSC"
+	static constexpr uint32 Version = 1;
+
+	enum ERecordFlags : uint32
+	{
+		Joined = 1 << 0,
+		// 백그라운드 재검증에서 아직 살아있는 것을 확인한 세션
+		Validated = 1 << 1
+	};
+
+	explicit FMultiplayerSessionCache(int32 InMaxRecords = 64);
+
+	// 파일을 매핑해서 읽는다. 매핑을 지원하지 않는 플랫폼은 통째로 읽어서 처리
+	bool Load(const FString& InFilePath);
+	bool Save() const;
+
+	void RecordSeen(const FString& SessionId, const FString& ConnectAddress, const FString& OwnerName, int32 PingInMs, int32 SessionInfo, int32 OpenSlots);
+	void RecordJoined(const FString& SessionId, const FString& ConnectAddress);
+	void MarkValidated(const FString& SessionId, int32 PingInMs, int32 OpenSlots);
+	void Remove(const FString& SessionId);
+
+	// 가장 최근에 참가한 세션. 없다면 nullptr
+	const FMultiplayerSessionCacheRecord* FindLastJoined() const;
+
+	const TArray<FMultiplayerSessionCacheRecord>& GetRecords() const { return m_Records; }
+	int32 GetMaxRecords() const { return m_MaxRecords; }
+	TArray<FMultiplayerRecentSession> GetRecentSessions() const;
+
+	static FString GetSessionId(const FMultiplayerSessionCacheRecord& Record);
+	static FString GetConnectAddress(const FMultiplayerSessionCacheRecord& Record);
+
+private:
+	// 자리가 없으면 참가하지 않은 세션을 밀어낸다. 밀어낼 수 없다면 nullptr
+	FMultiplayerSessionCacheRecord* FindOrAddRecord(const FString& SessionId, bool bJoining);
+	static void WriteString(UTF8CHAR* Dest, int32 DestSize, const FString& Source);
+	static FString ReadString(const UTF8CHAR* Source, int32 SourceSize);
+
+	bool ReadRecords(const uint8* Data, int64 DataSize);
+
+	int32 m_MaxRecords;
+	// 이보다 오래된 레코드는 불러올때 버린다.
+	FTimespan m_MaxRecordAge{ FTimespan::FromDays(7.0) };
+	FString m_FilePath;
+	TArray<FMultiplayerSessionCacheRecord> m_Records;
+};
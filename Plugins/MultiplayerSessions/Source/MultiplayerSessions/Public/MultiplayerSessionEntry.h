@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "Blueprint/IUserObjectListEntry.h"
+#include "MultiplayerSessionEntry.generated.h"
+
+/**
+ * 세션 브라우저 리스트 뷰의 한 줄
+ * 리스트 뷰가 스크롤할때 엔트리를 재사용하기 때문에 아이템이 바뀔때마다 텍스트를 다시 채운다.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UMultiplayerSessionEntry : public UUserWidget, public IUserObjectListEntry
+{
+	GENERATED_BODY()
+
+public:
+	// 아이템 객체의 값이 바뀌었을때 브라우저가 호출
+	void RefreshFromItem();
+
+protected:
+	virtual void NativeOnListItemObjectSet(UObject* ListItemObject) override;
+
+private:
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock* OwnerNameText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock* MatchTypeText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock* OpenSlotsText;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UTextBlock* PingText;
+
+	TWeakObjectPtr<class UMultiplayerSessionListItem> m_Item;
+};
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+#include "Interfaces/OnlineSessionInterface.h"
+
+class FTimerManager;
+
+// 녹화되는 세션 요청 종류
+enum class EMultiplayerRecordedOp : uint8
+{
+	Create,
+	Find,
+	Join,
+	Destroy,
+	Start,
+
+	Count
+};
+
+// 녹화된 검색 결과 하나
+// 세션 정보(FOnlineSessionInfo) 내부 구현은 서브시스템마다 달라서 담지 않는다. 대신 세션 아이디를 문자열로 남긴다.
+struct FMultiplayerRecordedResult
+{
+	FString SessionId;
+	FString OwnerName;
+	int32 PingInMs{ 0 };
+	int32 NumOpenPublicConnections{ 0 };
+	int32 NumPublicConnections{ 0 };
+	int32 BuildUniqueId{ 0 };
+	FSessionSettings Settings;
+
+	friend FArchive& operator<<(FArchive& Ar, FMultiplayerRecordedResult& Result);
+};
+
+// 녹화된 요청 하나. 요청할때의 입력과 응답까지 걸린 시간, 결과를 가진다.
+struct FMultiplayerRecordedOperation
+{
+	EMultiplayerRecordedOp Op{ EMultiplayerRecordedOp::Find };
+	// 녹화를 시작한 뒤부터 요청한 시간 (초)
+	double StartTime{ 0.0 };
+	// 요청부터 응답까지 걸린 시간 (초)
+	float Duration{ 0.f };
+	// 성공 여부. 참가는 EOnJoinSessionCompleteResult
+	int32 Result{ 0 };
+	// 생성은 인원, 검색은 최대 결과 수
+	int32 IntParam{ 0 };
+	// 생성은 매치 타입, 검색은 검색 조건, 참가는 세션 아이디
+	FString StringParam;
+	// 검색 결과. 예산으로 자르기 전의 전체 목록
+	TArray<FMultiplayerRecordedResult> Results;
+
+	friend FArchive& operator<<(FArchive& Ar, FMultiplayerRecordedOperation& Operation);
+};
+
+/**
+ * 세션 백엔드와 주고받은 요청을 파일로 녹화
+ * 라이브 검색 결과에 따라 달라지는 매치메이킹 문제를 오프라인에서 재현하고
+ * 정렬, 필터, 참가 로직을 바꿨을때 실제 세션 목록으로 성능을 비교하기 위함
+ * 파일 형식: 헤더(Magic, Version, OperationCount, UncompressedSize) + Zlib으로 압축한 요청 배열
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionRecorder
+{
+public:
+	static constexpr uint32 Magic = 0x4D505352;	// "MPSR"
+	static constexpr uint32 Version = 1;
+
+	explicit FMultiplayerSessionRecorder(const FString& InFilePath);
+
+	// 같은 종류의 요청은 동시에 하나만 진행되기 때문에 종류별로 응답을 기다리는 요청 하나만 기억한다.
+	void BeginOperation(EMultiplayerRecordedOp Op, int32 IntParam = 0, const FString& StringParam = FString());
+	// 요청하지 않은 응답은 무시. Search가 있다면 결과를 전부 복사한다.
+	void EndOperation(EMultiplayerRecordedOp Op, int32 Result, const FOnlineSessionSearch* Search = nullptr);
+
+	bool Save() const;
+	static bool Load(const FString& FilePath, TArray<FMultiplayerRecordedOperation>& OutOperations);
+
+	int32 GetNumOperations() const { return m_Operations.Num(); }
+	const FString& GetFilePath() const { return m_FilePath; }
+
+	static FMultiplayerRecordedResult CaptureResult(const FOnlineSessionSearchResult& SearchResult);
+	static FOnlineSessionSearchResult RestoreResult(const FMultiplayerRecordedResult& Recorded);
+	// 재생한 검색 결과에 남겨둔 녹화 당시 세션 아이디. 녹화된 결과가 아니라면 실제 세션 아이디
+	static FString GetRecordedSessionId(const FOnlineSessionSearchResult& SearchResult);
+	// 검색 조건을 사람이 읽을 수 있는 문자열로
+	static FString DescribeQuery(const FOnlineSessionSearch& Search);
+
+private:
+	FString m_FilePath;
+	double m_StartTime;
+	int32 m_PendingOperations[static_cast<int32>(EMultiplayerRecordedOp::Count)];
+	TArray<FMultiplayerRecordedOperation> m_Operations;
+};
+
+/**
+ * 녹화한 파일을 세션 백엔드 대신 재생
+ * 검색과 참가 요청이 오면 녹화된 순서대로 결과를 돌려주고 온라인 세션 인터페이스의 완료 델리게이트를 호출한다.
+ * 서브시스템은 실제 백엔드와 똑같은 경로로 결과를 받기 때문에 정렬, 필터, 참가 로직을 그대로 측정할 수 있다.
+ * 생성, 시작, 파괴는 검색 결과에 영향이 없어서 실제 백엔드(보통 NULL)로 보낸다.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionReplay
+{
+public:
+	// bInUseRecordedTiming이 false면 다음 틱에 바로 응답해서 결과가 시간에 영향을 받지 않는다.
+	bool Load(const FString& FilePath, bool bInUseRecordedTiming);
+	// 파일 없이 만든 요청 목록으로 재생. bInLoop면 끝까지 재생한 뒤 처음부터 다시 응답한다.
+	void SetOperations(TArray<FMultiplayerRecordedOperation>&& Operations, bool bInUseRecordedTiming, bool bInLoop);
+
+	// 기본적으로 재생 중에는 검색 간격 제한을 건너뛴다. 제한 자체를 측정할때만 켠다.
+	void SetApplySearchThrottle(bool bApply) { m_bApplySearchThrottle = bApply; }
+	bool AppliesSearchThrottle() const { return m_bApplySearchThrottle; }
+	// 백엔드 대신 응답한 검색 수
+	int32 GetNumReplayedFinds() const { return m_NumReplayedFinds; }
+
+	// 녹화된 검색이 더 없다면 false
+	bool FindSessions(const IOnlineSessionPtr& SessionInterface, const TSharedRef<FOnlineSessionSearch>& Search, FTimerManager& TimerManager);
+	bool JoinSession(const IOnlineSessionPtr& SessionInterface, const FOnlineSessionSearchResult& SessionResult, FTimerManager& TimerManager);
+
+	bool IsFinished() const;
+	void LogSummary() const;
+
+private:
+	const FMultiplayerRecordedOperation* NextOperation(EMultiplayerRecordedOp Op, int32& Cursor) const;
+	void Schedule(FTimerManager& TimerManager, float Duration, TFunction<void()>&& Respond) const;
+
+	TArray<FMultiplayerRecordedOperation> m_Operations;
+	FString m_FilePath;
+	int32 m_NextFind{ 0 };
+	int32 m_NextJoin{ 0 };
+	int32 m_NumReplayedFinds{ 0 };
+	int32 m_NumReplayedJoins{ 0 };
+	// 녹화 당시와 다른 세션을 골랐다면 정렬이나 필터가 바뀐 것
+	int32 m_NumJoinMismatches{ 0 };
+	bool m_bUseRecordedTiming{ false };
+	bool m_bLoop{ false };
+	bool m_bApplySearchThrottle{ false };
+};
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "MultiplayerSessionSoak.generated.h"
+
+/**
+ * 메뉴 -> 호스트 -> 로비 이동 -> 세션 파괴 -> 메뉴 맵으로 복귀를 반복하는 소크 테스트
+ * 메뉴를 띄운 채로 세션을 만들기 때문에 메뉴가 직접 로비로 ServerTravel 하고, 레벨이 내려갈때 메뉴의 정리,
+ * 로비 게임 모드의 PostLogin과 입장 큐, 예약 상태까지 매 사이클마다 한번씩 거친다.
+ * 한 사이클씩 끝날때마다 지연 시간을 기록하고, 워밍업이 끝난 시점을 기준으로
+ * 대기중인 콜백, 델리게이트 바인딩, 메모리가 늘어났는지 마지막에 비교한다.
+ * 기준 값은 메뉴 맵을 다시 불러온 뒤에 재기 때문에 맵 로딩에 따른 차이는 섞이지 않는다.
+ */
+UCLASS()
+class MULTIPLAYERSESSIONS_API UMultiplayerSessionSoak : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// 이미 돌고 있거나 세션이 있거나 세션 요청이 진행 중이거나 클라이언트라면 false
+	bool Start(class UMultiplayerSessionsSubsystem* Subsystem, int32 Cycles, const FString& LobbyPath);
+	void Stop();
+	bool IsRunning() const { return m_bRunning; }
+
+private:
+	void BeginCycle();
+	void EndCycle(bool bWasSuccessful);
+	void Finish();
+	void OnCycleTimeout();
+	// 세션 시작과 로비 로딩이 모두 끝나야 파괴한다.
+	void DestroyInLobby();
+	void OnPostLoadMap(UWorld* World);
+
+	UFUNCTION()
+	void OnCreateSessionComplete(bool bWasSuccessful);
+	UFUNCTION()
+	void OnStartSessionComplete(bool bWasSuccessful);
+	UFUNCTION()
+	void OnDestroySessionComplete(bool bWasSuccessful);
+
+	class FTimerManager* GetTimerManager() const;
+
+	TWeakObjectPtr<class UMultiplayerSessionsSubsystem> m_Subsystem;
+	// 사이클마다 다시 여는 메뉴. 만들고 지우는 비용이 메모리 비교에 섞이지 않도록 하나를 계속 쓴다.
+	UPROPERTY()
+	class UMenu* m_Menu{ nullptr };
+	bool m_bRunning{ false };
+
+	enum class ESoakPhase : uint8
+	{
+		None,
+		// 세션을 만드는 중. 성공하면 메뉴가 로비로 ServerTravel 한다.
+		Hosting,
+		// 로비를 불러오는 중
+		TravellingToLobby,
+		// 로비에서 세션을 파괴하는 중
+		Destroying,
+		// 메뉴 맵으로 돌아가는 중. 불러오면 사이클이 끝난다.
+		Returning
+	};
+	ESoakPhase m_Phase{ ESoakPhase::None };
+	bool m_bSessionStarted{ false };
+	bool m_bLobbyLoaded{ false };
+	bool m_bCycleSucceeded{ true };
+	// 사이클이 시작하는 맵. 세션을 파괴한 뒤 여기로 돌아온다.
+	FString m_MenuMapPath;
+	FString m_LobbyPath;
+	FDelegateHandle m_PostLoadMapDelegateHandle;
+	int32 m_NumCycles{ 0 };
+	int32 m_CurrentCycle{ 0 };
+	int32 m_NumFailures{ 0 };
+	double m_CycleStartTime{ 0.0 };
+	FTimerHandle m_CycleTimerHandle;
+
+	// 사이클 지연 시간 (초)
+	double m_MinLatency{ 0.0 };
+	double m_MaxLatency{ 0.0 };
+	double m_TotalLatency{ 0.0 };
+
+	// 워밍업이 끝난 시점의 값. 첫 몇 사이클은 캐시와 풀이 채워지면서 메모리가 늘어나는게 정상이다.
+	static constexpr int32 WarmupCycles{ 10 };
+	uint64 m_BaselineMemory{ 0 };
+	int32 m_BaselineListeners{ 0 };
+	int32 m_BaselineCallbacks{ 0 };
+
+	// 한 사이클이 이보다 오래 걸리면 콜백이 사라진 것으로 보고 중단. 맵을 두번 불러오는 시간이 들어있다.
+	static constexpr float CycleTimeout{ 30.f };
+	// 워밍업 이후 이보다 많이 늘어나면 실패
+	static constexpr uint64 MaxMemoryGrowth{ 16 * 1024 * 1024 };
+	static constexpr int32 LogInterval{ 100 };
+};
@@ -0,0 +1,300 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+#include "MultiplayerSessionTypes.generated.h"
+
+// 세션 설정에 광고되는 로비 상태
+// 검색하는 쪽에서 이 값을 보고 들어갈 수 있는 세션인지 판단한다.
+UENUM(BlueprintType)
+enum class EMultiplayerSessionState : uint8
+{
+	Lobby,
+	InProgress,
+	Closing
+};
+
+// 광고할때 문자열 대신 사용하는 매치 타입
+// 목록에 없는 매치 타입은 Custom으로 광고하고 문자열을 따로 붙인다.
+UENUM(BlueprintType)
+enum class EMultiplayerMatchType : uint8
+{
+	Custom,
+	FreeForAll,
+	TeamDeathmatch,
+	CaptureTheFlag
+};
+
+// 매치메이킹에 사용하는 지역
+// Any는 지역을 가리지 않는다는 의미
+UENUM(BlueprintType)
+enum class EMultiplayerRegion : uint8
+{
+	Any,
+	Asia,
+	Europe,
+	NorthAmerica,
+	SouthAmerica,
+	Oceania
+};
+
+// 로비가 PreLogin에서 접속을 받아들일지 판단한 결과
+// 거절되면 클라이언트는 맵을 불러오기 전에 이 이유를 받고 다른 세션을 시도한다.
+UENUM(BlueprintType)
+enum class EMultiplayerAdmissionResult : uint8
+{
+	Accepted,
+	ServerFull,
+	LobbyClosing,
+	BuildMismatch,
+	Banned,
+	NotReserved,
+	// 예약 비콘에 연결하지 못했거나 제한 시간 안에 응답이 없었다.
+	ReservationFailed
+};
+
+// 매치메이킹 요청 조건
+// 처음에는 좁은 조건으로 찾다가 시간이 지날수록 조건을 넓힌다.
+USTRUCT(BlueprintType)
+struct FMultiplayerMatchmakingParams
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString MatchType{ TEXT("FreeForAll") };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EMultiplayerRegion Region{ EMultiplayerRegion::Any };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Skill{ 1000 };
+
+	// 처음 허용하는 실력 차이
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 SkillTolerance{ 100 };
+
+	// WidenInterval마다 허용 실력 차이를 이만큼 늘린다.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 SkillToleranceStep{ 100 };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float WidenInterval{ 5.f };
+
+	// 이 시간이 지나면 다른 지역 세션도 후보로 삼는다.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float RegionWidenTime{ 10.f };
+
+	// 재검색 간격
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float SearchInterval{ 2.f };
+
+	// 이 시간 안에 찾지 못하면 실패
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float TimeBudget{ 30.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxSearchResults{ 10000 };
+};
+
+// 호스트가 나갔을때 다음 호스트가 될 플레이어
+// 로비 서버가 참가 순서대로 정리해서 클라이언트에게 복제한다.
+USTRUCT(BlueprintType)
+struct FMultiplayerHostSuccessor
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	FString PlayerId;
+
+	// 이 플레이어가 호스트가 되었을때 접속할 주소
+	UPROPERTY(BlueprintReadOnly)
+	FString ConnectAddress;
+};
+
+// 세션 설정 키 하나. 값 타입과 광고 방식이 타입에 들어가 있어서 다른 타입으로 읽고 쓰면 컴파일되지 않는다.
+// 키 이름은 FMultiplayerSessionKeys에서 한번만 FName으로 만들어두기 때문에 호출할때마다 이름 테이블을 찾지 않는다.
+template<typename ValueType, EOnlineDataAdvertisementType::Type InAdvertisementType>
+struct TMultiplayerSessionKey
+{
+	static_assert(TIsSame<ValueType, int32>::Value || TIsSame<ValueType, uint32>::Value ||
+		TIsSame<ValueType, int64>::Value || TIsSame<ValueType, uint64>::Value ||
+		TIsSame<ValueType, float>::Value || TIsSame<ValueType, double>::Value ||
+		TIsSame<ValueType, bool>::Value || TIsSame<ValueType, FString>::Value,
+		"Session setting value must be a type FVariantData can hold");
+
+	using FValue = ValueType;
+	static constexpr EOnlineDataAdvertisementType::Type AdvertisementType = InAdvertisementType;
+
+	explicit TMultiplayerSessionKey(const TCHAR* InName) :
+		Name(InName)
+	{
+	}
+
+	void Set(FOnlineSessionSettings& Settings, const ValueType& Value) const
+	{
+		Settings.Set(Name, Value, AdvertisementType);
+	}
+
+	bool Get(const FOnlineSessionSettings& Settings, ValueType& OutValue) const
+	{
+		return Settings.Get(Name, OutValue);
+	}
+
+	// 값이 없거나 타입이 다르면 Default
+	ValueType GetOr(const FOnlineSessionSettings& Settings, const ValueType& Default) const
+	{
+		ValueType Value = Default;
+		return Settings.Get(Name, Value) ? Value : Default;
+	}
+
+	void Remove(FOnlineSessionSettings& Settings) const
+	{
+		Settings.Remove(Name);
+	}
+
+	// 검색 조건도 같은 키와 타입으로 건다.
+	void SetQuery(FOnlineSearchSettings& QuerySettings, const ValueType& Value, EOnlineComparisonOp::Type ComparisonOp) const
+	{
+		QuerySettings.Set(Name, Value, ComparisonOp);
+	}
+
+	const FName Name;
+};
+
+// 이 플러그인이 광고하는 세션 설정 키
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionKeys
+{
+	// FMultiplayerSessionInfo를 압축한 값
+	static const TMultiplayerSessionKey<int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing> SessionInfo;
+	// 목록에 없는 매치 타입일때만 광고하는 문자열
+	static const TMultiplayerSessionKey<FString, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing> MatchType;
+	// 남은 자리와 실력은 백엔드에서 비교 필터를 걸 수 있도록 따로 광고
+	static const TMultiplayerSessionKey<int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing> OpenSlots;
+	static const TMultiplayerSessionKey<int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing> Skill;
+	// 빌드 아이디. 서브시스템이 BuildUniqueId를 자기 값으로 덮어쓰는 경우가 있어서 따로 광고하고 이 값으로 거른다.
+	static const TMultiplayerSessionKey<int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing> BuildId;
+	// 자리 예약 비콘 포트. 엔진의 SETTING_BEACONPORT와 같은 키
+	static const TMultiplayerSessionKey<int32, EOnlineDataAdvertisementType::ViaOnlineService> BeaconPort;
+};
+
+// 매치 타입, 지역, 상태를 숫자 하나로 압축해서 광고한다.
+// 검색 결과와 핑 응답마다 붙는 문자열 키/값을 줄이기 위함
+// [0..7] 매치 타입, [8..15] 지역, [16..23] 상태
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionInfo
+{
+	EMultiplayerMatchType MatchType{ EMultiplayerMatchType::Custom };
+	EMultiplayerRegion Region{ EMultiplayerRegion::Any };
+	EMultiplayerSessionState State{ EMultiplayerSessionState::Lobby };
+
+	int32 Pack() const;
+	static FMultiplayerSessionInfo Unpack(int32 Packed);
+
+	static EMultiplayerMatchType MatchTypeFromString(const FString& MatchType);
+	static FString MatchTypeToString(EMultiplayerMatchType MatchType);
+
+	// 세션 설정에 압축된 정보를 기록. Custom 매치 타입일때만 문자열을 함께 기록한다.
+	void Write(FOnlineSessionSettings& Settings, const FString& MatchTypeString) const;
+	// 압축된 정보가 없는 세션은 기본값을 반환
+	static FMultiplayerSessionInfo Read(const FOnlineSessionSettings& Settings);
+	static FString ReadMatchType(const FOnlineSessionSettings& Settings);
+};
+
+// 거절 이유를 PreLogin 에러 메시지에 실어 보내고 클라이언트에서 다시 꺼낸다.
+struct MULTIPLAYERSESSIONS_API FMultiplayerAdmission
+{
+	// 접속 URL에 붙이는 빌드 옵션 이름. ?Build=<BuildUniqueId>
+	static const TCHAR* BuildOption;
+
+	static FString MakeRejectMessage(EMultiplayerAdmissionResult Result);
+	// 이 플러그인이 보낸 거절 메시지가 아니라면 false
+	static bool ParseRejectMessage(const FString& ErrorMessage, EMultiplayerAdmissionResult& OutResult);
+};
+
+// 블루프린트에서 다룰 수 있도록 검색 결과를 감싼 구조체
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionResult
+{
+	GENERATED_BODY()
+
+	FMultiplayerSessionResult() = default;
+	explicit FMultiplayerSessionResult(const FOnlineSessionSearchResult& InResult);
+
+	UPROPERTY(BlueprintReadOnly)
+	FString OwnerName;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString MatchType;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 OpenSlots{ 0 };
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 PingInMs{ 0 };
+
+	// 실제로 참가할때 넘겨줄 원본 검색 결과
+	FOnlineSessionSearchResult OnlineResult;
+};
+
+// LAN 비콘으로 발견한 세션
+// 온라인 서비스를 거치지 않기 때문에 접속 주소로 바로 이동하면 된다.
+USTRUCT(BlueprintType)
+struct FMultiplayerLanSession
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	FString ConnectAddress;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString OwnerName;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString MatchType;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 OpenSlots{ 0 };
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumPublicConnections{ 0 };
+
+	// 비콘을 마지막으로 받은 시간 (FPlatformTime::Seconds)
+	double LastSeenTime{ 0.0 };
+};
+
+// 디스크 캐시에 남아있는 최근 세션
+// 첫 검색이 끝나기 전에 브라우저에 보여줄 후보로 사용
+USTRUCT(BlueprintType)
+struct FMultiplayerRecentSession
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	FString SessionId;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString ConnectAddress;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString OwnerName;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString MatchType;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 PingInMs{ 0 };
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 OpenSlots{ 0 };
+
+	UPROPERTY(BlueprintReadOnly)
+	FDateTime LastSeen;
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bJoined{ false };
+
+	// 이번 실행에서 재검증으로 살아있는 것을 확인했는지
+	UPROPERTY(BlueprintReadOnly)
+	bool bValidated{ false };
+};
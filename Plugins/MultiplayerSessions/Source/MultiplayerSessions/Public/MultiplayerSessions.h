@@ -4,6 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "Stats/Stats.h"
+#include "HAL/LowLevelMemTracker.h"
+
+MULTIPLAYERSESSIONS_API DECLARE_LOG_CATEGORY_EXTERN(LogMultiplayerSessions, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("MultiplayerSessions"), STATGROUP_MultiplayerSessions, STATCAT_Advanced);
+
+// 세션 검색 결과와 그걸 가공한 데이터가 차지하는 메모리
+LLM_DECLARE_TAG_API(MultiplayerSessionsSearch, MULTIPLAYERSESSIONS_API);
 
 class FMultiplayerSessionsModule : public IModuleInterface
 {
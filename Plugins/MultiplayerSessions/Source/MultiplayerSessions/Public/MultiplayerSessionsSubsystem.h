@@ -4,7 +4,13 @@
 
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/EngineTypes.h"
+#include "Engine/World.h"
+#include "GameFramework/OnlineReplStructs.h"
 #include "Interfaces/OnlineSessionInterface.h"
+#include "MultiplayerSessionTypes.h"
+#include "MultiplayerNetProfile.h"
+#include "MultiplayerReservationBeacon.h"
 #include "MultiplayerSessionsSubsystem.generated.h"
 
 // 
@@ -13,7 +19,20 @@ DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnFindSessionsComplete, const T
 DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnJoinSessionComplete, EOnJoinSessionCompleteResult::Type Result);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnDestroySessionComplete, bool, bWasSuccessful);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnStartSessionComplete, bool, bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnHostMigrationStarted, bool bIsNewHost);
+DECLARE_MULTICAST_DELEGATE(FMultiplayerOnLanSessionsUpdated);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnJoinRejected, EMultiplayerAdmissionResult Reason);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnPartySessionReady, bool bWasSuccessful);
 
+// 네이티브 멀티캐스트 델리게이트는 바인딩 수를 알려주지 않는다.
+// 바깥 객체가 바인딩하는 델리게이트는 이걸로 감싸서 GetDelegateListenerCount에서 함께 센다.
+template <typename DelegateType>
+class TMultiplayerCountedDelegate : public DelegateType
+{
+public:
+	// 브로드캐스트 중에 해제된 바인딩은 브로드캐스트가 끝난 뒤에 목록에서 빠진다.
+	int32 GetNumListeners() const { return this->GetInvocationList().Num(); }
+};
 
 /**
  * 
@@ -26,24 +45,149 @@ class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSubsystem : public UGameInstan
 public:
 	UMultiplayerSessionsSubsystem();
 
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
 	// 세션 기능을 처리하기 위한 메뉴 클래스가 이를 호출한다.
 	// 참가할 플레이어수, 매칭 타입
 	// 세션 생성을 호출하면 하위 시스템에서의 세션 설정에서 키 값을 설정할 수 있다.
 	void CreateSession(int32 NumPublicConnections, FString MatchType);
+	// 메뉴가 떠있는 동안 광고하지 않는 세션을 미리 만들어둔다.
+	// 같은 조건으로 CreateSession을 호출하면 광고만 켜고 바로 완료되기 때문에 호스트 버튼이 즉시 반응한다.
+	// 이미 미리 만든 세션이 있다면 같은 조건일때는 그대로 두고 다른 조건일때는 새로 만든다.
+	void PrepareSpeculativeSession(int32 NumPublicConnections, FString MatchType);
+	// 아직 만드는 중이라면 생성이 끝난 뒤에 지운다.
+	void CancelSpeculativeSession();
+	bool HasSpeculativeSession() const { return m_SpeculativeState != ESpeculativeSessionState::None; }
 	// 
 	void FindSession(int32 MaxSearchResults);
 	// 세션을 찾아서 어떤 세션을 조인할지 결정하면 SessionResult에 저장됨
 	void JoinSession(const FOnlineSessionSearchResult& SessionResult);
 	void DestroySession();
 	void StartSession();
+	// 파티장이 호출. 파티 전원이 들어갈 자리가 있는 세션을 한번만 검색해서 참가하고 전원의 자리를 한번에 예약한다.
+	// 예약이 끝나면 MultiplayerOnPartySessionReady 다음에 MultiplayerOnJoinSessionComplete가 호출되어 파티장이 이동
+	// 파티원에게 알리는 것은 게임의 파티 채널이 할 일이고, 알림을 받은 파티원은 FollowPartyLeader를 호출
+	// PartyJoinTimeout 안에 자리를 잡지 못하면 MultiplayerOnPartySessionReady(false)
+	void FindPartySession(const TArray<FString>& MemberIds, int32 MaxSearchResults);
+	// 파티 검색을 그만둔다. 결과는 알리지 않는다. 이미 요청한 참가는 혼자 참가한 것으로 끝난다.
+	void CancelPartySession();
+	// 파티원이 호출. 파티장이 참가한 세션을 프레즌스로 찾아서 참가한다. 자리는 이미 예약되어 있다.
+	bool FollowPartyLeader(const FUniqueNetIdRepl& LeaderId);
+	bool IsPartyJoinInProgress() const { return m_bPartyJoinPending; }
+	// 진행중인 요청이 있다면 새로 요청하지 않고 같은 결과를 기다리면 된다.
+	bool IsCreateSessionInProgress() const { return m_CreateSessionCompleteDelegateHandle.IsValid(); }
+	bool IsFindSessionInProgress() const { return m_FindSessionCompleteDelegateHandle.IsValid(); }
+	bool IsJoinSessionInProgress() const { return m_JoinSessionCompleteDelegateHandle.IsValid(); }
+	// 진행중인 참가 요청이 이 세션에 대한 것인지. 다른 세션이라면 그 결과를 기다리면 안된다.
+	bool IsJoiningSession(const FOnlineSessionSearchResult& SessionResult) const;
+	// 진행중인 검색을 백엔드에서 취소한다. 결과를 기다리는 리스너가 남아있다면 취소하지 않는다.
+	void CancelFindSession();
+	// 마지막 검색 객체. 다음 검색을 시작해도 이 참조를 들고 있는 동안은 결과가 유지된다.
+	TSharedPtr<const FOnlineSessionSearch> GetLastSessionSearch() const { return m_LastSessionSearch; }
+	// 참가가 끝났거나 메뉴가 닫혀서 더 이상 필요 없는 검색 결과를 놓아준다.
+	// 다른 곳에서 참조를 들고 있다면 그 참조가 사라질때 해제된다.
+	void ReleaseSearchResults();
+	// 마지막 검색 결과가 차지하는 대략적인 메모리 (바이트)
+	int64 GetSearchMemoryUsage() const { return m_SearchMemoryUsage; }
+	// 로비 인원이 바뀔때마다 호스트가 호출한다.
+	// 바로 UpdateSession을 호출하지 않고 m_SessionUpdateInterval 간격으로 모아서 광고 정보를 갱신
+	void UpdateSessionOccupancy(int32 NumPlayers, EMultiplayerSessionState State = EMultiplayerSessionState::Lobby);
+	// 로비 서버에서 예약 비콘을 열고 세션 광고에 비콘 포트를 싣는다. 요청은 OnReservationRequest가 판단
+	// 광고는 다음 인원 갱신때 반영되기 때문에 호출한 뒤에 UpdateSessionOccupancy를 불러줄 것
+	bool StartReservationHost(UWorld* World, const FMultiplayerOnReservationRequest& OnReservationRequest);
+	void StopReservationHost();
+	// 로비의 PreLogin에서 입장을 판단할때 사용. 세션이 없다면 false, 0과 Lobby
+	bool HasSession() const;
+	int32 GetSessionCapacity() const;
+	EMultiplayerSessionState GetSessionState() const;
+	// 세션 광고와 접속 URL에 들어가는 빌드 아이디
+	// 네트워크 버전(프로젝트 버전, 엔진과 게임의 네트워크 프로토콜)과 플러그인 버전으로 만든다. 값이 다르면 접속해도 실패한다.
+	static int32 GetBuildUniqueId();
+	// 마지막 검색에서 빌드가 달라서 버린 결과 수와 지금까지 버린 결과 수
+	// Steam처럼 검색 조건을 지키는 백엔드는 빌드 아이디 조건으로 이미 걸러서 보내기 때문에 항상 0이다. NULL, LAN에서만 값이 생긴다.
+	int32 GetLastIncompatibleResultCount() const { return m_LastIncompatibleResults; }
+	int32 GetTotalIncompatibleResultCount() const { return m_TotalIncompatibleResults; }
+	// 세션을 생성할때 함께 광고할 실력 점수와 지역
+	void SetMatchmakingProfile(int32 Skill, EMultiplayerRegion Region);
+	// 매치메이킹 서비스는 처음 요청할때 생성된다.
+	class UMultiplayerMatchmaker* GetMatchmaker();
+
+	// 로비 서버가 정한 호스트 승계 순서. 호스트가 나가면 이 순서대로 새 호스트를 정한다.
+	void SetHostSuccession(const TArray<FMultiplayerHostSuccessor>& Successors);
+	void SetHostMigrationEnabled(bool bEnabled) { m_bHostMigrationEnabled = bEnabled; }
+	// 호스트가 로비를 닫기 직전에 보낸 알림. 이 알림 뒤에 끊기면 호스트가 나간 것이 확실해서 확인 없이 승계
+	void NotifyHostLeaving() { m_bHostLeavingNotified = true; }
+	// 호스트 승계 목록에 들어갈 접속 주소를 만든다. 서버에서 호출
+	static FString GetSuccessorConnectAddress(const class APlayerController* PlayerController);
+
+	// 마지막으로 참가에 성공한 세션의 접속 주소
+	bool GetLastConnectString(FString& OutAddress) const;
+	// 접속 URL에 빌드 아이디를 붙여서 로비가 맵을 불러오기 전에 확인할 수 있게 한다.
+	void TravelToSession(const FString& Address);
+	// 잠깐 연결이 끊겼을때 검색 없이 마지막 세션으로 다시 접속. 세션에 다시 참가하고 예약까지 받은 뒤에 이동한다.
+	// 재시작한 뒤라면 디스크 캐시의 세션 아이디로 세션을 찾아서 참가한다.
+	// 아이디로 찾지 못하는 백엔드는 캐시의 주소로 바로 이동하기 때문에 예약을 요구하지 않는 로비에만 들어갈 수 있고
+	// 세션에는 참가하지 않은 채로 접속만 한다. (ALobbyGameMode::bRequireReservation 참고)
+	// 캐시가 없거나 오래되었다면 false를 반환하고 이때는 다시 검색해야 한다.
+	bool Rejoin();
+	// 디스크에 남아있는 최근 세션. 첫 검색이 끝나기 전에도 바로 사용할 수 있다.
+	TArray<FMultiplayerRecentSession> GetRecentSessions() const;
+
+	// NULL 서브시스템(LAN)에서 기본 LAN 검색 대신 사용하는 비콘 리스너
+	// 리스너가 켜져 있는 동안 GetLanSessions가 계속 최신 목록을 반환한다.
+	// LAN이 아니라면 false. 세션 브라우저가 열릴때 켜고 닫힐때나 TravelToSession에서 끈다.
+	bool StartLanDiscovery();
+	void StopLanDiscovery();
+	TArray<FMultiplayerLanSession> GetLanSessions() const;
+
+	// 넷 드라이버 튜닝 프리셋을 바꾼다. 지금 넷 드라이버에 바로 적용하고 이후에 만들어지는 월드에도 적용
+	// 기본 프리셋은 [MultiplayerSessions.NetProfiles] ActiveProfile
+	bool SetNetProfile(const FString& ProfileName);
+	const FString& GetNetProfileName() const { return m_NetProfile.Name; }
+	// 현재 월드의 넷 드라이버 트래픽을 로그로 남긴다.
+	void LogNetStats() const;
+
+	// 응답을 기다리는 온라인 세션 인터페이스 콜백 수. 요청이 모두 끝났는데 0이 아니라면 핸들이 새고 있는 것
+	int32 GetPendingOnlineCallbackCount() const;
+	// 메뉴 같은 바깥 객체가 이 서브시스템 델리게이트에 바인딩한 수
+	int32 GetDelegateListenerCount() const;
+	// 세션 생성, 시작, 파괴를 Cycles번 반복하면서 지연 시간과 콜백, 델리게이트, 메모리가 늘어나는지 확인
+	// 콘솔 명령 MultiplayerSessions.Soak [Cycles] [LobbyPath]. NULL 서브시스템에서 메뉴 맵을 띄운 채로 돌리는 것을 기준으로 한다.
+	bool StartSoak(int32 Cycles, const FString& LobbyPath = FString(TEXT("/Game/ThirdPerson/Maps/Lobby")));
+	// 리슨 서버에서 로컬 클라이언트 NumClients개를 띄워 넷 프로필 값을 바꿔가며 측정한다.
+	// 콘솔 명령 MultiplayerSessions.NetSweep [Clients] [SecondsPerStep]
+	bool StartNetSweep(int32 NumClients, float SecondsPerStep);
+
+	// 세션 요청의 입력, 걸린 시간, 검색 결과 전체를 파일로 녹화. 멈출때 저장된다.
+	// 콘솔 명령 MultiplayerSessions.Record [File|Stop]
+	bool StartRecording(const FString& FilePath);
+	void StopRecording();
+	bool IsRecording() const { return m_Recorder.IsValid(); }
+	// 녹화한 파일로 검색과 참가 응답을 대신한다. bUseRecordedTiming이 false면 다음 틱에 바로 응답
+	// 콘솔 명령 MultiplayerSessions.Replay [File|Stop] [Timed]
+	bool StartReplay(const FString& FilePath, bool bUseRecordedTiming = false);
+	bool StartReplay(TSharedRef<class FMultiplayerSessionReplay> Replay);
+	void StopReplay();
+	bool IsReplaying() const { return m_Replay.IsValid(); }
+	// 재생 백엔드에 검색 버튼을 초당 ClicksPerSecond번 Seconds초 동안 누르고
+	// 백엔드로 나간 검색이 검색 간격 제한 안에 들어오는지 확인한다.
+	// 콘솔 명령 MultiplayerSessions.SearchMash [Seconds] [ClicksPerSecond]
+	bool StartSearchMash(float Seconds, float ClicksPerSecond);
 
 
 	// 메뉴 클래스에 콜백을 바인딩하기 위한 사용자 지정 델리게이트
 	FMultiplayerOnCreateSessionComplete MultiplayerOnCreateSessionComplete;
-	FMultiplayerOnFindSessionsComplete MultiplayerOnFindSessionComplete;
-	FMultiplayerOnJoinSessionComplete MultiplayerOnJoinSessionComplete;
+	TMultiplayerCountedDelegate<FMultiplayerOnFindSessionsComplete> MultiplayerOnFindSessionComplete;
+	TMultiplayerCountedDelegate<FMultiplayerOnJoinSessionComplete> MultiplayerOnJoinSessionComplete;
 	FMultiplayerOnDestroySessionComplete MultiplayerOnDestroySessionComplete;
 	FMultiplayerOnStartSessionComplete MultiplayerOnStartSessionComplete;
+	FMultiplayerOnHostMigrationStarted MultiplayerOnHostMigrationStarted;
+	FMultiplayerOnLanSessionsUpdated MultiplayerOnLanSessionsUpdated;
+	// 파티장이 파티 전원의 자리를 예약했거나 실패했을때
+	FMultiplayerOnPartySessionReady MultiplayerOnPartySessionReady;
+	// 로비가 PreLogin에서 접속을 거절했을때. 참가했던 세션을 정리한 뒤에 호출되기 때문에 바로 다른 세션에 참가할 수 있다.
+	FMultiplayerOnJoinRejected MultiplayerOnJoinRejected;
 
 protected:
 	// 델리게이트에 바인드할 콜백 함수
@@ -52,8 +196,82 @@ protected:
 	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
 	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessful);
 	void OnStartSessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnUpdateSessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnLanSessionsChanged();
 
 private:
+	// 대기중인 콜백과 델리게이트 바인딩 수를 스탯에 기록
+	void UpdateListenerStats() const;
+	void CreateSessionInternal(int32 NumPublicConnections, const FString& MatchType, bool bShouldAdvertise);
+	// 다시 만들려고 지우던 세션을 지우지 못했다면 생성도 실패로 알린다.
+	void FailCreateSessionOnDestroy();
+	// 미리 만든 세션의 광고를 켜고 세션 생성 완료를 알린다.
+	void PublishSpeculativeSession();
+	void StartLanBroadcast();
+
+	// 검색 결과에 따라 다음 검색을 허용할 시간을 정한다. 실패가 이어지면 지수적으로 늘린다.
+	void ScheduleNextSearch(bool bWasSuccessful);
+	// 검색 요청이 제한에 걸렸을때 마지막 결과로 응답
+	void BroadcastLastSearchResults();
+
+	// 검색 결과를 개수와 메모리 상한에 맞춰 자르고 사용량을 기록
+	void EnforceSearchBudget();
+	// 빌드 아이디가 다른 결과를 버린다. 백엔드가 검색 조건을 무시하는 경우(NULL, LAN)가 있어서 받은 뒤에 다시 확인
+	// 재생 중에는 녹화된 결과를 그대로 쓴다.
+	void RemoveIncompatibleResults();
+
+	// 대기중인 인원 정보를 세션 설정에 반영
+	void FlushSessionOccupancy();
+
+	// 호스트와의 연결이 끊기면 승계 목록을 보고 새 호스트가 되거나 새 호스트에게 접속
+	void HandleNetworkFailure(UWorld* World, class UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString);
+	// 끊긴 순간의 승계 정보를 저장해두고 엔진이 실패 처리로 맵을 이동한 뒤에 승계를 이어간다.
+	void PrepareHostMigration(UWorld* World);
+	void BeginHostMigration();
+	// m_HostMigrationSuccessorIndex 번째 승계자를 새 호스트로 정하고 이 클라이언트가 그 승계자인지 확인
+	void SelectHostSuccessor();
+	// 새 호스트가 세션을 만들지 못했거나 아무도 접속하지 못했다면 목록의 다음 승계자로 넘어간다.
+	void FallBackToNextHostSuccessor();
+	// 호스트가 나간다는 알림 없이 끊겼다면 호스트의 예약 비콘에 연결해봐서 정말 나갔는지 확인
+	void ProbeHost();
+	void OnHostProbeComplete(EMultiplayerAdmissionResult Result);
+	void RetryTravelToNewHost();
+	void FinishHostMigration();
+	void OnPostLoadMap(UWorld* World);
+	// 로비가 보낸 거절 이유를 받아서 세션을 정리하고 알린다.
+	void HandleJoinRejected(EMultiplayerAdmissionResult Reason);
+
+	// 참가한 세션이 예약 비콘을 광고한다면 자리를 먼저 예약. 예약을 시작하지 않았다면 false
+	// 파티로 참가하는 중이라면 파티원 자리까지 같이 예약한다.
+	bool RequestReservation();
+	void OnReservationComplete(EMultiplayerAdmissionResult Result);
+
+	void OnPartySearchComplete(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
+	void OnPartySearchProcessed(TSharedRef<const FOnlineSessionSearch> Search, TArray<struct FMultiplayerDecodedResult>&& SortedResults);
+	void OnPartyJoinRejected(EMultiplayerAdmissionResult Reason);
+	void JoinNextPartyCandidate();
+	void FinishPartyJoin(bool bWasSuccessful);
+	void OnPartyJoinTimeout();
+	// 파티 상태와 델리게이트, 타이머 정리. 결과는 알리지 않는다.
+	void ResetPartyJoin();
+	void OnFindFriendSessionComplete(int32 LocalUserNum, bool bWasSuccessful, const TArray<FOnlineSessionSearchResult>& SearchResults);
+	void TravelToNewHost();
+
+	// 새 월드가 열릴때마다 선택된 넷 프로필을 다시 적용
+	void OnWorldInitializedActors(const UWorld::FActorsInitializedParams& Params);
+	void ApplyNetProfile(UWorld* World);
+
+	class FMultiplayerLanDiscovery& GetLanDiscovery();
+	bool IsLanMatch() const;
+
+	// 검색 결과를 최근 세션 캐시에 기록
+	void RecordSearchResults(const TArray<FOnlineSessionSearchResult>& SessionResults);
+	// 캐시에 남아있는 세션이 아직 살아있는지 하나씩 백그라운드로 확인
+	void RevalidateNextCachedSession();
+	void OnRevalidateSessionComplete(int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& SearchResult, FString SessionId);
+	// 디스크 캐시로 재접속할때 세션 아이디로 찾은 결과. 찾았다면 참가하고, 찾을 수 없는 백엔드라면 주소로 바로 이동
+	void OnRejoinSessionFound(int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& SearchResult, FString SessionId, FString ConnectAddress);
+
 	IOnlineSessionPtr m_SessionInterface;
 	// 세션 정보를 저장
 	TSharedPtr<FOnlineSessionSettings>	m_LastSessionSettings;
@@ -72,9 +290,163 @@ private:
 	FDelegateHandle m_DestroySessionCompleteDelegateHandle;
 	FOnStartSessionCompleteDelegate		m_StartSessionCompleteDelegate;
 	FDelegateHandle m_StartSessionCompleteDelegateHandle;
+	FOnUpdateSessionCompleteDelegate	m_UpdateSessionCompleteDelegate;
+	FDelegateHandle m_UpdateSessionCompleteDelegateHandle;
+
+	// 검색 결과 상한. [MultiplayerSessions.Search]에서 읽는다.
+	int32 m_SearchMaxResults{ 10000 };
+	int64 m_SearchMaxBytes{ 32 * 1024 * 1024 };
+	int64 m_SearchMemoryUsage{ 0 };
+	int32 m_LastIncompatibleResults{ 0 };
+	int32 m_TotalIncompatibleResults{ 0 };
+
+	// 검색 요청 제한. 성공하면 m_SearchMinInterval, 실패가 이어지면 BackoffBase부터 두배씩 BackoffMax까지
+	float m_SearchMinInterval{ 2.f };
+	float m_SearchBackoffBase{ 2.f };
+	float m_SearchBackoffMax{ 60.f };
+	int32 m_SearchFailureCount{ 0 };
+	double m_NextSearchAllowedTime{ 0.0 };
+	FTimerHandle m_DeferredSearchTimerHandle;
+	FTimerHandle m_SearchMashTimerHandle;
 
 	// 이걸 확인하고 콜백하는데 세션이 파괴될때 이게 true면 새 세션을 생성
 	bool m_bCreateSessionOnDestroy{ false };
 	int32 m_LastNumPublicConnections;
 	FString m_LastMatchType;
+	// 미리 만드는 세션은 광고하지 않은 채로 다시 만들어야 한다.
+	bool m_LastShouldAdvertise{ true };
+
+	// 미리 만들어둔 세션 상태. Ready가 되어도 광고하기 전까지는 메뉴에 알리지 않는다.
+	enum class ESpeculativeSessionState : uint8
+	{
+		None,
+		Creating,
+		Ready
+	};
+	ESpeculativeSessionState m_SpeculativeState{ ESpeculativeSessionState::None };
+	int32 m_SpeculativeNumPublicConnections{ 0 };
+	FString m_SpeculativeMatchType;
+	// 생성 중에 들어온 요청은 생성이 끝난 뒤에 처리한다. 생성 중에 지우거나 다시 만들면 콜백이 엇갈린다.
+	enum class ESpeculativeCreateAction : uint8
+	{
+		None,
+		// 같은 조건으로 호스트 요청. 광고를 켠다.
+		Publish,
+		// 다른 조건으로 호스트 요청. m_LastNumPublicConnections, m_LastMatchType으로 다시 만든다.
+		Replace,
+		// 메뉴가 닫혔다. 세션을 지운다.
+		Destroy,
+		// 메뉴가 다른 조건으로 다시 열렸다. m_SpeculativeNumPublicConnections, m_SpeculativeMatchType으로 광고하지 않은 채로 다시 만든다.
+		Restart
+	};
+	ESpeculativeCreateAction m_SpeculativeCreateAction{ ESpeculativeCreateAction::None };
+	// 미리 만든 세션을 지운 뒤에 참가할 세션
+	FOnlineSessionSearchResult m_PendingJoinResult;
+	bool m_bJoinSessionOnDestroy{ false };
+
+	// 인원 광고 갱신은 백엔드 부하를 줄이기 위해 최소 간격을 둔다.
+	float m_SessionUpdateInterval{ 2.f };
+	double m_LastSessionUpdateTime{ 0.0 };
+	FTimerHandle m_SessionUpdateTimerHandle;
+	bool m_bSessionUpdatePending{ false };
+	bool m_bSessionUpdateInFlight{ false };
+	int32 m_PendingNumPlayers{ 0 };
+	EMultiplayerSessionState m_PendingSessionState{ EMultiplayerSessionState::Lobby };
+
+	UPROPERTY()
+	class UMultiplayerMatchmaker* m_Matchmaker;
+
+	// 녹화와 재생. 켜져 있을때만 생성
+	TSharedPtr<class FMultiplayerSessionRecorder> m_Recorder;
+	TSharedPtr<class FMultiplayerSessionReplay> m_Replay;
+
+	// 소크 테스트를 돌릴때만 생성
+	UPROPERTY()
+	class UMultiplayerSessionSoak* m_Soak;
+
+	// 넷 프로필 측정을 돌릴때만 생성
+	UPROPERTY()
+	class UMultiplayerNetSweep* m_NetSweep;
+
+	int32 m_LocalSkill{ 1000 };
+	EMultiplayerRegion m_LocalRegion{ EMultiplayerRegion::Any };
+
+	// 호스트 승계
+	TArray<FMultiplayerHostSuccessor> m_HostSuccession;
+	bool m_bHostMigrationEnabled{ true };
+	enum class EHostMigrationState : uint8
+	{
+		None,
+		// 엔진이 실패 처리로 기본 맵을 불러오는 중. 그 전에 이동하면 엔진의 이동에 덮어써진다.
+		WaitingForMap,
+		// 호스트가 정말 나갔는지 비콘으로 확인하는 중
+		Probing,
+		// 새 호스트로 세션을 만들고 있는 중. 세션 생성이 끝나면 로비로 ServerTravel
+		CreatingSession,
+		// 새 호스트에게 접속하는 중
+		Travelling
+	};
+	EHostMigrationState m_HostMigrationState{ EHostMigrationState::None };
+	bool m_bHostLeavingNotified{ false };
+	FMultiplayerHostSuccessor m_HostMigrationSuccessor;
+	int32 m_HostMigrationSuccessorIndex{ 0 };
+	FString m_HostMigrationLocalPlayerId;
+	bool m_bIsNewHost{ false };
+	FString m_HostMigrationTravelURL;
+	int32 m_HostProbeAttempts{ 0 };
+	int32 m_HostMigrationTravelAttempts{ 0 };
+	static constexpr int32 MaxHostProbeAttempts{ 2 };
+	static constexpr int32 MaxHostMigrationTravelAttempts{ 3 };
+	FDelegateHandle m_PostLoadMapDelegateHandle;
+	// 자리 예약 비콘. 서버는 호스트와 호스트 객체, 클라이언트는 요청 중인 비콘 클라이언트를 가진다.
+	TWeakObjectPtr<class AOnlineBeaconHost> m_ReservationBeaconHost;
+	TWeakObjectPtr<AMultiplayerReservationBeaconHostObject> m_ReservationHostObject;
+	TWeakObjectPtr<AMultiplayerReservationBeaconClient> m_ReservationClient;
+	int32 m_ReservationBeaconPort{ 0 };
+	// 응답이 이보다 늦으면 예약 실패로 보고 다른 세션을 시도. [MultiplayerSessions.Reservation]
+	float m_ReservationTimeout{ 5.f };
+	// 파티 참가. 파티장은 자신을 뺀 파티원 아이디를 가지고 있는다.
+	TArray<FString> m_PartyMemberIds;
+	// 점수 순으로 정렬된 후보. 로비가 거절하면 다음 후보를 시도
+	TArray<FOnlineSessionSearchResult> m_PartyCandidates;
+	static constexpr int32 MaxPartyCandidates{ 3 };
+	// 검색, 참가, 예약을 합쳐서 이 시간이 넘으면 실패로 끝낸다.
+	static constexpr float PartyJoinTimeout{ 30.f };
+	FTimerHandle m_PartyJoinTimerHandle;
+	bool m_bPartySearchPending{ false };
+	bool m_bPartyJoinPending{ false };
+	FDelegateHandle m_PartyFindSessionCompleteDelegateHandle;
+	FDelegateHandle m_PartyJoinRejectedDelegateHandle;
+	FDelegateHandle m_FindFriendSessionCompleteDelegateHandle;
+	// 로비에서 거절당한 이유. 참가했던 세션을 정리하고 나서 알린다.
+	TOptional<EMultiplayerAdmissionResult> m_PendingJoinRejection;
+	// 새 호스트가 세션을 만들고 로비를 열 때까지 기다리는 시간. 접속에 실패하면 이 간격으로 다시 시도
+	float m_HostMigrationGraceTime{ 5.f };
+	FTimerHandle m_HostMigrationTimerHandle;
+	FDelegateHandle m_NetworkFailureDelegateHandle;
+
+	// 재접속을 위해 마지막으로 참가에 성공한 세션을 저장. 참가에 실패해도 이전 값은 남겨둔다.
+	FOnlineSessionSearchResult m_LastJoinedResult;
+	FString m_LastConnectString;
+	double m_LastJoinTime{ 0.0 };
+	// 참가 요청 중인 세션. 성공하면 m_LastJoinedResult로 옮긴다.
+	FOnlineSessionSearchResult m_JoiningResult;
+	// 호스트와의 연결이 마지막으로 끊긴 시간
+	double m_DisconnectTime{ 0.0 };
+	// 끊긴 뒤로 이 시간이 지난 캐시는 호스트가 바뀌었을 수 있어서 사용하지 않는다.
+	float m_RejoinCacheLifetime{ 300.f };
+	bool m_bRejoinPending{ false };
+
+	// LAN 세션 비콘. 처음 사용할때 생성
+	TSharedPtr<class FMultiplayerLanDiscovery> m_LanDiscovery;
+
+	FMultiplayerNetProfile m_NetProfile;
+	FDelegateHandle m_WorldInitializedActorsDelegateHandle;
+
+	// 최근 세션 캐시. Initialize에서 디스크로부터 불러온다.
+	TSharedPtr<class FMultiplayerSessionCache> m_SessionCache;
+	// 재검증할 세션 아이디. 백엔드 부하를 줄이기 위해 m_RevalidateInterval마다 하나씩 확인
+	TArray<FString> m_PendingRevalidation;
+	float m_RevalidateInterval{ 1.f };
+	FTimerHandle m_RevalidateTimerHandle;
 };
@@ -2,18 +2,304 @@
 
 
 #include "LobbyGameMode.h"
+#include "LobbyGameState.h"
 #include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
 #include "GameFramework/PlayerState.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "MultiplayerNetHealthComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "TimerManager.h"
+#include "Misc/Paths.h"
+
+DECLARE_STATS_GROUP(TEXT("Lobby"), STATGROUP_Lobby, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Process Join Queue"), STAT_LobbyProcessJoinQueue, STATGROUP_Lobby);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Join Queue Depth"), STAT_LobbyJoinQueueDepth, STATGROUP_Lobby);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Join Queue Frame Cost (ms)"), STAT_LobbyJoinQueueFrameMs, STATGROUP_Lobby);
+
+ALobbyGameMode::ALobbyGameMode()
+{
+	GameStateClass = ALobbyGameState::StaticClass();
+
+	// 참가 큐에 플레이어가 있을때만 틱
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	NetHealth = CreateDefaultSubobject<UMultiplayerNetHealthComponent>(TEXT("NetHealth"));
+	NetHealth->CsvFilePath = FPaths::ProfilingDir() / TEXT("LobbyNetHealth.csv");
+}
+
+void ALobbyGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UGameInstance* GameInstance = GetGameInstance();
+	UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+
+	// 참가한 클라이언트가 이동하기 전에 자리를 예약할 수 있도록 비콘을 연다.
+	if (Subsystem && GetNetMode() != NM_Standalone &&
+		Subsystem->StartReservationHost(GetWorld(), FMultiplayerOnReservationRequest::CreateUObject(this, &ThisClass::HandleReservationRequest)))
+	{
+		// 비콘 포트를 광고에 싣는다.
+		UpdateSessionOccupancy(GetNumPlayers());
+	}
+}
+
+void ALobbyGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// 로비를 닫는 것은 호스트가 나가는 것. 클라이언트가 확인 없이 바로 승계하도록 연결이 닫히기 전에 알린다.
+	ALobbyGameState* LobbyGameState = GetGameState<ALobbyGameState>();
+	UNetDriver* NetDriver = GetNetDriver();
+
+	if (LobbyGameState && NetDriver && !GetWorld()->IsInSeamlessTravel())
+	{
+		LobbyGameState->MulticastHostLeaving();
+
+		for (UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			if (Connection)
+			{
+				Connection->FlushNet();
+			}
+		}
+	}
+
+	UGameInstance* GameInstance = GetGameInstance();
+	UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+
+	if (Subsystem)
+	{
+		Subsystem->StopReservationHost();
+	}
+
+	m_JoinQueue.Reset();
+	SET_DWORD_STAT(STAT_LobbyJoinQueueDepth, 0);
+	GetWorldTimerManager().ClearTimer(m_ReservationExpiryTimerHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ALobbyGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	ProcessJoinQueue();
+}
+
+void ALobbyGameMode::PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage)
+{
+	Super::PreLogin(Options, Address, UniqueId, ErrorMessage);
+
+	// 엔진이 이미 거절했다면 그 메시지를 그대로 보낸다.
+	if (!ErrorMessage.IsEmpty())
+		return;
+
+	RemoveExpiredReservations();
+
+	TArray<FString> PlayerIds;
+	if (UniqueId.IsValid())
+	{
+		PlayerIds.Add(UniqueId.ToString());
+	}
+
+	const FString BuildOption = UGameplayStatics::ParseOption(Options, FMultiplayerAdmission::BuildOption);
+	const int32 BuildUniqueId = BuildOption.IsEmpty() ? INDEX_NONE : FCString::Atoi(*BuildOption);
+
+	// 세션을 광고하는 로비라면 TravelToSession이 항상 빌드 옵션을 붙이기 때문에 옵션이 없는 접속은 다른 빌드로 본다.
+	// 세션 없이 띄운 로비만 주소로 바로 들어오는 접속을 확인하지 않는다.
+	UGameInstance* GameInstance = GetGameInstance();
+	UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+	const bool bMissingBuild = BuildOption.IsEmpty() && Subsystem && Subsystem->HasSession();
+
+	const EMultiplayerAdmissionResult Result = bMissingBuild ? EMultiplayerAdmissionResult::BuildMismatch : CheckAdmission(PlayerIds, BuildUniqueId, false);
+
+	if (Result != EMultiplayerAdmissionResult::Accepted)
+	{
+		// 이 메시지가 NMT_Failure로 클라이언트에 전달되고 연결이 닫힌다.
+		ErrorMessage = FMultiplayerAdmission::MakeRejectMessage(Result);
+
+		UE_LOG(LogGameMode, Log, TEXT("PreLogin rejected %s (%s): %s"), *UniqueId.ToString(), *Address, *ErrorMessage);
+	}
+}
+
+EMultiplayerAdmissionResult ALobbyGameMode::CheckAdmission(const TArray<FString>& PlayerIds, int32 BuildUniqueId, bool bIsReservationRequest) const
+{
+	int32 NumUnreserved = 0;
+
+	for (const FString& PlayerId : PlayerIds)
+	{
+		if (m_BannedPlayerIds.Contains(PlayerId))
+			return EMultiplayerAdmissionResult::Banned;
+
+		if (!m_Reservations.Contains(PlayerId))
+		{
+			++NumUnreserved;
+		}
+	}
+
+	if (BuildUniqueId != INDEX_NONE && BuildUniqueId != UMultiplayerSessionsSubsystem::GetBuildUniqueId())
+		return EMultiplayerAdmissionResult::BuildMismatch;
+
+	// 아이디를 알 수 없는 접속도 예약이 없는 것으로 본다.
+	if (bRequireReservation && !bIsReservationRequest && (NumUnreserved > 0 || PlayerIds.Num() == 0))
+		return EMultiplayerAdmissionResult::NotReserved;
+
+	UGameInstance* GameInstance = GetGameInstance();
+	UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+
+	// 세션 없이 띄운 로비라면 인원과 상태는 확인할 방법이 없다.
+	if (Subsystem == nullptr)
+		return EMultiplayerAdmissionResult::Accepted;
+
+	if (Subsystem->GetSessionState() == EMultiplayerSessionState::Closing)
+		return EMultiplayerAdmissionResult::LobbyClosing;
+
+	// 예약된 플레이어의 자리는 이미 비워두었기 때문에 새로 자리가 필요한 인원만 확인
+	NumUnreserved = FMath::Max(NumUnreserved, PlayerIds.Num() == 0 ? 1 : 0);
+	const int32 Capacity = Subsystem->GetSessionCapacity();
+	if (Capacity > 0 && NumUnreserved > 0 && GetNumPlayers() + m_Reservations.Num() + NumUnreserved > Capacity)
+		return EMultiplayerAdmissionResult::ServerFull;
+
+	return EMultiplayerAdmissionResult::Accepted;
+}
+
+EMultiplayerAdmissionResult ALobbyGameMode::HandleReservationRequest(const TArray<FString>& PlayerIds, int32 BuildUniqueId)
+{
+	RemoveExpiredReservations();
+
+	const EMultiplayerAdmissionResult Result = CheckAdmission(PlayerIds, BuildUniqueId, true);
+
+	if (Result == EMultiplayerAdmissionResult::Accepted)
+	{
+		for (const FString& PlayerId : PlayerIds)
+		{
+			AddReservation(PlayerId);
+		}
+
+		// 예약한 자리는 검색 결과에서도 빠지도록
+		UpdateSessionOccupancy(GetNumPlayers());
+	}
+
+	return Result;
+}
+
+void ALobbyGameMode::RemoveExpiredReservations()
+{
+	const double Now = FPlatformTime::Seconds();
+	int32 NumExpired = 0;
+	double NextExpiry = TNumericLimits<double>::Max();
+
+	for (auto It = m_Reservations.CreateIterator(); It; ++It)
+	{
+		if (It.Value() <= Now)
+		{
+			It.RemoveCurrent();
+			++NumExpired;
+		}
+		else
+		{
+			NextExpiry = FMath::Min(NextExpiry, It.Value());
+		}
+	}
+
+	// 접속이 없어도 남은 예약 중 가장 먼저 끝나는 시간에 다시 정리
+	GetWorldTimerManager().ClearTimer(m_ReservationExpiryTimerHandle);
+	if (m_Reservations.Num() > 0)
+	{
+		GetWorldTimerManager().SetTimer(m_ReservationExpiryTimerHandle, this, &ThisClass::RemoveExpiredReservations, FMath::Max(static_cast<float>(NextExpiry - Now), 0.1f), false);
+	}
+
+	// 돌려준 자리가 검색 결과에도 다시 보이도록
+	if (NumExpired > 0)
+	{
+		UE_LOG(LogGameMode, Log, TEXT("%d reservation(s) expired"), NumExpired);
+		UpdateSessionOccupancy(GetNumPlayers());
+	}
+}
+
+void ALobbyGameMode::BanPlayer(const FString& PlayerId)
+{
+	m_BannedPlayerIds.Add(PlayerId);
+	m_Reservations.Remove(PlayerId);
+}
+
+void ALobbyGameMode::UnbanPlayer(const FString& PlayerId)
+{
+	m_BannedPlayerIds.Remove(PlayerId);
+}
+
+void ALobbyGameMode::AddReservation(const FString& PlayerId)
+{
+	m_Reservations.Add(PlayerId, FPlatformTime::Seconds() + ReservationLifetime);
+
+	if (!GetWorldTimerManager().IsTimerActive(m_ReservationExpiryTimerHandle))
+	{
+		GetWorldTimerManager().SetTimer(m_ReservationExpiryTimerHandle, this, &ThisClass::RemoveExpiredReservations, ReservationLifetime, false);
+	}
+}
+
+void ALobbyGameMode::RemoveReservation(const FString& PlayerId)
+{
+	m_Reservations.Remove(PlayerId);
+}
 
 void ALobbyGameMode::PostLogin(APlayerController* NewPlayer)
 {
 	Super::PostLogin(NewPlayer);
 
-	// 플레이어가 들어올때마다 PostLogin함수가 실행되는데
-	// 이떄 서버에 접속한 플레이어 인원수를 알 수 있다.
-	if (GameState) 
+	if (NewPlayer == nullptr)
+		return;
+
+	// 예약한 자리에 들어왔으니 예약은 지운다.
+	// 인원 계산에 바로 영향이 있기 때문에 큐에 넣지 않는다.
+	if (NewPlayer->PlayerState)
 	{
-		int32 NumberOfPlayers = GameState.Get()->PlayerArray.Num();
+		m_Reservations.Remove(NewPlayer->PlayerState->GetUniqueId().ToString());
+	}
+
+	// 이동이 끝난 직후에는 PostLogin이 한 프레임에 몰린다.
+	// 플레이어마다 바로 처리하지 않고 큐에 넣어서 틱마다 예산만큼 처리
+	m_JoinQueue.Add(NewPlayer);
+	m_BurstPeakDepth = FMath::Max(m_BurstPeakDepth, m_JoinQueue.Num());
+	SET_DWORD_STAT(STAT_LobbyJoinQueueDepth, m_JoinQueue.Num());
+
+	SetActorTickEnabled(true);
+}
+
+void ALobbyGameMode::ProcessJoinQueue()
+{
+	if (m_JoinQueue.Num() == 0)
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_LobbyProcessJoinQueue);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double Budget = JoinProcessingBudgetMs / 1000.0;
+
+	int32 NumProcessed = 0;
+	do
+	{
+		// 큐에서 기다리는 동안 나간 플레이어는 건너뛴다.
+		if (APlayerController* NewPlayer = m_JoinQueue[NumProcessed].Get())
+		{
+			InitializeJoinedPlayer(NewPlayer);
+		}
+
+		++NumProcessed;
+	}
+	while (NumProcessed < m_JoinQueue.Num() && FPlatformTime::Seconds() - StartTime < Budget);
+
+	m_JoinQueue.RemoveAt(0, NumProcessed, false);
+
+	// 플레이어 수와 승계 목록은 마지막 상태만 의미가 있어서 프레임마다 한번만 갱신
+	if (GameState)
+	{
+		const int32 NumberOfPlayers = GameState.Get()->PlayerArray.Num();
 
 		if (GEngine)
 		{
@@ -23,20 +309,50 @@ void ALobbyGameMode::PostLogin(APlayerController* NewPlayer)
 				FColor::Yellow,
 				FString::Printf(TEXT("Players in game : %d"), NumberOfPlayers)
 			);
+		}
 
-			APlayerState* PlayerState = NewPlayer->GetPlayerState<APlayerState>();
+		UpdateSessionOccupancy(NumberOfPlayers);
+		UpdateHostSuccession();
+	}
 
-			if (PlayerState)
-			{
-				FString PlayerName = PlayerState->GetPlayerName();
-				GEngine->AddOnScreenDebugMessage(
-					-1,
-					60.f,
-					FColor::Cyan,
-					FString::Printf(TEXT("%s has joined the game!"), *PlayerName)
-				);
-			}
-		}
+	const double FrameMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	SET_FLOAT_STAT(STAT_LobbyJoinQueueFrameMs, FrameMs);
+	SET_DWORD_STAT(STAT_LobbyJoinQueueDepth, m_JoinQueue.Num());
+
+	m_BurstProcessed += NumProcessed;
+	++m_BurstFrames;
+	m_BurstMaxFrameMs = FMath::Max(m_BurstMaxFrameMs, FrameMs);
+
+	if (m_JoinQueue.Num() > 0)
+		return;
+
+	if (m_BurstProcessed > 1)
+	{
+		UE_LOG(LogGameMode, Log, TEXT("Processed %d joins over %d frame(s), peak queue depth %d, max frame cost %.2fms"),
+			m_BurstProcessed, m_BurstFrames, m_BurstPeakDepth, m_BurstMaxFrameMs);
+	}
+
+	m_BurstProcessed = 0;
+	m_BurstFrames = 0;
+	m_BurstPeakDepth = 0;
+	m_BurstMaxFrameMs = 0.0;
+
+	SetActorTickEnabled(false);
+}
+
+void ALobbyGameMode::InitializeJoinedPlayer(APlayerController* NewPlayer)
+{
+	APlayerState* PlayerState = NewPlayer->GetPlayerState<APlayerState>();
+
+	if (GEngine && PlayerState)
+	{
+		FString PlayerName = PlayerState->GetPlayerName();
+		GEngine->AddOnScreenDebugMessage(
+			-1,
+			60.f,
+			FColor::Cyan,
+			FString::Printf(TEXT("%s has joined the game!"), *PlayerName)
+		);
 	}
 }
 
@@ -44,6 +360,9 @@ void ALobbyGameMode::Logout(AController* Exiting)
 {
 	Super::Logout(Exiting);
 
+	// 초기화 전에 나갔다면 환영 메시지를 보내지 않는다.
+	m_JoinQueue.Remove(Cast<APlayerController>(Exiting));
+
 	APlayerState* PlayerState = Exiting->GetPlayerState<APlayerState>();
 
 	if (PlayerState)
@@ -64,5 +383,56 @@ void ALobbyGameMode::Logout(AController* Exiting)
 			FColor::Cyan,
 			FString::Printf(TEXT("%s has exited the game!"), *PlayerName)
 		);
+
+		// Logout 시점에는 아직 PlayerArray에 나가는 플레이어가 남아있다.
+		UpdateSessionOccupancy(NumberOfPlayers - 1);
+		UpdateHostSuccession(Exiting);
+	}
+}
+
+void ALobbyGameMode::UpdateSessionOccupancy(int32 NumberOfPlayers)
+{
+	UGameInstance* GameInstance = GetGameInstance();
+
+	if (GameInstance)
+	{
+		UMultiplayerSessionsSubsystem* Subsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
+
+		if (Subsystem)
+		{
+			// 예약된 자리도 찬 것으로 광고
+			Subsystem->UpdateSessionOccupancy(NumberOfPlayers + m_Reservations.Num());
+		}
+	}
+}
+
+void ALobbyGameMode::UpdateHostSuccession(AController* Exiting)
+{
+	ALobbyGameState* LobbyGameState = GetGameState<ALobbyGameState>();
+
+	if (LobbyGameState == nullptr)
+		return;
+
+	// PlayerArray는 참가한 순서대로 들어있다.
+	// 호스트 자신과 나가는 플레이어는 후보에서 제외
+	TArray<FMultiplayerHostSuccessor> Successors;
+
+	for (APlayerState* PlayerState : LobbyGameState->PlayerArray)
+	{
+		APlayerController* PlayerController = PlayerState ? Cast<APlayerController>(PlayerState->GetOwner()) : nullptr;
+
+		if (PlayerController == nullptr || PlayerController == Exiting || PlayerController->IsLocalController())
+			continue;
+
+		FMultiplayerHostSuccessor Successor;
+		Successor.PlayerId = PlayerState->GetUniqueId().ToString();
+		Successor.ConnectAddress = UMultiplayerSessionsSubsystem::GetSuccessorConnectAddress(PlayerController);
+
+		if (!Successor.ConnectAddress.IsEmpty())
+		{
+			Successors.Add(Successor);
+		}
 	}
+
+	LobbyGameState->SetHostSuccession(Successors);
 }
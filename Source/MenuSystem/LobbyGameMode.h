@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "MultiplayerSessionTypes.h"
 #include "LobbyGameMode.generated.h"
 
 /**
@@ -15,6 +16,75 @@ class MENUSYSTEM_API ALobbyGameMode : public AGameModeBase
 	GENERATED_BODY()
 	
 public:
+	ALobbyGameMode();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	// 맵을 불러오기 전에 입장을 판단한다. 거절하면 클라이언트는 이유를 받고 바로 다른 세션을 시도
+	virtual void PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage) override;
+	// 예약만 바로 정리하고 나머지 초기화는 참가 큐에 넣어서 여러 프레임에 나눠 처리한다.
 	virtual void PostLogin(APlayerController* NewPlayer) override;
 	virtual void Logout(AController* Exiting) override;
+
+	// 플레이어 아이디는 FUniqueNetIdRepl::ToString
+	void BanPlayer(const FString& PlayerId);
+	void UnbanPlayer(const FString& PlayerId);
+	// 예약된 플레이어는 자리를 미리 차지하고 로비가 가득 차도 들어올 수 있다.
+	// ReservationLifetime 안에 들어오지 않으면 자리를 돌려준다.
+	void AddReservation(const FString& PlayerId);
+	void RemoveReservation(const FString& PlayerId);
+
+protected:
+	// 켜져 있으면 예약된 플레이어만 들어올 수 있다.
+	// 세션 아이디로 찾지 못하는 백엔드에서 재시작한 뒤 Rejoin은 세션 참가와 예약 없이 주소로 바로 접속하기 때문에 막힌다.
+	UPROPERTY(EditDefaultsOnly, Category = "Admission")
+	bool bRequireReservation{ false };
+
+	// 예약 비콘으로 잡은 자리를 유지하는 시간. 맵 로딩 시간보다 넉넉하게
+	UPROPERTY(EditDefaultsOnly, Category = "Admission")
+	float ReservationLifetime{ 30.f };
+
+	// 한 프레임에 참가 처리에 쓰는 시간 (ms). 넘으면 남은 플레이어는 다음 프레임에 처리
+	// 예산과 상관없이 프레임마다 최소 한명은 처리한다.
+	UPROPERTY(EditDefaultsOnly, Category = "Join")
+	float JoinProcessingBudgetMs{ 1.f };
+
+	// 연결마다 RTT, 손실, 포화를 샘플링해서 CSV와 트레이스로 내보낸다.
+	UPROPERTY(VisibleAnywhere, Category = "Net")
+	class UMultiplayerNetHealthComponent* NetHealth;
+
+private:
+	// BuildUniqueId가 INDEX_NONE이면 빌드는 확인하지 않는다.
+	// 예약 요청은 아직 예약이 없는 것이 당연하기 때문에 bRequireReservation을 보지 않는다.
+	EMultiplayerAdmissionResult CheckAdmission(const TArray<FString>& PlayerIds, int32 BuildUniqueId, bool bIsReservationRequest) const;
+	// 예약 비콘으로 들어온 요청. 전부 들어갈 수 있을때만 한번에 예약한다.
+	EMultiplayerAdmissionResult HandleReservationRequest(const TArray<FString>& PlayerIds, int32 BuildUniqueId);
+	// 만료된 예약이 있으면 인원 광고를 다시 한다.
+	void RemoveExpiredReservations();
+
+	// 현재 인원을 세션 광고 정보에 반영
+	void UpdateSessionOccupancy(int32 NumberOfPlayers);
+	// 참가 순서대로 호스트 승계 목록을 만들어 복제
+	// Logout에서는 나가는 플레이어를 제외해야 하기 때문에 Exiting을 넘긴다.
+	void UpdateHostSuccession(AController* Exiting = nullptr);
+
+	// 참가 큐를 예산 안에서 처리. 인원 광고와 승계 목록은 프레임마다 한번만 갱신한다.
+	void ProcessJoinQueue();
+	// 플레이어 한명의 초기화. 환영 메시지처럼 플레이어마다 해야 하는 일
+	void InitializeJoinedPlayer(APlayerController* NewPlayer);
+
+	TSet<FString> m_BannedPlayerIds;
+	// 아직 로그인하지 않은 예약과 만료 시간. PostLogin에서 지운다.
+	TMap<FString, double> m_Reservations;
+	FTimerHandle m_ReservationExpiryTimerHandle;
+
+	// 초기화를 기다리는 플레이어. 들어온 순서대로 처리
+	TArray<TWeakObjectPtr<APlayerController>> m_JoinQueue;
+	// 큐가 비기 전까지의 기록. 몰려서 들어온 참가가 다 처리되면 로그로 남긴다.
+	int32 m_BurstProcessed{ 0 };
+	int32 m_BurstFrames{ 0 };
+	int32 m_BurstPeakDepth{ 0 };
+	double m_BurstMaxFrameMs{ 0.0 };
 };
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LobbyGameState.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "Net/UnrealNetwork.h"
+
+void ALobbyGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ALobbyGameState, m_HostSuccession);
+}
+
+void ALobbyGameState::SetHostSuccession(const TArray<FMultiplayerHostSuccessor>& Successors)
+{
+	m_HostSuccession = Successors;
+}
+
+void ALobbyGameState::OnRep_HostSuccession()
+{
+	UGameInstance* GameInstance = GetGameInstance();
+
+	if (GameInstance)
+	{
+		UMultiplayerSessionsSubsystem* Subsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
+
+		if (Subsystem)
+		{
+			Subsystem->SetHostSuccession(m_HostSuccession);
+		}
+	}
+}
+
+void ALobbyGameState::MulticastHostLeaving_Implementation()
+{
+	if (HasAuthority())
+		return;
+
+	UGameInstance* GameInstance = GetGameInstance();
+	UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+
+	if (Subsystem)
+	{
+		Subsystem->NotifyHostLeaving();
+	}
+}
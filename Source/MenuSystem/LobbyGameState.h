@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "MultiplayerSessionTypes.h"
+#include "LobbyGameState.generated.h"
+
+/**
+ * 
+ */
+UCLASS()
+class MENUSYSTEM_API ALobbyGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// 서버에서 참가 순서가 바뀔때마다 호출
+	void SetHostSuccession(const TArray<FMultiplayerHostSuccessor>& Successors);
+
+	// 호스트가 로비를 닫기 직전에 보낸다. 이 알림을 받은 클라이언트는 끊긴 뒤에 호스트를 확인하지 않고 바로 승계
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastHostLeaving();
+
+protected:
+	UFUNCTION()
+	void OnRep_HostSuccession();
+
+private:
+	// 호스트가 나갔을때 새 호스트가 될 순서
+	// 클라이언트는 이 값을 받아서 세션 서브시스템에 넘겨둔다.
+	UPROPERTY(ReplicatedUsing = OnRep_HostSuccession)
+	TArray<FMultiplayerHostSuccessor> m_HostSuccession;
+};
@@ -9,6 +9,6 @@ public class MenuSystem : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay",
-		"OnlineSubsystemSteam", "OnlineSubsystem"});
+		"OnlineSubsystemSteam", "OnlineSubsystem", "MultiplayerSessions"});
 	}
 }
@@ -9,6 +9,8 @@
 #include "GameFramework/SpringArmComponent.h"
 #include "OnlineSubsystem.h"
 #include "OnlineSessionSettings.h"
+#include "MultiplayerSessionTypes.h"
+#include "MultiplayerSessionsSubsystem.h"
 
 //////////////////////////////////////////////////////////////////////////
 // AMenuSystemCharacter
@@ -150,7 +152,14 @@ void AMenuSystemCharacter::CreateGameSession()
 	// 키와 벨류로 세션 매치 타입을 지정
 	// EOnlineDataAdvertisementType 는 광고 옵션을 지정
 	// ViaOnlineServiceAndPing은 온라인 서비스와 핑으로 광고할 수 있다,
-	SessionSettings->Set(FName("MatchType"), FString("FreeForAll"), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	// 키 이름, 값 타입, 광고 방식은 플러그인의 세션 설정 키에 정의되어 있다.
+	// 매치 타입은 메뉴로 만든 세션과 같이 압축된 세션 정보로 광고한다. 문자열 키는 Custom일때만 쓰인다.
+	FMultiplayerSessionInfo SessionInfo;
+	SessionInfo.MatchType = EMultiplayerMatchType::FreeForAll;
+	SessionInfo.Write(*SessionSettings, FString("FreeForAll"));
+	// 플러그인의 검색은 빌드 아이디가 없는 세션을 다른 빌드로 보고 버린다. 서브시스템이 만드는 세션과 같은 값을 광고
+	SessionSettings->BuildUniqueId = UMultiplayerSessionsSubsystem::GetBuildUniqueId();
+	FMultiplayerSessionKeys::BuildId.Set(*SessionSettings, UMultiplayerSessionsSubsystem::GetBuildUniqueId());
 
 	// 로컬 플레이어를 얻어와 넷ID를 얻을 수 있다.
 	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
@@ -234,7 +243,7 @@ void AMenuSystemCharacter::OnCreateSessionComplete(FName SessionName, bool bWasS
 void AMenuSystemCharacter::OnFindSessionsComplete(bool bWasSuccessful)
 {
 	// 인터페이스가 유효한지
-	if (!m_OnlineSessionInterface.IsValid())
+	if (!m_OnlineSessionInterface.IsValid() || !m_SessionSearch.IsValid())
 		return;
 
 	for (auto Result : m_SessionSearch->SearchResults)
@@ -242,10 +251,8 @@ void AMenuSystemCharacter::OnFindSessionsComplete(bool bWasSuccessful)
 		// 세션 ID 문자열을 해당 함수로 얻을 수 있다.
 		FString Id = Result.GetSessionIdStr();
 		FString User = Result.Session.OwningUserName;
-		FString MatchType;
-
-		// 위에서 저장한 MatchType의 키값으로 저장된 Value값을 MatchType이란 FString변수에 저장
-		Result.Session.SessionSettings.Get(FName("MatchType"), MatchType);
+		// 압축된 세션 정보에서 매치 타입을 꺼낸다. Custom이면 따로 광고한 문자열
+		const FString MatchType = FMultiplayerSessionInfo::ReadMatchType(Result.Session.SessionSettings);
 
 		if (GEngine)
 		{
@@ -279,6 +286,9 @@ void AMenuSystemCharacter::OnFindSessionsComplete(bool bWasSuccessful)
 			m_OnlineSessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, Result);
 		}
 	}
+
+	// 참가 요청에 필요한 결과는 이미 넘겼기 때문에 폰마다 검색 결과를 들고 있지 않도록 바로 놓아준다.
+	m_SessionSearch.Reset();
 }
 
 void AMenuSystemCharacter::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
@@ -304,7 +314,9 @@ void AMenuSystemCharacter::OnJoinSessionComplete(FName SessionName, EOnJoinSessi
 		APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController();
 		if (PlayerController)
 		{
-			PlayerController->ClientTravel(Address, ETravelType::TRAVEL_Absolute);
+			// 세션 로비는 빌드 옵션이 없는 접속을 거절한다.
+			const FString URL = FString::Printf(TEXT("%s?%s=%d"), *Address, FMultiplayerAdmission::BuildOption, UMultiplayerSessionsSubsystem::GetBuildUniqueId());
+			PlayerController->ClientTravel(URL, ETravelType::TRAVEL_Absolute);
 		}
 	}
 }